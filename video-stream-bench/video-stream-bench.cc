@@ -0,0 +1,347 @@
+// 映像ストリームシミュレーションの回帰ベンチマーク
+//
+// 固定シードの参照シナリオ（A-MPDU x EDCA の4通り @20m と高負荷の長時間シナリオ）を
+// video-stream-simulation の実行ファイルで順に実行し、以下を記録する。
+//   - 実時間（repeat 回のうち最小値）
+//   - 実行イベント数
+//   - 最大常駐メモリ (peak RSS)
+//   - 出力ファイルの総バイト数
+//   - 結果 CSV のダイジェスト（FNV-1a 64bit）
+// 基準値ファイル (golden.csv) と比較し、結果が変わった場合、または実時間・メモリが
+// 閾値を超えて悪化した場合は非ゼロで終了する。基準値のないシナリオも
+// --allowMissingGolden=1 を付けない限り失敗とする（基準値の入れ忘れでゲートが素通りしないように）。
+//
+// 実行例:
+//   ./ns3 run "video-stream-bench --threshold=0.15"
+//   ./ns3 run "video-stream-bench --updateGolden=1"   # 基準値の更新（続けて上の実行で PASSED を確認してからコミット）
+
+#include "ns3/core-module.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+// 参照シナリオ
+struct BenchScenario {
+    std::string name;
+    std::vector<std::string> args;
+};
+
+// 1シナリオの計測結果
+struct BenchResult {
+    double wallTime;       // 実時間 (秒)
+    uint64_t events;       // 実行イベント数
+    long peakRssKb;        // 最大常駐メモリ (KB)
+    uint64_t outputBytes;  // 出力ファイルの総バイト数
+    std::string digest;    // 結果 CSV のダイジェスト
+};
+
+static std::vector<BenchScenario> GetReferenceScenarios() {
+    std::vector<BenchScenario> scenarios;
+    for (int ampdu = 0; ampdu <= 1; ampdu++) {
+        for (int edca = 0; edca <= 1; edca++) {
+            std::string name = std::string("ampdu_") + (ampdu ? "on" : "off") +
+                               "_edca_" + (edca ? "on" : "off") + "_d20m";
+            scenarios.push_back({name, {"--ampdu=" + std::to_string(ampdu),
+                                        "--edca=" + std::to_string(edca),
+                                        "--distance=20",
+                                        "--simTime=10"}});
+        }
+    }
+    // 高負荷: 8 STA + 背景負荷, 30 秒
+    scenarios.push_back({"high_load_8sta_30s", {"--ampdu=1",
+                                                "--edca=1",
+                                                "--distance=20",
+                                                "--stasPerBss=8",
+                                                "--bgLoad=20",
+                                                "--simTime=30"}});
+    return scenarios;
+}
+
+// FNV-1a 64bit ハッシュをファイル内容で更新
+static uint64_t HashBytes(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t HashFile(const std::filesystem::path& path, uint64_t hash) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> buffer(1 << 16);
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        hash = HashBytes(buffer.data(), in.gcount(), hash);
+    }
+    return hash;
+}
+
+// 出力ディレクトリ内の結果 CSV のダイジェストと総バイト数を計算
+// bss_scaling.csv は実時間を含むため対象外
+static std::string ComputeOutputDigest(const std::filesystem::path& dir, uint64_t* totalBytes) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    uint64_t hash = 14695981039346656037ULL;
+    *totalBytes = 0;
+    for (const auto& file : files) {
+        std::string name = file.filename().string();
+        if (name == "stdout.txt") {
+            continue;
+        }
+        *totalBytes += std::filesystem::file_size(file);
+        if (file.extension() != ".csv" || name == "bss_scaling.csv") {
+            continue;
+        }
+        hash = HashBytes(name.data(), name.size(), hash);
+        hash = HashFile(file, hash);
+    }
+
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
+// シナリオを子プロセスで実行し、実時間・peak RSS・イベント数を計測
+static bool RunScenario(const std::string& simBinary, const BenchScenario& scenario,
+                        const std::filesystem::path& outDir, BenchResult& result) {
+    std::filesystem::remove_all(outDir);
+    std::filesystem::create_directories(outDir);
+    std::string stdoutPath = (outDir / "stdout.txt").string();
+
+    std::vector<std::string> args = scenario.args;
+    args.push_back("--outputDir=" + outDir.string());
+    args.push_back("--RngSeed=1");
+    args.push_back("--RngRun=1");
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(simBinary.c_str()));
+    for (auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "fork failed" << std::endl;
+        return false;
+    }
+    if (pid == 0) {
+        int fd = open(stdoutPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            close(fd);
+        }
+        execv(simBinary.c_str(), argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        std::cerr << "wait4 failed" << std::endl;
+        return false;
+    }
+    result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Scenario " << scenario.name << " exited abnormally (status " << status << ")" << std::endl;
+        return false;
+    }
+    result.peakRssKb = usage.ru_maxrss;
+
+    // シナリオの標準出力からイベント数を取得 ("Wall Clock: X s, Events: N")
+    result.events = 0;
+    std::ifstream out(stdoutPath);
+    std::string line;
+    while (std::getline(out, line)) {
+        size_t pos = line.find("Events: ");
+        if (pos != std::string::npos) {
+            result.events = std::stoull(line.substr(pos + 8));
+        }
+    }
+
+    result.digest = ComputeOutputDigest(outDir, &result.outputBytes);
+    return true;
+}
+
+// 基準値ファイルの読み込み（'#' で始まる行はコメント）
+static std::map<std::string, BenchResult> LoadGolden(const std::string& path) {
+    std::map<std::string, BenchResult> golden;
+    std::ifstream in(path);
+    std::string line;
+    bool header = true;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (header) {
+            header = false;
+            continue;
+        }
+        std::stringstream ss(line);
+        std::string name, wallTime, events, peakRss, outputBytes, digest;
+        std::getline(ss, name, ',');
+        std::getline(ss, wallTime, ',');
+        std::getline(ss, events, ',');
+        std::getline(ss, peakRss, ',');
+        std::getline(ss, outputBytes, ',');
+        std::getline(ss, digest, ',');
+        golden[name] = {std::stod(wallTime), std::stoull(events), std::stol(peakRss),
+                        std::stoull(outputBytes), digest};
+    }
+    return golden;
+}
+
+static void SaveGolden(const std::string& path, const std::vector<BenchScenario>& scenarios,
+                       const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "# Regression baselines for video-stream-bench (regenerate with --updateGolden=1)" << std::endl;
+    out << "Scenario,WallTime(s),Events,PeakRss(KB),OutputBytes,Digest" << std::endl;
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        out << scenarios[i].name << ","
+            << std::fixed << std::setprecision(3) << results[i].wallTime << ","
+            << results[i].events << ","
+            << results[i].peakRssKb << ","
+            << results[i].outputBytes << ","
+            << results[i].digest << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string simBinary = "build/scratch/video-stream/ns3.46.1-video-stream-simulation-default";
+    std::string goldenFile = "scratch/video-stream-bench/golden.csv";
+    std::string outputDir = "/tmp/video-stream-bench";
+    double threshold = 0.15;
+    uint32_t repeat = 3;
+    bool updateGolden = false;
+    bool allowMissingGolden = false;
+
+    CommandLine cmd;
+    cmd.AddValue("simBinary", "Path to the video-stream-simulation executable", simBinary);
+    cmd.AddValue("goldenFile", "Golden baseline CSV", goldenFile);
+    cmd.AddValue("outputDir", "Working directory for scenario outputs", outputDir);
+    cmd.AddValue("threshold", "Allowed relative regression of wall time and peak RSS", threshold);
+    cmd.AddValue("repeat", "Number of runs per scenario (minimum wall time is reported)", repeat);
+    cmd.AddValue("updateGolden", "Overwrite the golden file with the measured values", updateGolden);
+    cmd.AddValue("allowMissingGolden", "Do not fail scenarios that have no golden baseline", allowMissingGolden);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(repeat == 0, "repeat must be at least 1");
+
+    std::vector<BenchScenario> scenarios = GetReferenceScenarios();
+    std::map<std::string, BenchResult> golden = LoadGolden(goldenFile);
+    std::vector<BenchResult> results;
+    bool failed = false;
+
+    std::cout << std::left << std::setw(22) << "Scenario"
+              << std::right << std::setw(10) << "Wall(s)"
+              << std::setw(12) << "Events"
+              << std::setw(12) << "RSS(KB)"
+              << std::setw(12) << "Bytes"
+              << "  Digest            Status" << std::endl;
+
+    for (const auto& scenario : scenarios) {
+        BenchResult best;
+        bool ok = true;
+        for (uint32_t r = 0; r < repeat && ok; r++) {
+            BenchResult result;
+            ok = RunScenario(simBinary, scenario, std::filesystem::path(outputDir) / scenario.name, result);
+            if (!ok) {
+                break;
+            }
+            if (r == 0) {
+                best = result;
+            } else {
+                // 固定シードなので結果は毎回一致するはず
+                if (result.digest != best.digest) {
+                    std::cerr << scenario.name << ": output differs between repeats" << std::endl;
+                    failed = true;
+                }
+                best.wallTime = std::min(best.wallTime, result.wallTime);
+                best.peakRssKb = std::min(best.peakRssKb, result.peakRssKb);
+            }
+        }
+        if (!ok) {
+            failed = true;
+            results.push_back({0.0, 0, 0, 0, "-"});
+            std::cout << std::left << std::setw(22) << scenario.name << "  RUN_FAILED" << std::endl;
+            continue;
+        }
+        results.push_back(best);
+
+        std::string status = "OK";
+        auto it = golden.find(scenario.name);
+        if (updateGolden) {
+            status = "UPDATED";
+        } else if (it == golden.end()) {
+            status = "NO_GOLDEN";
+            if (!allowMissingGolden) {
+                failed = true;
+            }
+        } else {
+            const BenchResult& ref = it->second;
+            if (best.digest != ref.digest || best.events != ref.events) {
+                status = "RESULT_CHANGED";
+                failed = true;
+            } else if (best.wallTime > ref.wallTime * (1.0 + threshold)) {
+                status = "SLOWER";
+                failed = true;
+            } else if (best.peakRssKb > ref.peakRssKb * (1.0 + threshold)) {
+                status = "MORE_MEMORY";
+                failed = true;
+            }
+        }
+
+        std::cout << std::left << std::setw(22) << scenario.name
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(10) << best.wallTime
+                  << std::setw(12) << best.events
+                  << std::setw(12) << best.peakRssKb
+                  << std::setw(12) << best.outputBytes
+                  << "  " << best.digest << "  " << status;
+        if (!updateGolden && it != golden.end()) {
+            std::cout << " (wall " << std::showpos << std::setprecision(1)
+                      << (best.wallTime / it->second.wallTime - 1.0) * 100.0 << "%"
+                      << std::noshowpos << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    if (updateGolden) {
+        // 失敗したシナリオや繰り返しで結果が一致しないシナリオがあれば、既存の基準値を残す
+        if (failed) {
+            std::cout << "Golden baselines not updated: a scenario failed or was not reproducible" << std::endl;
+            return 1;
+        }
+        SaveGolden(goldenFile, scenarios, results);
+        std::cout << "Golden baselines written to " << goldenFile << std::endl;
+        return failed ? 1 : 0;
+    }
+
+    if (golden.empty() && !allowMissingGolden) {
+        std::cout << "No golden baselines in " << goldenFile << "; record them with --updateGolden=1" << std::endl;
+    }
+    std::cout << (failed ? "BENCHMARK FAILED" : "BENCHMARK PASSED") << std::endl;
+    return failed ? 1 : 0;
+}
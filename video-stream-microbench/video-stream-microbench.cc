@@ -0,0 +1,453 @@
+// 映像ストリームシミュレーションの毎パケット処理のマイクロベンチマーク
+//
+// シミュレーションを走らせずに、以下のホットパスを固定の合成入力で直接呼び出し、
+// 1 回あたりの時間とヒープ確保回数（allocs/iter）を計測する。
+//   - VideoFrameTag の Serialize / Deserialize
+//   - VideoFrameReceiverApplication::HandleRead（合成パケットを返すソケット経由）
+//   - VideoFrameReceiverApplication::LogPacket（/dev/null へのパケットログ）
+//   - VideoFrameReceiverApplication::CalculateStatistics（10^6 フレーム）
+//   - PhyRxTrace（A-MPDU / 非 A-MPDU の MPDU）
+// ヒープ確保回数はグローバルな operator new（配列・nothrow・アラインメント指定を含む）の呼び出しを数える。
+// malloc を直接呼ぶ確保（C ライブラリ内部など）は含まない。
+//
+// 実行例:
+//   ./ns3 run "video-stream-microbench --benchmark_filter=HandleRead"
+//   ./ns3 run "video-stream-microbench --benchmark_format=csv" > microbench.csv
+
+#include "../video-stream/log.h"
+#include "../video-stream/video-frame.h"
+
+#include "ns3/ampdu-subframe-header.h"
+#include "ns3/wifi-mac-header.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// ヒープ確保回数（スカラー・配列・nothrow・アラインメント指定のすべての operator new を数える）
+static std::atomic<uint64_t> g_allocations{0};
+
+static void* CountedAlloc(std::size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* CountedAlignedAlloc(std::size_t size, std::align_val_t alignment) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc はサイズがアラインメントの倍数である必要がある
+    std::size_t rounded = ((size == 0 ? 1 : size) + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = CountedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = CountedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = CountedAlignedAlloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void* p = CountedAlignedAlloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedAlignedAlloc(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+// ベンチマーク区間のヒープ確保回数を 1 反復あたりのカウンタとして記録
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State& state)
+        : m_state(state), m_start(g_allocations.load(std::memory_order_relaxed)) {}
+
+    ~AllocationCounter() {
+        double allocations = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - m_start);
+        m_state.counters["allocs/iter"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& m_state;
+    uint64_t m_start;
+};
+
+// 受信アプリの非公開メンバへのアクセス（video-frame.h で friend 宣言）
+class VideoFrameReceiverBenchAccess {
+public:
+    static void HandleRead(Ptr<VideoFrameReceiverApplication> receiver, Ptr<Socket> socket) {
+        receiver->HandleRead(socket);
+    }
+
+    static void LogPacket(Ptr<VideoFrameReceiverApplication> receiver, uint32_t frameId, uint32_t frameType,
+                          uint32_t packetIndex, uint32_t totalPackets, double txTime, double rxTime,
+                          int32_t fwdRef, int32_t bwdRef, double sendTime) {
+        receiver->LogPacket(frameId, frameType, packetIndex, totalPackets, txTime, rxTime, fwdRef, bwdRef, sendTime);
+    }
+
+    static void CalculateStatistics(Ptr<VideoFrameReceiverApplication> receiver) {
+        receiver->CalculateStatistics();
+    }
+
+    static FrameStatsMap& GetFrameStats(Ptr<VideoFrameReceiverApplication> receiver) {
+        return receiver->m_frameStats;
+    }
+
+    static void Reset(Ptr<VideoFrameReceiverApplication> receiver) {
+        receiver->m_frameStats.clear();
+        receiver->m_pendingDecode.clear();
+        receiver->m_pendingIntra = 0;
+        receiver->m_decodeNext = 0;
+        receiver->m_liveLatencies.clear();
+        receiver->m_decoderFree = 0.0;
+    }
+};
+
+// BenchSocket: 事前に用意したパケット列を RecvFrom で順に返すだけのソケット
+class BenchSocket : public Socket {
+public:
+    using Socket::Recv;
+    using Socket::RecvFrom;
+    using Socket::Send;
+
+    BenchSocket() : m_packets(nullptr), m_next(0), m_end(0), m_from(InetSocketAddress(Ipv4Address("10.1.1.1"), 49153)) {}
+
+    // packets[begin, end) を次の HandleRead で返す
+    void SetBatch(const std::vector<Ptr<Packet>>* packets, size_t begin, size_t end) {
+        m_packets = packets;
+        m_next = begin;
+        m_end = end;
+    }
+
+    Ptr<Packet> RecvFrom(uint32_t maxSize, uint32_t flags, Address& fromAddress) override {
+        if (m_packets == nullptr || m_next >= m_end) {
+            return nullptr;
+        }
+        fromAddress = m_from;
+        return (*m_packets)[m_next++];
+    }
+
+    Ptr<Packet> Recv(uint32_t maxSize, uint32_t flags) override {
+        Address from;
+        return RecvFrom(maxSize, flags, from);
+    }
+
+    SocketErrno GetErrno() const override { return ERROR_NOTERROR; }
+    SocketType GetSocketType() const override { return NS3_SOCK_DGRAM; }
+    Ptr<Node> GetNode() const override { return nullptr; }
+    int Bind(const Address& address) override { return 0; }
+    int Bind() override { return 0; }
+    int Bind6() override { return 0; }
+    int Close() override { return 0; }
+    int ShutdownSend() override { return 0; }
+    int ShutdownRecv() override { return 0; }
+    int Connect(const Address& address) override { return 0; }
+    int Listen() override { return 0; }
+    uint32_t GetTxAvailable() const override { return 0; }
+    int Send(Ptr<Packet> p, uint32_t flags) override { return 0; }
+    int SendTo(Ptr<Packet> p, uint32_t flags, const Address& toAddress) override { return 0; }
+    uint32_t GetRxAvailable() const override { return m_end - m_next; }
+    int GetSockName(Address& address) const override { return 0; }
+    int GetPeerName(Address& address) const override {
+        address = m_from;
+        return 0;
+    }
+    bool SetAllowBroadcast(bool allowBroadcast) override { return false; }
+    bool GetAllowBroadcast() const override { return false; }
+
+private:
+    const std::vector<Ptr<Packet>>* m_packets;
+    size_t m_next;
+    size_t m_end;
+    Address m_from;
+};
+
+namespace {
+
+const uint32_t PACKET_SIZE = 1200;
+const double FRAME_INTERVAL = 0.033;
+const uint32_t GOP_SIZE = 12;
+
+Ptr<GopStructure> MakeGop() {
+    return Create<GopStructure>(GOP_IBBP, GOP_SIZE, 2, false);
+}
+
+// 既定の合成フレームと同じ I=50 / P=30 / B=5 パケット
+uint32_t FramePackets(uint32_t frameType) {
+    const uint32_t packets[] = {50, 30, 5};
+    return packets[frameType];
+}
+
+VideoFrameTag MakeTag(Ptr<GopStructure> gop, uint32_t frameId, uint32_t packetIndex) {
+    uint32_t frameType = gop->GetFrameType(frameId);
+    VideoFrameTag tag(frameId, frameType, packetIndex, FramePackets(frameType), gop->GetForwardRef(frameId),
+                      gop->GetBackwardRef(frameId), frameId * FRAME_INTERVAL);
+    tag.SetLayerInfo(0, 1, FramePackets(frameType));
+    tag.SetSendTime(frameId * FRAME_INTERVAL + packetIndex * 10e-6);
+    tag.SetCaptureTime(frameId * FRAME_INTERVAL);
+    tag.SetSliceInfo(0, 1, FramePackets(frameType));
+    return tag;
+}
+
+// frames フレーム分の受信パケット（表示順、lossEvery フレームごとに 1 パケット欠落）
+// frameStarts[f] はフレーム f の先頭パケットの位置（末尾に総数）
+std::vector<Ptr<Packet>> MakeFramePackets(Ptr<GopStructure> gop, uint32_t frames, uint32_t lossEvery,
+                                          std::vector<size_t>& frameStarts) {
+    std::vector<Ptr<Packet>> packets;
+    frameStarts.clear();
+    for (uint32_t f = 0; f < frames; f++) {
+        frameStarts.push_back(packets.size());
+        uint32_t total = FramePackets(gop->GetFrameType(f));
+        for (uint32_t i = 0; i < total; i++) {
+            if (lossEvery > 0 && f % lossEvery == lossEvery - 1 && i == total / 2) {
+                continue;
+            }
+            Ptr<Packet> packet = Create<Packet>(PACKET_SIZE);
+            packet->AddPacketTag(MakeTag(gop, f, i));
+            packets.push_back(packet);
+        }
+    }
+    frameStarts.push_back(packets.size());
+    return packets;
+}
+
+}
+
+static void BM_VideoFrameTagSerialize(benchmark::State& state) {
+    Ptr<GopStructure> gop = MakeGop();
+    VideoFrameTag tag = MakeTag(gop, 13, 7);
+    std::vector<uint8_t> storage(tag.GetSerializedSize());
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        TagBuffer buffer(storage.data(), storage.data() + storage.size());
+        tag.Serialize(buffer);
+        benchmark::DoNotOptimize(storage.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_VideoFrameTagSerialize);
+
+static void BM_VideoFrameTagDeserialize(benchmark::State& state) {
+    Ptr<GopStructure> gop = MakeGop();
+    VideoFrameTag source = MakeTag(gop, 13, 7);
+    std::vector<uint8_t> storage(source.GetSerializedSize());
+    TagBuffer writer(storage.data(), storage.data() + storage.size());
+    source.Serialize(writer);
+    VideoFrameTag tag;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        TagBuffer buffer(storage.data(), storage.data() + storage.size());
+        tag.Deserialize(buffer);
+        benchmark::DoNotOptimize(tag);
+    }
+}
+BENCHMARK(BM_VideoFrameTagDeserialize);
+
+// 1 反復 = 1 フレーム分のパケット（RecvFrom のループ 1 回）
+// フレームの統計が溜まり続けるため、用意したフレームを使い切ったら計測を止めて状態を戻す
+static void BM_HandleRead(benchmark::State& state) {
+    const uint32_t frames = 4096;
+    Ptr<GopStructure> gop = MakeGop();
+    std::vector<size_t> frameStarts;
+    std::vector<Ptr<Packet>> packets = MakeFramePackets(gop, frames, static_cast<uint32_t>(state.range(0)), frameStarts);
+
+    Ptr<VideoFrameReceiverApplication> receiver = CreateObject<VideoFrameReceiverApplication>();
+    receiver->SetGopStructure(gop);
+    Ptr<BenchSocket> socket = CreateObject<BenchSocket>();
+
+    uint32_t frame = 0;
+    uint64_t packetCount = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        if (frame == frames) {
+            state.PauseTiming();
+            VideoFrameReceiverBenchAccess::Reset(receiver);
+            frame = 0;
+            state.ResumeTiming();
+        }
+        socket->SetBatch(&packets, frameStarts[frame], frameStarts[frame + 1]);
+        VideoFrameReceiverBenchAccess::HandleRead(receiver, socket);
+        packetCount += frameStarts[frame + 1] - frameStarts[frame];
+        frame++;
+    }
+    state.counters["packets/s"] = benchmark::Counter(static_cast<double>(packetCount), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_HandleRead)->Arg(0)->Arg(7)->ArgName("lossEvery");
+
+static void BM_LogPacket(benchmark::State& state) {
+    Ptr<VideoFrameReceiverApplication> receiver = CreateObject<VideoFrameReceiverApplication>();
+    receiver->SetPacketLogFile("/dev/null");
+    uint32_t packetIndex = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        VideoFrameReceiverBenchAccess::LogPacket(receiver, 1234, 1, packetIndex % 30, 30, 40.722000,
+                                                 40.731250 + packetIndex * 1e-6, 1233, -1, 40.722000 + (packetIndex % 30) * 1e-4);
+        packetIndex++;
+    }
+}
+BENCHMARK(BM_LogPacket);
+
+// 10^6 フレームの統計（GOP 1 周期分を HandleRead で受信し、そのフレームを複製して並べる）
+static void BM_CalculateStatistics(benchmark::State& state) {
+    const uint32_t frames = static_cast<uint32_t>(state.range(0));
+    const uint32_t lossEvery = 97;
+    Ptr<GopStructure> gop = MakeGop();
+
+    // 周期内の位置ごとに、無損失と 1 パケット欠落のフレームを用意
+    std::vector<FrameStatistics> clean;
+    std::vector<FrameStatistics> lossy;
+    for (uint32_t lossyPass = 0; lossyPass < 2; lossyPass++) {
+        Ptr<VideoFrameReceiverApplication> source = CreateObject<VideoFrameReceiverApplication>();
+        source->SetGopStructure(gop);
+        Ptr<BenchSocket> socket = CreateObject<BenchSocket>();
+        std::vector<size_t> frameStarts;
+        std::vector<Ptr<Packet>> packets = MakeFramePackets(gop, GOP_SIZE, lossyPass ? 1 : 0, frameStarts);
+        socket->SetBatch(&packets, 0, packets.size());
+        VideoFrameReceiverBenchAccess::HandleRead(source, socket);
+        for (auto& stat : VideoFrameReceiverBenchAccess::GetFrameStats(source)) {
+            (lossyPass ? lossy : clean).push_back(stat.second);
+        }
+    }
+
+    Ptr<VideoFrameReceiverApplication> receiver = CreateObject<VideoFrameReceiverApplication>();
+    receiver->SetGopStructure(gop);
+    FrameStatsMap& stats = VideoFrameReceiverBenchAccess::GetFrameStats(receiver);
+    for (uint32_t f = 0; f < frames; f++) {
+        FrameStatistics stat = (f % lossEvery == lossEvery - 1 ? lossy : clean)[f % GOP_SIZE];
+        double offset = (f - f % GOP_SIZE) * FRAME_INTERVAL;
+        stat.frameId = f;
+        stat.forwardRefFrameId = gop->GetForwardRef(f);
+        stat.backwardRefFrameId = gop->GetBackwardRef(f);
+        stat.transmissionStartTime += offset;
+        stat.captureTime += offset;
+        stat.firstPacketArrivalTime = stat.transmissionStartTime + 0.002;
+        stat.lastPacketArrivalTime = stat.transmissionStartTime + 0.004 + stat.totalPackets * 1e-4;
+        stat.decodeReadyTime = stat.decodeReadyTime >= 0.0 ? stat.lastPacketArrivalTime + 0.003 : -1.0;
+        stats.emplace_hint(stats.end(), f, std::move(stat));
+    }
+
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        VideoFrameReceiverBenchAccess::CalculateStatistics(receiver);
+        benchmark::ClobberMemory();
+    }
+    state.counters["frames/s"] =
+        benchmark::Counter(static_cast<double>(frames) * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CalculateStatistics)->Arg(1000000)->ArgName("frames")->Unit(benchmark::kMillisecond);
+
+// AP から届いた QoS データ MPDU（A-MPDU ではサブフレームヘッダ付き）
+static void BM_PhyRxTrace(benchmark::State& state) {
+    bool ampdu = state.range(0) != 0;
+    Ptr<GopStructure> gop = MakeGop();
+
+    Ptr<Packet> packet = Create<Packet>(PACKET_SIZE);
+    packet->AddPacketTag(MakeTag(gop, 13, 7));
+    WifiMacHeader hdr(WIFI_MAC_QOSDATA);
+    hdr.SetQosTid(3);
+    hdr.SetAddr1(Mac48Address("00:00:00:00:00:02"));
+    hdr.SetAddr2(Mac48Address("00:00:00:00:00:01"));
+    packet->AddHeader(hdr);
+
+    WifiTxVector txVector;
+    MpduInfo aMpdu = {NORMAL_MPDU, 0};
+    if (ampdu) {
+        AmpduSubframeHeader subHdr;
+        subHdr.SetLength(static_cast<uint16_t>(packet->GetSize()));
+        packet->AddHeader(subHdr);
+        txVector.SetAggregation(true);
+        aMpdu = {MIDDLE_MPDU_IN_AGGREGATE, 42};
+    }
+    SignalNoiseDbm signalNoise = {-45.0, -93.0};
+
+    AsciiTraceHelper asciiTraceHelper;
+    Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream("/dev/null");
+    const std::string context = "/NodeList/1/DeviceList/0/$ns3::WifiNetDevice/Phy/$ns3::WifiPhy/MonitorSnifferRx";
+
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        PhyRxTrace(stream, context, packet, 5180, txVector, aMpdu, signalNoise, SU_STA_ID);
+    }
+}
+BENCHMARK(BM_PhyRxTrace)->Arg(0)->Arg(1)->ArgName("ampdu");
+
+BENCHMARK_MAIN();
@@ -0,0 +1,439 @@
+#include "annexb-source.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("AnnexBSource");
+
+namespace {
+
+// RBSP ビットリーダー（エミュレーション防止バイト 0x03 を除去しながら先頭部分だけを読む）
+// スライスヘッダ・PPS の先頭数十バイトしか参照しないので固定長バッファで十分
+class RbspReader {
+public:
+    RbspReader(const uint8_t* data, uint32_t size) : m_len(0), m_bit(0) {
+        uint32_t zeros = 0;
+        for (uint32_t i = 0; i < size && m_len < sizeof(m_buf); i++) {
+            if (zeros >= 2 && data[i] == 0x03) {
+                zeros = 0;
+                continue;
+            }
+            zeros = (data[i] == 0) ? zeros + 1 : 0;
+            m_buf[m_len++] = data[i];
+        }
+    }
+
+    uint32_t ReadBit() {
+        if (m_bit >= m_len * 8) {
+            return 0;
+        }
+        uint32_t bit = (m_buf[m_bit >> 3] >> (7 - (m_bit & 7))) & 1;
+        m_bit++;
+        return bit;
+    }
+
+    uint32_t ReadBits(uint32_t n) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            value = (value << 1) | ReadBit();
+        }
+        return value;
+    }
+
+    // 符号なし指数ゴロム符号 ue(v)
+    uint32_t ReadUe() {
+        uint32_t leadingZeros = 0;
+        while (ReadBit() == 0) {
+            if (++leadingZeros >= 32) {
+                return 0;  // 壊れたビット列
+            }
+        }
+        return ((1u << leadingZeros) - 1) + ReadBits(leadingZeros);
+    }
+
+private:
+    uint8_t m_buf[64];
+    uint32_t m_len;
+    uint32_t m_bit;
+};
+
+}
+
+AnnexBSource::AnnexBSource()
+    : m_codec(CODEC_H264), m_fd(-1), m_data(nullptr), m_size(0), m_pos(0), m_firstNal(0),
+      m_hasPending(false), m_maxPayload(1400 - RTP_HEADER_SIZE), m_loop(true), m_auCount(0),
+      m_lastRef(-1), m_prevRef(-1) {
+    m_pending.data = nullptr;
+    m_pending.size = 0;
+    std::memset(m_extraSliceHeaderBits, 0, sizeof(m_extraSliceHeaderBits));
+}
+
+AnnexBSource::~AnnexBSource() {
+    Close();
+}
+
+bool AnnexBSource::Open(const std::string& path, const std::string& codec) {
+    Close();
+
+    if (codec == "h264") {
+        m_codec = CODEC_H264;
+    } else if (codec == "h265") {
+        m_codec = CODEC_H265;
+    } else if (codec == "auto") {
+        std::string ext = path.substr(path.find_last_of('.') + 1);
+        if (ext == "h265" || ext == "265" || ext == "hevc") {
+            m_codec = CODEC_H265;
+        } else {
+            m_codec = CODEC_H264;
+        }
+    } else {
+        NS_LOG_ERROR("Unknown codec: " << codec);
+        return false;
+    }
+
+    m_fd = open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        NS_LOG_ERROR("Failed to open " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(m_fd, &st) < 0 || st.st_size < 4) {
+        NS_LOG_ERROR("Bitstream is empty: " << path);
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+
+    void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (addr == MAP_FAILED) {
+        NS_LOG_ERROR("mmap failed for " << path << ": " << std::strerror(errno));
+        m_size = 0;
+        Close();
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(addr);
+    // 先頭から順に読むだけなので先読みを強める
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+
+    uint64_t first = FindStartCode(0);
+    if (first >= m_size) {
+        NS_LOG_ERROR("No Annex-B start code found in " << path);
+        Close();
+        return false;
+    }
+    m_firstNal = first + 3;
+    m_pos = m_firstNal;
+    m_hasPending = false;
+    m_auCount = 0;
+    m_lastRef = -1;
+    m_prevRef = -1;
+
+    NS_LOG_INFO("Opened " << (m_codec == CODEC_H264 ? "H.264" : "H.265") << " bitstream " << path
+                << " (" << m_size << " bytes)");
+    return true;
+}
+
+void AnnexBSource::Close() {
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+}
+
+void AnnexBSource::SetMaxPayloadSize(uint32_t size) {
+    NS_ABORT_MSG_IF(size < 64, "RTP payload size too small: " << size);
+    m_maxPayload = size;
+}
+
+void AnnexBSource::SetLoop(bool loop) {
+    m_loop = loop;
+}
+
+AnnexBCodec AnnexBSource::GetCodec() const {
+    return m_codec;
+}
+
+uint64_t AnnexBSource::GetFileSize() const {
+    return m_size;
+}
+
+uint64_t AnnexBSource::GetAccessUnitCount() const {
+    return m_auCount;
+}
+
+// from 以降で最初の 00 00 01 の位置を返す（見つからなければ m_size）
+uint64_t AnnexBSource::FindStartCode(uint64_t from) const {
+    const uint8_t* p = m_data;
+    uint64_t i = from;
+#ifdef __SSE2__
+    // 16 バイト分の候補位置について p[i]==0 && p[i+1]==0 && p[i+2]==1 を同時に判定
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    while (i + 18 <= m_size) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 2));
+        __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+                                    _mm_cmpeq_epi8(b2, one));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+        i += 16;
+    }
+#endif
+    for (; i + 2 < m_size; i++) {
+        if (p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1) {
+            return i;
+        }
+    }
+    return m_size;
+}
+
+// 次の NAL を読む（空の NAL は読み飛ばす）
+bool AnnexBSource::ReadNal(AnnexBNalUnit& nal) {
+    while (m_pos < m_size) {
+        uint64_t next = FindStartCode(m_pos);
+        uint64_t end = next;
+        // trailing_zero_8bits（4 バイトスタートコードの先頭 0 を含む）を除く
+        while (end > m_pos && m_data[end - 1] == 0) {
+            end--;
+        }
+        nal.data = m_data + m_pos;
+        nal.size = static_cast<uint32_t>(end - m_pos);
+        m_pos = (next < m_size) ? next + 3 : m_size;
+        if (nal.size > (m_codec == CODEC_H264 ? 1u : 2u)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AnnexBSource::PeekNal(AnnexBNalUnit& nal) {
+    if (!m_hasPending) {
+        if (!ReadNal(m_pending)) {
+            return false;
+        }
+        m_hasPending = true;
+    }
+    nal = m_pending;
+    return true;
+}
+
+bool AnnexBSource::IsVcl(const AnnexBNalUnit& nal) const {
+    if (m_codec == CODEC_H264) {
+        uint8_t type = nal.data[0] & 0x1f;
+        return type >= 1 && type <= 5;
+    }
+    uint8_t type = (nal.data[0] >> 1) & 0x3f;
+    return type < 32;
+}
+
+// 新しいアクセスユニットの先頭か（H.264 7.4.1.2.3 / H.265 7.4.2.4.4 の簡略版）
+bool AnnexBSource::StartsNewAccessUnit(const AnnexBNalUnit& nal, bool seenVcl) const {
+    if (!seenVcl) {
+        return false;
+    }
+    if (m_codec == CODEC_H264) {
+        uint8_t type = nal.data[0] & 0x1f;
+        if (type == 1 || type == 5) {
+            return (nal.data[1] & 0x80) != 0;  // first_mb_in_slice == 0
+        }
+        return type == 6 || type == 7 || type == 8 || type == 9 || (type >= 14 && type <= 18);
+    }
+    uint8_t type = (nal.data[0] >> 1) & 0x3f;
+    if (type < 32) {
+        return (nal.data[2] & 0x80) != 0;  // first_slice_segment_in_pic_flag
+    }
+    // VPS/SPS/PPS/AUD/PREFIX_SEI と予約タイプ（SUFFIX_SEI=40 は現在の AU に属する）
+    return (type >= 32 && type <= 39) || (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+}
+
+// H.265 PPS から num_extra_slice_header_bits を取得（スライスヘッダ解析に必要）
+void AnnexBSource::ParsePps(const AnnexBNalUnit& nal) {
+    RbspReader reader(nal.data + 2, nal.size - 2);
+    uint32_t ppsId = reader.ReadUe();
+    reader.ReadUe();   // pps_seq_parameter_set_id
+    reader.ReadBit();  // dependent_slice_segments_enabled_flag
+    reader.ReadBit();  // output_flag_present_flag
+    m_extraSliceHeaderBits[ppsId & 63] = reader.ReadBits(3);
+}
+
+// 先頭スライスのヘッダからフレームタイプと参照属性を取得
+void AnnexBSource::ParseSliceHeader(const AnnexBNalUnit& nal, AnnexBAccessUnit& au) {
+    if (m_codec == CODEC_H264) {
+        uint8_t refIdc = (nal.data[0] >> 5) & 0x03;
+        uint8_t type = nal.data[0] & 0x1f;
+        au.isIdr = (type == 5);
+        au.isReference = (refIdc != 0);
+
+        RbspReader reader(nal.data + 1, nal.size - 1);
+        reader.ReadUe();  // first_mb_in_slice
+        uint32_t sliceType = reader.ReadUe() % 5;
+        if (sliceType == 0 || sliceType == 3) {
+            au.frameType = 1;  // P / SP
+        } else if (sliceType == 1) {
+            au.frameType = 2;  // B
+        } else {
+            au.frameType = 0;  // I / SI
+        }
+        return;
+    }
+
+    uint8_t type = (nal.data[0] >> 1) & 0x3f;
+    au.isIdr = (type == 19 || type == 20);
+    // TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N などサブレイヤ非参照ピクチャ以外は参照される
+    au.isReference = !(type <= 14 && type % 2 == 0);
+
+    RbspReader reader(nal.data + 2, nal.size - 2);
+    reader.ReadBit();  // first_slice_segment_in_pic_flag（先頭スライスなので 1）
+    if (type >= 16 && type <= 23) {
+        reader.ReadBit();  // no_output_of_prior_pics_flag
+    }
+    uint32_t ppsId = reader.ReadUe();
+    reader.ReadBits(m_extraSliceHeaderBits[ppsId & 63]);  // slice_reserved_flag
+    uint32_t sliceType = reader.ReadUe();
+    if (sliceType == 0) {
+        au.frameType = 2;  // B
+    } else if (sliceType == 1) {
+        au.frameType = 1;  // P
+    } else {
+        au.frameType = 0;  // I
+    }
+}
+
+bool AnnexBSource::NextAccessUnit(AnnexBAccessUnit& au) {
+    au.frameType = 0;
+    au.isReference = true;
+    au.isIdr = false;
+    au.bytes = 0;
+    au.nals.clear();
+    au.packetSizes.clear();
+
+    bool seenVcl = false;
+    AnnexBNalUnit nal;
+    while (true) {
+        if (!PeekNal(nal)) {
+            if (!au.nals.empty()) {
+                break;
+            }
+            if (!m_loop || m_auCount == 0) {
+                return false;
+            }
+            // 終端に達したら先頭に戻る（フレームIDはそのまま継続）
+            m_pos = m_firstNal;
+            continue;
+        }
+        if (StartsNewAccessUnit(nal, seenVcl)) {
+            break;  // 先読みした NAL は次の AU の先頭として保持
+        }
+        m_hasPending = false;
+
+        if (IsVcl(nal)) {
+            if (!seenVcl) {
+                ParseSliceHeader(nal, au);
+            }
+            seenVcl = true;
+        } else if (m_codec == CODEC_H265 && ((nal.data[0] >> 1) & 0x3f) == 34) {
+            ParsePps(nal);
+        }
+        au.nals.push_back(nal);
+        au.bytes += nal.size;
+    }
+
+    // 参照関係（デコード順）: P は直前の参照ピクチャ、B は直前 2 枚の参照ピクチャ
+    int32_t frameId = static_cast<int32_t>(m_auCount);
+    if (au.isIdr) {
+        m_lastRef = -1;
+        m_prevRef = -1;
+    }
+    au.fwdRef = -1;
+    au.bwdRef = -1;
+    if (au.frameType == 1) {
+        au.fwdRef = m_lastRef;
+    } else if (au.frameType == 2) {
+        au.fwdRef = m_prevRef;
+        au.bwdRef = m_lastRef;
+        if (au.fwdRef == -1) {
+            au.fwdRef = au.bwdRef;
+            au.bwdRef = -1;
+        }
+    }
+    if (au.isReference) {
+        m_prevRef = m_lastRef;
+        m_lastRef = frameId;
+    }
+    m_auCount++;
+
+    Packetize(au);
+    return true;
+}
+
+// RFC 6184 / RFC 7798 のパケット化（non-interleaved モード）
+// MTU 以下の連続する NAL は STAP-A / AP に集約し、MTU を超える NAL は FU-A / FU に分割する
+void AnnexBSource::Packetize(AnnexBAccessUnit& au) const {
+    const uint32_t nalHeaderSize = (m_codec == CODEC_H264) ? 1 : 2;
+    const uint32_t aggHeaderSize = nalHeaderSize;       // STAP-A / AP の NAL ヘッダ
+    const uint32_t fuOverhead = nalHeaderSize + 1;      // FU indicator(PayloadHdr) + FU header
+    const uint32_t fuPayload = m_maxPayload - fuOverhead;
+
+    uint32_t aggCount = 0;   // 集約中の NAL 数
+    uint32_t aggFirst = 0;   // 集約中の先頭 NAL サイズ（1 個だけなら単一 NAL パケット）
+    uint32_t aggSize = 0;    // 集約パケットのペイロードサイズ
+
+    auto flush = [&]() {
+        if (aggCount == 1) {
+            au.packetSizes.push_back(RTP_HEADER_SIZE + aggFirst);
+        } else if (aggCount > 1) {
+            au.packetSizes.push_back(RTP_HEADER_SIZE + aggSize);
+        }
+        aggCount = 0;
+    };
+
+    for (const AnnexBNalUnit& nal : au.nals) {
+        if (nal.size > m_maxPayload) {
+            flush();
+            // NAL ヘッダは FU ヘッダに含まれるので本体のみを分割
+            uint32_t remaining = nal.size - nalHeaderSize;
+            while (remaining > 0) {
+                uint32_t chunk = std::min(remaining, fuPayload);
+                au.packetSizes.push_back(RTP_HEADER_SIZE + fuOverhead + chunk);
+                remaining -= chunk;
+            }
+            continue;
+        }
+
+        if (aggCount == 0) {
+            aggCount = 1;
+            aggFirst = nal.size;
+            aggSize = aggHeaderSize + 2 + nal.size;
+            continue;
+        }
+        if (aggSize + 2 + nal.size <= m_maxPayload) {
+            aggCount++;
+            aggSize += 2 + nal.size;
+        } else {
+            flush();
+            aggCount = 1;
+            aggFirst = nal.size;
+            aggSize = aggHeaderSize + 2 + nal.size;
+        }
+    }
+    flush();
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef ANNEXB_SOURCE_H
+#define ANNEXB_SOURCE_H
+
+#include "ns3/core-module.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// ビットストリームのコーデック
+enum AnnexBCodec {
+    CODEC_H264 = 0,
+    CODEC_H265
+};
+
+// NAL ユニット（スタートコードを除いた先頭位置とサイズ。mmap 領域を直接指す）
+struct AnnexBNalUnit {
+    const uint8_t* data;
+    uint32_t size;
+};
+
+// アクセスユニット（1 フレーム分の NAL とその RTP パケット化結果）
+struct AnnexBAccessUnit {
+    uint32_t frameType;    // 0=I, 1=P, 2=B（先頭スライスの slice_type）
+    bool isReference;      // 参照ピクチャか（nal_ref_idc / NAL タイプから判定）
+    bool isIdr;            // IDR ピクチャか
+    int32_t fwdRef;        // 前方参照フレームID (-1=参照なし)
+    int32_t bwdRef;        // 後方参照フレームID (-1=参照なし, Bフレームのみ)
+    uint32_t bytes;        // NAL の合計バイト数
+    std::vector<AnnexBNalUnit> nals;
+    std::vector<uint32_t> packetSizes;  // RTP パケットサイズ（RTP ヘッダ 12 バイト込み）
+};
+
+// AnnexBSource: Annex-B 形式の .h264/.h265 ファイルからフレームを切り出すソース
+// ファイルは mmap し、NAL の走査は必要になった分だけ逐次行うので巨大なファイルでも
+// 読み込み待ちは発生しない。スタートコード探索は SSE2 で 16 バイト単位に行う。
+// パケット化は RFC 6184 (H.264) / RFC 7798 (H.265) に従い、
+// 小さい NAL は STAP-A / AP に集約、MTU を超える NAL は FU-A / FU に分割する。
+// 参照関係はデコード順で直前の参照ピクチャ（B は直前 2 枚）を参照するものとして近似する。
+class AnnexBSource : public SimpleRefCount<AnnexBSource> {
+public:
+    AnnexBSource();
+    ~AnnexBSource();
+
+    // codec に "auto" を指定すると拡張子（.h264/.264/.h265/.265/.hevc）から判定
+    bool Open(const std::string& path, const std::string& codec);
+    void Close();
+    // RTP ペイロードの上限（UDP ペイロードサイズ - RTP ヘッダ）
+    void SetMaxPayloadSize(uint32_t size);
+    // ファイル末尾で先頭に戻るか（フレームIDは継続）
+    void SetLoop(bool loop);
+
+    // 次のアクセスユニットを取得（ファイル終端で loop なしなら false）
+    bool NextAccessUnit(AnnexBAccessUnit& au);
+
+    AnnexBCodec GetCodec() const;
+    uint64_t GetFileSize() const;
+    uint64_t GetAccessUnitCount() const;
+
+    static const uint32_t RTP_HEADER_SIZE = 12;
+
+private:
+    uint64_t FindStartCode(uint64_t from) const;
+    bool ReadNal(AnnexBNalUnit& nal);
+    bool PeekNal(AnnexBNalUnit& nal);
+    bool IsVcl(const AnnexBNalUnit& nal) const;
+    bool StartsNewAccessUnit(const AnnexBNalUnit& nal, bool seenVcl) const;
+    void ParseSliceHeader(const AnnexBNalUnit& nal, AnnexBAccessUnit& au);
+    void ParsePps(const AnnexBNalUnit& nal);
+    void Packetize(AnnexBAccessUnit& au) const;
+
+    AnnexBCodec m_codec;
+    int m_fd;
+    const uint8_t* m_data;
+    uint64_t m_size;
+    uint64_t m_pos;             // 次に読む NAL の先頭（スタートコード直後）
+    uint64_t m_firstNal;        // 最初の NAL の先頭（ループ再生用）
+    bool m_hasPending;          // 先読みした NAL（次の AU の先頭）
+    AnnexBNalUnit m_pending;
+    uint32_t m_maxPayload;
+    bool m_loop;
+    uint64_t m_auCount;         // 出力したアクセスユニット数（= フレームID）
+    int32_t m_lastRef;          // デコード順で直前の参照ピクチャ
+    int32_t m_prevRef;          // その 1 つ前の参照ピクチャ
+    uint32_t m_extraSliceHeaderBits[64];  // H.265 PPS ごとの num_extra_slice_header_bits
+};
+
+}
+
+#endif // ANNEXB_SOURCE_H
@@ -0,0 +1,387 @@
+#include "congestion-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("CongestionController");
+
+namespace {
+
+// 過負荷判定
+const double OVERUSE_TIME_MS = 10.0;   // しきい値超えがこの時間続いたら過負荷
+const double THRESHOLD_INIT = 12.5;
+const double THRESHOLD_MIN = 6.0;
+const double THRESHOLD_MAX = 600.0;
+const double THRESHOLD_K_UP = 0.0087;
+const double THRESHOLD_K_DOWN = 0.039;
+const double THRESHOLD_MAX_DEVIATION = 15.0;  // これ以上外れた傾き（突発的なスパイク）ではしきい値を更新しない
+const uint32_t MAX_TREND_SAMPLES = 60;
+
+// レート制御
+const double DECREASE_FACTOR = 0.85;
+const double INCREASE_PER_SECOND = 1.08;
+const double RESPONSE_TIME_S = 0.2;         // 加算増加 1 パケット分にかける時間（RTT + フィードバック間隔相当）
+const double PACKET_BITS = 1200.0 * 8.0;
+const double RECEIVED_RATE_HEADROOM = 1.5;  // 実受信レートに対する目標レートの上限
+
+const double RX_WINDOW_S = 0.5;
+const double GROUP_WINDOW_S = 0.005;
+// ECN（DCTCP / TCP Prague と同じ係数）
+const double CE_ALPHA_GAIN = 1.0 / 16.0;
+const double CE_REACTION_INTERVAL_MS = 100.0;  // CE による減少の最短間隔（1 RTT 相当）  // 送信時刻がグループ先頭からこの幅に収まるパケットを 1 グループにする
+
+}
+
+// TrendlineEstimator
+TrendlineEstimator::TrendlineEstimator(uint32_t windowSize, double smoothing, double gain)
+    : m_windowSize(windowSize), m_smoothing(smoothing), m_gain(gain), m_numDeltas(0), m_firstArrivalMs(-1.0),
+      m_accumulatedDelay(0.0), m_smoothedDelay(0.0), m_trend(0.0) {
+}
+
+void TrendlineEstimator::Update(double sendDeltaMs, double arrivalDeltaMs, double arrivalTimeMs) {
+    m_numDeltas = std::min(m_numDeltas + 1, 1000u);
+    if (m_firstArrivalMs < 0.0) {
+        m_firstArrivalMs = arrivalTimeMs;
+    }
+
+    m_accumulatedDelay += arrivalDeltaMs - sendDeltaMs;
+    m_smoothedDelay = m_smoothing * m_smoothedDelay + (1.0 - m_smoothing) * m_accumulatedDelay;
+
+    m_history.emplace_back(arrivalTimeMs - m_firstArrivalMs, m_smoothedDelay);
+    if (m_history.size() > m_windowSize) {
+        m_history.pop_front();
+    }
+    if (m_history.size() < m_windowSize) {
+        return;
+    }
+
+    // 最小二乗で傾きを求める
+    double meanX = 0.0;
+    double meanY = 0.0;
+    for (const auto& point : m_history) {
+        meanX += point.first;
+        meanY += point.second;
+    }
+    meanX /= m_history.size();
+    meanY /= m_history.size();
+    double numerator = 0.0;
+    double denominator = 0.0;
+    for (const auto& point : m_history) {
+        numerator += (point.first - meanX) * (point.second - meanY);
+        denominator += (point.first - meanX) * (point.first - meanX);
+    }
+    if (denominator != 0.0) {
+        m_trend = numerator / denominator;
+    }
+}
+
+double TrendlineEstimator::GetModifiedTrend() const {
+    return std::min(m_numDeltas, MAX_TREND_SAMPLES) * m_trend * m_gain;
+}
+
+double TrendlineEstimator::GetTrend() const {
+    return m_trend;
+}
+
+uint32_t TrendlineEstimator::GetNumDeltas() const {
+    return m_numDeltas;
+}
+
+// OveruseDetector
+OveruseDetector::OveruseDetector()
+    : m_threshold(THRESHOLD_INIT), m_lastUpdateMs(-1.0), m_timeOverUsing(-1.0), m_overuseCounter(0),
+      m_prevTrend(0.0), m_state(USAGE_NORMAL) {
+}
+
+BandwidthUsage OveruseDetector::Detect(double modifiedTrend, double sendDeltaMs, uint32_t numDeltas, double nowMs) {
+    if (numDeltas < 2) {
+        return USAGE_NORMAL;
+    }
+
+    if (modifiedTrend > m_threshold) {
+        if (m_timeOverUsing < 0.0) {
+            m_timeOverUsing = sendDeltaMs / 2.0;  // 最初のサンプルはグループ間隔の半分だけ超えていたとみなす
+        } else {
+            m_timeOverUsing += sendDeltaMs;
+        }
+        m_overuseCounter++;
+        if (m_timeOverUsing > OVERUSE_TIME_MS && m_overuseCounter > 1 && modifiedTrend >= m_prevTrend) {
+            m_timeOverUsing = 0.0;
+            m_overuseCounter = 0;
+            m_state = USAGE_OVERUSING;
+        }
+    } else if (modifiedTrend < -m_threshold) {
+        m_timeOverUsing = -1.0;
+        m_overuseCounter = 0;
+        m_state = USAGE_UNDERUSING;
+    } else {
+        m_timeOverUsing = -1.0;
+        m_overuseCounter = 0;
+        m_state = USAGE_NORMAL;
+    }
+    m_prevTrend = modifiedTrend;
+
+    UpdateThreshold(modifiedTrend, nowMs);
+    return m_state;
+}
+
+void OveruseDetector::UpdateThreshold(double modifiedTrend, double nowMs) {
+    if (m_lastUpdateMs < 0.0) {
+        m_lastUpdateMs = nowMs;
+    }
+    double absTrend = std::fabs(modifiedTrend);
+    if (absTrend > m_threshold + THRESHOLD_MAX_DEVIATION) {
+        m_lastUpdateMs = nowMs;
+        return;
+    }
+    double k = absTrend < m_threshold ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+    double dt = std::min(nowMs - m_lastUpdateMs, 100.0);
+    m_threshold += k * (absTrend - m_threshold) * dt;
+    m_threshold = std::max(THRESHOLD_MIN, std::min(m_threshold, THRESHOLD_MAX));
+    m_lastUpdateMs = nowMs;
+}
+
+double OveruseDetector::GetThreshold() const {
+    return m_threshold;
+}
+
+BandwidthUsage OveruseDetector::GetState() const {
+    return m_state;
+}
+
+// AimdRateController
+AimdRateController::AimdRateController(double minBps, double maxBps, double startBps)
+    : m_minBps(minBps), m_maxBps(maxBps), m_targetBps(startBps), m_state(RC_HOLD), m_lastChangeMs(-1.0),
+      m_avgMaxKbps(-1.0), m_varMaxKbps(0.4) {
+}
+
+double AimdRateController::Update(BandwidthUsage usage, double receivedBps, double nowMs) {
+    // 状態遷移: 過負荷 → 減少、余裕 → 保持（キューが掃けるのを待つ）、通常 → 保持から増加へ
+    switch (usage) {
+        case USAGE_OVERUSING:
+            m_state = RC_DECREASE;
+            break;
+        case USAGE_UNDERUSING:
+            m_state = RC_HOLD;
+            break;
+        case USAGE_NORMAL:
+            if (m_state == RC_HOLD) {
+                m_state = RC_INCREASE;
+            }
+            break;
+    }
+
+    double dtS = m_lastChangeMs < 0.0 ? 0.0 : std::min((nowMs - m_lastChangeMs) / 1000.0, 1.0);
+    double receivedKbps = receivedBps / 1000.0;
+
+    switch (m_state) {
+        case RC_INCREASE: {
+            if (m_avgMaxKbps >= 0.0 && receivedKbps > m_avgMaxKbps + 3.0 * std::sqrt(m_varMaxKbps * m_avgMaxKbps)) {
+                m_avgMaxKbps = -1.0;  // 以前の上限を超えて流れているので推定をやり直す
+            }
+            bool nearMax = m_avgMaxKbps >= 0.0 &&
+                           std::fabs(receivedKbps - m_avgMaxKbps) <= 3.0 * std::sqrt(m_varMaxKbps * m_avgMaxKbps);
+            if (nearMax) {
+                m_targetBps += PACKET_BITS / RESPONSE_TIME_S * dtS;
+            } else {
+                m_targetBps = std::max(m_targetBps * std::pow(INCREASE_PER_SECOND, dtS), m_targetBps + 1000.0 * dtS);
+            }
+            break;
+        }
+        case RC_DECREASE:
+            if (receivedBps > 0.0) {
+                m_targetBps = std::min(m_targetBps, DECREASE_FACTOR * receivedBps);
+                UpdateMaxRateEstimate(receivedKbps);
+            } else {
+                m_targetBps *= DECREASE_FACTOR;
+            }
+            m_state = RC_HOLD;  // 1 回の過負荷判定で 1 回だけ下げる
+            break;
+        case RC_HOLD:
+            break;
+    }
+
+    if (receivedBps > 0.0) {
+        m_targetBps = std::min(m_targetBps, RECEIVED_RATE_HEADROOM * receivedBps + 10000.0);
+    }
+    m_targetBps = std::max(m_minBps, std::min(m_targetBps, m_maxBps));
+    m_lastChangeMs = nowMs;
+    return m_targetBps;
+}
+
+void AimdRateController::UpdateMaxRateEstimate(double receivedKbps) {
+    const double alpha = 0.05;
+    if (m_avgMaxKbps < 0.0) {
+        m_avgMaxKbps = receivedKbps;
+    } else {
+        m_avgMaxKbps = (1.0 - alpha) * m_avgMaxKbps + alpha * receivedKbps;
+    }
+    double norm = std::max(m_avgMaxKbps, 1.0);
+    double diff = m_avgMaxKbps - receivedKbps;
+    m_varMaxKbps = (1.0 - alpha) * m_varMaxKbps + alpha * diff * diff / norm;
+    m_varMaxKbps = std::max(0.4, std::min(m_varMaxKbps, 2.5));
+}
+
+double AimdRateController::ReduceForCongestion(double factor, double nowMs) {
+    m_targetBps = std::max(m_minBps, std::min(m_targetBps * factor, m_maxBps));
+    m_state = RC_HOLD;
+    m_lastChangeMs = nowMs;
+    return m_targetBps;
+}
+
+double AimdRateController::GetTargetRate() const {
+    return m_targetBps;
+}
+
+// DelayBasedBwe
+DelayBasedBwe::DelayBasedBwe(double minBps, double maxBps, double startBps)
+    : m_rateController(minBps, maxBps, startBps), m_hasCurrent(false), m_hasPrevious(false), m_completedGroups(0),
+      m_rxWindowBytes(0), m_ceAlpha(0.0), m_lastCeReductionMs(-1.0), m_cePackets(0) {
+}
+
+void DelayBasedBwe::OnPacket(double sendTime, double arrivalTime, uint32_t size, bool ceMarked) {
+    m_rxWindow.emplace_back(arrivalTime, size);
+    m_rxWindowBytes += size;
+    while (!m_rxWindow.empty() && m_rxWindow.front().first < arrivalTime - RX_WINDOW_S) {
+        m_rxWindowBytes -= m_rxWindow.front().second;
+        m_rxWindow.pop_front();
+    }
+
+    if (ceMarked) {
+        m_cePackets++;
+    }
+
+    if (!m_hasCurrent) {
+        m_current = {sendTime, sendTime, arrivalTime, 1, ceMarked ? 1u : 0u};
+        m_hasCurrent = true;
+        return;
+    }
+    if (sendTime < m_current.firstSendTime) {
+        return;  // 前のグループで送ったパケットの遅着は無視
+    }
+    if (sendTime - m_current.firstSendTime <= GROUP_WINDOW_S) {
+        m_current.sendTime = std::max(m_current.sendTime, sendTime);
+        m_current.arrivalTime = std::max(m_current.arrivalTime, arrivalTime);
+        m_current.packets++;
+        m_current.cePackets += ceMarked ? 1 : 0;
+        return;
+    }
+
+    CompleteGroup(arrivalTime * 1000.0);
+    m_previous = m_current;
+    m_hasPrevious = true;
+    m_current = {sendTime, sendTime, arrivalTime, 1, ceMarked ? 1u : 0u};
+}
+
+uint32_t DelayBasedBwe::GetCompletedGroups() const {
+    return m_completedGroups;
+}
+
+void DelayBasedBwe::CompleteGroup(double nowMs) {
+    // CE 割合の移動平均を更新し、マークがあれば 1 RTT 相当に 1 回だけ (1 - α/2) 倍に下げる
+    double ceFraction = static_cast<double>(m_current.cePackets) / m_current.packets;
+    m_ceAlpha = (1.0 - CE_ALPHA_GAIN) * m_ceAlpha + CE_ALPHA_GAIN * ceFraction;
+    bool ceReduce = m_current.cePackets > 0 &&
+                    (m_lastCeReductionMs < 0.0 || nowMs - m_lastCeReductionMs >= CE_REACTION_INTERVAL_MS);
+    if (!m_hasPrevious) {
+        if (ceReduce) {
+            m_rateController.ReduceForCongestion(1.0 - m_ceAlpha / 2.0, nowMs);
+            m_lastCeReductionMs = nowMs;
+        }
+        return;
+    }
+    double sendDeltaMs = (m_current.sendTime - m_previous.sendTime) * 1000.0;
+    double arrivalDeltaMs = (m_current.arrivalTime - m_previous.arrivalTime) * 1000.0;
+    m_trendline.Update(sendDeltaMs, arrivalDeltaMs, m_current.arrivalTime * 1000.0);
+    BandwidthUsage usage =
+        m_detector.Detect(m_trendline.GetModifiedTrend(), sendDeltaMs, m_trendline.GetNumDeltas(), nowMs);
+    m_rateController.Update(usage, GetReceivedRate(), nowMs);
+    if (ceReduce) {
+        m_rateController.ReduceForCongestion(1.0 - m_ceAlpha / 2.0, nowMs);
+        m_lastCeReductionMs = nowMs;
+    }
+    m_completedGroups++;
+}
+
+double DelayBasedBwe::GetTargetRate() const {
+    return m_rateController.GetTargetRate();
+}
+
+double DelayBasedBwe::GetReceivedRate() const {
+    // ウィンドウが埋まるまでは受信レートを使わない（立ち上がりの過小評価で目標を抑えないため）
+    if (m_rxWindow.empty() || m_rxWindow.back().first - m_rxWindow.front().first < RX_WINDOW_S * 0.9) {
+        return 0.0;
+    }
+    return m_rxWindowBytes * 8.0 / RX_WINDOW_S;
+}
+
+double DelayBasedBwe::GetModifiedTrend() const {
+    return m_trendline.GetModifiedTrend();
+}
+
+double DelayBasedBwe::GetThreshold() const {
+    return m_detector.GetThreshold();
+}
+
+BandwidthUsage DelayBasedBwe::GetUsage() const {
+    return m_detector.GetState();
+}
+
+double DelayBasedBwe::GetCeAlpha() const {
+    return m_ceAlpha;
+}
+
+uint64_t DelayBasedBwe::GetCePackets() const {
+    return m_cePackets;
+}
+
+// CongestionFeedbackTag
+TypeId CongestionFeedbackTag::GetTypeId() {
+    static TypeId tid = TypeId("ns3::CongestionFeedbackTag")
+        .SetParent<Tag>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<CongestionFeedbackTag>();
+    return tid;
+}
+
+TypeId CongestionFeedbackTag::GetInstanceTypeId() const {
+    return GetTypeId();
+}
+
+CongestionFeedbackTag::CongestionFeedbackTag() : m_targetBps(0.0), m_receivedBps(0.0), m_trend(0.0), m_cePackets(0) {
+}
+
+CongestionFeedbackTag::CongestionFeedbackTag(double targetBps, double receivedBps, double trend, uint64_t cePackets)
+    : m_targetBps(targetBps), m_receivedBps(receivedBps), m_trend(trend), m_cePackets(cePackets) {
+}
+
+uint32_t CongestionFeedbackTag::GetSerializedSize() const {
+    return 8 + 8 + 8 + 8;
+}
+
+void CongestionFeedbackTag::Serialize(TagBuffer i) const {
+    i.WriteDouble(m_targetBps);
+    i.WriteDouble(m_receivedBps);
+    i.WriteDouble(m_trend);
+    i.WriteU64(m_cePackets);
+}
+
+void CongestionFeedbackTag::Deserialize(TagBuffer i) {
+    m_targetBps = i.ReadDouble();
+    m_receivedBps = i.ReadDouble();
+    m_trend = i.ReadDouble();
+    m_cePackets = i.ReadU64();
+}
+
+void CongestionFeedbackTag::Print(std::ostream& os) const {
+    os << "Target=" << m_targetBps << " Received=" << m_receivedBps << " Trend=" << m_trend << " CE=" << m_cePackets;
+}
+
+double CongestionFeedbackTag::GetTargetRate() const { return m_targetBps; }
+double CongestionFeedbackTag::GetReceivedRate() const { return m_receivedBps; }
+double CongestionFeedbackTag::GetTrend() const { return m_trend; }
+uint64_t CongestionFeedbackTag::GetCePackets() const { return m_cePackets; }
+
+}
@@ -0,0 +1,168 @@
+#ifndef CONGESTION_CONTROLLER_H
+#define CONGESTION_CONTROLLER_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include <deque>
+
+namespace ns3 {
+
+// 帯域使用状態（遅延勾配の判定結果）
+enum BandwidthUsage {
+    USAGE_NORMAL = 0,
+    USAGE_UNDERUSING,
+    USAGE_OVERUSING
+};
+
+// TrendlineEstimator: 到着時刻フィルタ
+// 送信グループ間の遅延変動 d = (到着間隔 - 送信間隔) を累積・平滑化し、直近のウィンドウで
+// 線形回帰した傾き（キュー遅延の増加率）を求める。
+class TrendlineEstimator {
+public:
+    TrendlineEstimator(uint32_t windowSize = 20, double smoothing = 0.9, double gain = 4.0);
+
+    // 1 グループ分の送信間隔・到着間隔（ミリ秒）と到着時刻（ミリ秒）を追加
+    void Update(double sendDeltaMs, double arrivalDeltaMs, double arrivalTimeMs);
+    // 判定に使う傾き（サンプル数とゲインで拡大した値）
+    double GetModifiedTrend() const;
+    double GetTrend() const;
+    uint32_t GetNumDeltas() const;
+
+private:
+    uint32_t m_windowSize;
+    double m_smoothing;
+    double m_gain;
+    uint32_t m_numDeltas;
+    double m_firstArrivalMs;
+    double m_accumulatedDelay;
+    double m_smoothedDelay;
+    double m_trend;
+    std::deque<std::pair<double, double>> m_history;  // (到着時刻, 平滑化累積遅延)
+};
+
+// OveruseDetector: 傾きを適応しきい値と比較して過負荷・余裕を判定
+// しきい値は傾きの大きさに追従させ、並行する TCP フローなどに対して判定が飢餓化しないようにする。
+class OveruseDetector {
+public:
+    OveruseDetector();
+
+    BandwidthUsage Detect(double modifiedTrend, double sendDeltaMs, uint32_t numDeltas, double nowMs);
+    double GetThreshold() const;
+    BandwidthUsage GetState() const;
+
+private:
+    void UpdateThreshold(double modifiedTrend, double nowMs);
+
+    double m_threshold;     // ミリ秒相当
+    double m_lastUpdateMs;
+    double m_timeOverUsing;
+    uint32_t m_overuseCounter;
+    double m_prevTrend;
+    BandwidthUsage m_state;
+};
+
+// AimdRateController: 判定結果から目標ビットレートを決める（増加・保持・減少の状態遷移）
+class AimdRateController {
+public:
+    AimdRateController(double minBps, double maxBps, double startBps);
+
+    double Update(BandwidthUsage usage, double receivedBps, double nowMs);
+    // ECN の CE マークに応じて目標レートを factor 倍に下げる
+    double ReduceForCongestion(double factor, double nowMs);
+    double GetTargetRate() const;
+
+private:
+    enum RateControlState {
+        RC_HOLD = 0,
+        RC_INCREASE,
+        RC_DECREASE
+    };
+
+    void UpdateMaxRateEstimate(double receivedKbps);
+
+    double m_minBps;
+    double m_maxBps;
+    double m_targetBps;
+    RateControlState m_state;
+    double m_lastChangeMs;
+    double m_avgMaxKbps;   // 過去の減少時の受信レートの平均（収束判定用, -1 = 未推定）
+    double m_varMaxKbps;
+};
+
+// DelayBasedBwe: 受信側の遅延勾配ベースの帯域推定（到着時刻フィルタ → 過負荷判定 → AIMD）
+// パケットは送信順に、送信時刻が先頭から GROUP_WINDOW 以内のものを 1 グループにまとめ、
+// グループ内最後の送信と到着を代表値にする（フレームIDは使わないので復号順送信の B フレームも評価に入る）。
+// ECN の CE マークも受け取り、グループ内の CE 割合の移動平均 α で目標レートを (1 - α/2) 倍に下げる（L4S の反応）。
+class DelayBasedBwe : public SimpleRefCount<DelayBasedBwe> {
+public:
+    DelayBasedBwe(double minBps, double maxBps, double startBps);
+
+    // 受信パケット（送信時刻・到着時刻は秒）。新しいグループの先頭が来た時点で前のグループを評価する
+    void OnPacket(double sendTime, double arrivalTime, uint32_t size, bool ceMarked = false);
+    // 評価済みのグループ数（判定結果が更新されたかの確認用）
+    uint32_t GetCompletedGroups() const;
+
+    double GetTargetRate() const;
+    double GetReceivedRate() const;
+    double GetModifiedTrend() const;
+    double GetThreshold() const;
+    BandwidthUsage GetUsage() const;
+    // CE マーク割合の移動平均と、これまでに受信した CE マーク付きパケット数
+    double GetCeAlpha() const;
+    uint64_t GetCePackets() const;
+
+private:
+    struct PacketGroup {
+        double firstSendTime;  // グループ先頭の送信時刻
+        double sendTime;
+        double arrivalTime;
+        uint32_t packets;
+        uint32_t cePackets;
+    };
+
+    void CompleteGroup(double nowMs);
+
+    TrendlineEstimator m_trendline;
+    OveruseDetector m_detector;
+    AimdRateController m_rateController;
+    bool m_hasCurrent;
+    bool m_hasPrevious;
+    PacketGroup m_current;
+    PacketGroup m_previous;
+    uint32_t m_completedGroups;
+    std::deque<std::pair<double, uint32_t>> m_rxWindow;  // (到着時刻, サイズ) 受信レート計測用
+    uint64_t m_rxWindowBytes;
+    double m_ceAlpha;
+    double m_lastCeReductionMs;  // 前回 CE で下げた時刻 (-1 = なし)
+    uint64_t m_cePackets;
+};
+
+// CongestionFeedbackTag: 受信側から送信側へ返す目標ビットレート（REMB 相当）と CE マーク数のエコー
+class CongestionFeedbackTag : public Tag {
+public:
+    static TypeId GetTypeId();
+    virtual TypeId GetInstanceTypeId() const;
+
+    CongestionFeedbackTag();
+    CongestionFeedbackTag(double targetBps, double receivedBps, double trend, uint64_t cePackets = 0);
+
+    virtual uint32_t GetSerializedSize() const;
+    virtual void Serialize(TagBuffer i) const;
+    virtual void Deserialize(TagBuffer i);
+    virtual void Print(std::ostream& os) const;
+
+    double GetTargetRate() const;
+    double GetReceivedRate() const;
+    double GetTrend() const;
+    uint64_t GetCePackets() const;  // 受信側が受けた CE マーク付きパケット数（累計）
+
+private:
+    double m_targetBps;
+    double m_receivedBps;
+    double m_trend;
+    uint64_t m_cePackets;
+};
+
+}
+
+#endif // CONGESTION_CONTROLLER_H
@@ -0,0 +1,192 @@
+#include "cross-traffic.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("CrossTraffic");
+
+namespace {
+
+const uint16_t TCP_PORT = 6000;
+const uint16_t VOIP_PORT = 6001;
+const uint16_t WEB_PORT = 6002;
+const uint16_t UPLINK_PORT_BASE = 6100;  // サーバー側は BSS ごとにポートを分ける
+
+const uint32_t TCP_SEND_SIZE = 1448;
+const uint32_t VOIP_PACKET_SIZE = 160;   // G.711 20ms 分
+const uint32_t WEB_PACKET_SIZE = 1448;
+const uint32_t UPLINK_PACKET_SIZE = 1400;
+
+const uint8_t TOS_BE = 0x00;
+const uint8_t TOS_VO = 0xc0;
+
+// フロー開始時刻をずらして同期した立ち上がりを避ける
+Time StaggeredStart(Time start, uint32_t bss, uint32_t flow) {
+    return start + MicroSeconds(997 * ((bss * 31 + flow) % 100));
+}
+
+}
+
+bool CrossTrafficConfig::IsEnabled() const {
+    return tcpFlows > 0 || voipFlows > 0 || webFlows > 0 || uplinkFlows > 0;
+}
+
+CrossTraffic::CrossTraffic(const CrossTrafficConfig& config) : m_config(config) {
+}
+
+uint32_t CrossTraffic::GetFlows(TrafficClass trafficClass) const {
+    switch (trafficClass) {
+        case CLASS_TCP: return m_config.tcpFlows;
+        case CLASS_VOIP: return m_config.voipFlows;
+        case CLASS_WEB: return m_config.webFlows;
+        case CLASS_UPLINK: return m_config.uplinkFlows;
+        default: return 0;
+    }
+}
+
+void CrossTraffic::AddSink(uint32_t bss, TrafficClass trafficClass, Ptr<Node> node, std::string socketFactory,
+                           uint16_t port, Time start, Time stop) {
+    PacketSinkHelper sinkHelper(socketFactory, InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer app = sinkHelper.Install(node);
+    app.Start(start);
+    app.Stop(stop);
+
+    SinkEntry entry;
+    entry.bss = bss;
+    entry.trafficClass = trafficClass;
+    entry.sink = DynamicCast<PacketSink>(app.Get(0));
+    m_sinks.push_back(entry);
+}
+
+void CrossTraffic::InstallBss(uint32_t bss, Ptr<Node> server, Ipv4Address serverAddress, NodeContainer stas,
+                              Ipv4InterfaceContainer staIf, Time start, Time stop) {
+    NS_ABORT_MSG_IF(stas.GetN() == 0, "Cross traffic needs at least one extra STA per BSS");
+    uint32_t nStas = stas.GetN();
+    Time sinkStart = start - MilliSeconds(100);
+
+    // 受信側: 下りは STA ごと・種別ごとに 1 つ（フローが割り当たる STA のみ）
+    const struct {
+        TrafficClass trafficClass;
+        const char* factory;
+        uint16_t port;
+    } downlinks[] = {
+        {CLASS_TCP, "ns3::TcpSocketFactory", TCP_PORT},
+        {CLASS_VOIP, "ns3::UdpSocketFactory", VOIP_PORT},
+        {CLASS_WEB, "ns3::TcpSocketFactory", WEB_PORT},
+    };
+    for (const auto& downlink : downlinks) {
+        uint32_t flows = GetFlows(downlink.trafficClass);
+        for (uint32_t s = 0; s < std::min(flows, nStas); s++) {
+            AddSink(bss, downlink.trafficClass, stas.Get(s), downlink.factory, downlink.port, sinkStart, stop);
+        }
+    }
+    uint16_t uplinkPort = UPLINK_PORT_BASE + bss;
+    bool uplinkTcp = m_config.uplinkMbps <= 0.0;
+    if (m_config.uplinkFlows > 0) {
+        AddSink(bss, CLASS_UPLINK, server, uplinkTcp ? "ns3::TcpSocketFactory" : "ns3::UdpSocketFactory",
+                uplinkPort, sinkStart, stop);
+    }
+
+    uint32_t flowIndex = 0;
+
+    // 下り TCP バルク転送（上限なし）
+    for (uint32_t f = 0; f < m_config.tcpFlows; f++) {
+        BulkSendHelper bulk("ns3::TcpSocketFactory", InetSocketAddress(staIf.GetAddress(f % nStas), TCP_PORT));
+        bulk.SetAttribute("MaxBytes", UintegerValue(0));
+        bulk.SetAttribute("SendSize", UintegerValue(TCP_SEND_SIZE));
+        bulk.SetAttribute("Tos", UintegerValue(TOS_BE));
+        ApplicationContainer app = bulk.Install(server);
+        app.Start(StaggeredStart(start, bss, flowIndex++));
+        app.Stop(stop);
+    }
+
+    // 下り VoIP（常時 ON の CBR）
+    for (uint32_t f = 0; f < m_config.voipFlows; f++) {
+        OnOffHelper voip("ns3::UdpSocketFactory", InetSocketAddress(staIf.GetAddress(f % nStas), VOIP_PORT));
+        voip.SetConstantRate(DataRate(static_cast<uint64_t>(m_config.voipKbps * 1e3)), VOIP_PACKET_SIZE);
+        voip.SetAttribute("Tos", UintegerValue(TOS_VO));
+        ApplicationContainer app = voip.Install(server);
+        app.Start(StaggeredStart(start, bss, flowIndex++));
+        app.Stop(stop);
+    }
+
+    // 下り Web（指数分布の ON/OFF で閲覧時のバーストを近似）
+    for (uint32_t f = 0; f < m_config.webFlows; f++) {
+        OnOffHelper web("ns3::TcpSocketFactory", InetSocketAddress(staIf.GetAddress(f % nStas), WEB_PORT));
+        web.SetAttribute("DataRate", DataRateValue(DataRate(static_cast<uint64_t>(m_config.webPeakMbps * 1e6))));
+        web.SetAttribute("PacketSize", UintegerValue(WEB_PACKET_SIZE));
+        std::ostringstream onTime;
+        std::ostringstream offTime;
+        onTime << "ns3::ExponentialRandomVariable[Mean=" << m_config.webOnMs / 1000.0 << "]";
+        offTime << "ns3::ExponentialRandomVariable[Mean=" << m_config.webOffMs / 1000.0 << "]";
+        web.SetAttribute("OnTime", StringValue(onTime.str()));
+        web.SetAttribute("OffTime", StringValue(offTime.str()));
+        web.SetAttribute("Tos", UintegerValue(TOS_BE));
+        ApplicationContainer app = web.Install(server);
+        app.Start(StaggeredStart(start, bss, flowIndex++));
+        app.Stop(stop);
+    }
+
+    // 上りアップロード（追加 STA → サーバー）
+    for (uint32_t f = 0; f < m_config.uplinkFlows; f++) {
+        ApplicationContainer app;
+        if (uplinkTcp) {
+            BulkSendHelper bulk("ns3::TcpSocketFactory", InetSocketAddress(serverAddress, uplinkPort));
+            bulk.SetAttribute("MaxBytes", UintegerValue(0));
+            bulk.SetAttribute("SendSize", UintegerValue(TCP_SEND_SIZE));
+            bulk.SetAttribute("Tos", UintegerValue(TOS_BE));
+            app = bulk.Install(stas.Get(f % nStas));
+        } else {
+            OnOffHelper upload("ns3::UdpSocketFactory", InetSocketAddress(serverAddress, uplinkPort));
+            upload.SetConstantRate(DataRate(static_cast<uint64_t>(m_config.uplinkMbps * 1e6)), UPLINK_PACKET_SIZE);
+            upload.SetAttribute("Tos", UintegerValue(TOS_BE));
+            app = upload.Install(stas.Get(f % nStas));
+        }
+        app.Start(StaggeredStart(start, bss, flowIndex++));
+        app.Stop(stop);
+    }
+}
+
+void CrossTraffic::WriteReport(const std::string& filename, double duration) const {
+    const char* classStr[] = {"TCP", "VoIP", "Web", "Uplink"};
+    uint32_t numBss = 0;
+    for (const SinkEntry& entry : m_sinks) {
+        numBss = std::max(numBss, entry.bss + 1);
+    }
+
+    std::ofstream out(filename);
+    out << "BSS,Class,Flows,RxBytes,Throughput(Mbps)" << std::endl;
+    for (uint32_t b = 0; b < numBss; b++) {
+        for (uint32_t c = 0; c < CLASS_COUNT; c++) {
+            uint32_t flows = GetFlows(static_cast<TrafficClass>(c));
+            if (flows == 0) {
+                continue;
+            }
+            uint64_t rxBytes = 0;
+            for (const SinkEntry& entry : m_sinks) {
+                if (entry.bss == b && entry.trafficClass == c) {
+                    rxBytes += entry.sink->GetTotalRx();
+                }
+            }
+            out << b << ","
+                << classStr[c] << ","
+                << flows << ","
+                << rxBytes << ","
+                << std::fixed << std::setprecision(3) << (duration > 0.0 ? rxBytes * 8.0 / duration / 1e6 : 0.0)
+                << std::endl;
+        }
+    }
+}
+
+std::string CrossTraffic::GetSuffix() const {
+    std::ostringstream suffix;
+    suffix << "_xt" << m_config.tcpFlows << "v" << m_config.voipFlows << "w" << m_config.webFlows << "u"
+           << m_config.uplinkFlows;
+    return suffix.str();
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef CROSS_TRAFFIC_H
+#define CROSS_TRAFFIC_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// 競合トラフィックの構成（フロー数はすべて BSS あたり）
+struct CrossTrafficConfig {
+    uint32_t tcpFlows;      // 下り TCP バルク転送（AC_BE）
+    uint32_t voipFlows;     // 下り VoIP 相当の CBR（AC_VO, ToS 0xc0）
+    double voipKbps;        // VoIP 1 フローのレート
+    uint32_t webFlows;      // 下り Web 相当の ON/OFF バースト（TCP, AC_BE）
+    double webPeakMbps;     // ON 区間の送信レート
+    double webOnMs;         // ON 区間の平均長（指数分布）
+    double webOffMs;        // OFF 区間の平均長（指数分布）
+    uint32_t uplinkFlows;   // 追加 STA からサーバーへの上りアップロード
+    double uplinkMbps;      // 上り 1 フローのレート（0 = TCP バルク転送）
+
+    CrossTrafficConfig()
+        : tcpFlows(0), voipFlows(0), voipKbps(64.0), webFlows(0), webPeakMbps(10.0), webOnMs(200.0),
+          webOffMs(2000.0), uplinkFlows(0), uplinkMbps(0.0) {}
+
+    bool IsEnabled() const;
+};
+
+// CrossTraffic: 映像フローと競合する背景トラフィックを BSS ごとに設置し、種別ごとの受信量を集計する
+// 映像 STA とは別の追加 STA を相手にし、フローはそれらにラウンドロビンで割り当てる。
+// 受信側の PacketSink は STA・種別ごとに 1 つだけ置いてフロー間で共有し、数百フローでも
+// アプリケーション数とイベント数を抑える。
+class CrossTraffic : public SimpleRefCount<CrossTraffic> {
+public:
+    explicit CrossTraffic(const CrossTrafficConfig& config);
+
+    // BSS 1 つ分のトラフィックを設置（stas は追加 STA、serverAddress は BSS 側から見たサーバーのアドレス）
+    void InstallBss(uint32_t bss, Ptr<Node> server, Ipv4Address serverAddress, NodeContainer stas,
+                    Ipv4InterfaceContainer staIf, Time start, Time stop);
+
+    void WriteReport(const std::string& filename, double duration) const;
+    // ファイル名に付ける構成の略記
+    std::string GetSuffix() const;
+
+private:
+    enum TrafficClass {
+        CLASS_TCP = 0,
+        CLASS_VOIP,
+        CLASS_WEB,
+        CLASS_UPLINK,
+        CLASS_COUNT
+    };
+
+    struct SinkEntry {
+        uint32_t bss;
+        TrafficClass trafficClass;
+        Ptr<PacketSink> sink;
+    };
+
+    void AddSink(uint32_t bss, TrafficClass trafficClass, Ptr<Node> node, std::string socketFactory, uint16_t port,
+                 Time start, Time stop);
+    uint32_t GetFlows(TrafficClass trafficClass) const;
+
+    CrossTrafficConfig m_config;
+    std::vector<SinkEntry> m_sinks;
+};
+
+}
+
+#endif // CROSS_TRAFFIC_H
@@ -0,0 +1,211 @@
+#include "deadline-mu-scheduler.h"
+#include "video-frame.h"
+#include "ns3/ap-wifi-mac.h"
+#include "ns3/he-configuration.h"
+#include "ns3/he-frame-exchange-manager.h"
+#include "ns3/he-ru.h"
+#include "ns3/mpdu-aggregator.h"
+#include "ns3/qos-txop.h"
+#include "ns3/qos-utils.h"
+#include "ns3/wifi-mpdu.h"
+#include "ns3/wifi-psdu.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("DeadlineMultiUserScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(DeadlineMultiUserScheduler);
+
+TypeId DeadlineMultiUserScheduler::GetTypeId() {
+    static TypeId tid = TypeId("ns3::DeadlineMultiUserScheduler")
+        .SetParent<MultiUserScheduler>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<DeadlineMultiUserScheduler>()
+        .AddAttribute("NStations",
+                      "The maximum number of stations that can be granted an RU in a DL MU PPDU",
+                      UintegerValue(4),
+                      MakeUintegerAccessor(&DeadlineMultiUserScheduler::m_nStations),
+                      MakeUintegerChecker<uint8_t>(1, 74))
+        .AddAttribute("Deadline",
+                      "Tolerable delay added to the frame transmission start time",
+                      TimeValue(MilliSeconds(33)),
+                      MakeTimeAccessor(&DeadlineMultiUserScheduler::m_deadline),
+                      MakeTimeChecker());
+    return tid;
+}
+
+DeadlineMultiUserScheduler::DeadlineMultiUserScheduler()
+    : m_nStations(4), m_deadline(MilliSeconds(33)) {
+}
+
+DeadlineMultiUserScheduler::~DeadlineMultiUserScheduler() {
+}
+
+Time DeadlineMultiUserScheduler::GetDeadline(Ptr<const WifiMpdu> mpdu) const {
+    // 映像パケット: フレーム送信開始時刻 + 許容遅延
+    VideoFrameTag tag;
+    if (mpdu->GetPacket()->PeekPacketTag(tag) && tag.GetFrameId() != static_cast<uint32_t>(-1)) {
+        return Seconds(tag.GetTransmissionStartTime()) + m_deadline;
+    }
+    // それ以外: キュー投入時刻 + 許容遅延
+    return mpdu->GetTimestamp() + m_deadline;
+}
+
+void DeadlineMultiUserScheduler::InitDlMuTxVector(WifiTxVector& txVector) const {
+    txVector.SetPreambleType(WIFI_PREAMBLE_HE_MU);
+    txVector.SetChannelWidth(m_allowedWidth);
+    txVector.SetGuardInterval(m_apMac->GetHeConfiguration()->GetGuardInterval());
+}
+
+MultiUserScheduler::TxFormat DeadlineMultiUserScheduler::SelectTxFormat() {
+    AcIndex primaryAc = m_edca->GetAccessCategory();
+    Ptr<WifiRemoteStationManager> manager = GetWifiRemoteStationManager(m_linkId);
+
+    // 先頭 MPDU が QoS データでなければ（管理フレーム等）SU 送信
+    Ptr<WifiMpdu> headMpdu = m_edca->PeekNextMpdu(m_linkId);
+    if (!headMpdu || !headMpdu->GetHeader().IsQosData()) {
+        return SU_TX;
+    }
+
+    // TXOP に含められるのは獲得した AC（プライマリ AC）と、それより優先度の高い AC の MPDU
+    std::vector<AcIndex> allowedAcs;
+    for (AcIndex ac : {AC_VO, AC_VI, AC_BE, AC_BK}) {
+        allowedAcs.push_back(ac);
+        if (ac == primaryAc) {
+            break;
+        }
+    }
+
+    // 送信待ちのある HE 対応 STA を列挙し、許可された全 AC の TID のうち最も締切の近い先頭 MPDU を候補にする
+    // （I フレームの AC_VO と P/B フレームの AC_BE を同じ DL MU PPDU の中で締切順に比べる）
+    m_candidates.clear();
+    for (const auto& sta : m_apMac->GetStaList(m_linkId)) {
+        uint16_t aid = sta.first;
+        Mac48Address address = sta.second;
+        if (!manager->GetHeSupported(address)) {
+            continue;
+        }
+        Candidate best{aid, address, nullptr, Time::Max()};
+        for (AcIndex ac : allowedAcs) {
+            Ptr<QosTxop> txop = m_apMac->GetQosTxop(ac);
+            for (uint8_t tid : {wifiAcList.at(ac).GetHighTid(), wifiAcList.at(ac).GetLowTid()}) {
+                // DL MU 送信には Block Ack 合意が必要
+                if (!m_apMac->GetBaAgreementEstablishedAsOriginator(address, tid)) {
+                    continue;
+                }
+                Ptr<WifiMpdu> mpdu = txop->PeekNextMpdu(m_linkId, tid, address);
+                if (mpdu) {
+                    Time deadline = GetDeadline(mpdu);
+                    if (!best.mpdu || deadline < best.deadline) {
+                        best.mpdu = mpdu;
+                        best.deadline = deadline;
+                    }
+                }
+            }
+        }
+        if (best.mpdu) {
+            m_candidates.push_back(best);
+        }
+    }
+
+    // 宛先が 1 STA のみなら OFDMA の利点はない
+    if (m_candidates.size() < 2) {
+        return SU_TX;
+    }
+
+    // 締切の近い STA を優先
+    std::stable_sort(m_candidates.begin(), m_candidates.end(),
+                     [](const Candidate& a, const Candidate& b) { return a.deadline < b.deadline; });
+    if (m_candidates.size() > m_nStations) {
+        m_candidates.resize(m_nStations);
+    }
+
+    std::size_t nStations = m_candidates.size();
+    std::size_t nCentral26TonesRus = 0;
+    auto ruType = HeRu::GetEqualSizedRusForStations(m_allowedWidth, nStations, nCentral26TonesRus);
+    m_candidates.resize(nStations);
+
+    // 仮の RU を割り当て、先頭 MPDU が送信時間の制約を満たす STA のみ残す
+    m_txParams.Clear();
+    InitDlMuTxVector(m_txParams.m_txVector);
+    Time availableTime = m_initialFrame ? Time::Min() : m_availableTime;
+
+    auto it = m_candidates.begin();
+    while (it != m_candidates.end()) {
+        it->mpdu = GetHeFem(m_linkId)->CreateAliasIfNeeded(it->mpdu);
+        WifiTxVector suTxVector = manager->GetDataTxVector(it->mpdu->GetHeader(), m_allowedWidth);
+        WifiTxVector txVectorCopy = m_txParams.m_txVector;
+        m_txParams.m_txVector.SetHeMuUserInfo(it->aid,
+                                              {HeRu::RuSpec(ruType, 1, true),
+                                               suTxVector.GetMode().GetMcsValue(),
+                                               suTxVector.GetNss()});
+        if (!GetHeFem(m_linkId)->TryAddMpdu(it->mpdu, m_txParams, availableTime)) {
+            NS_LOG_DEBUG("STA " << it->address << " dropped from candidates: time constraints");
+            m_txParams.m_txVector = txVectorCopy;
+            it = m_candidates.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    if (m_candidates.empty()) {
+        return SU_TX;
+    }
+    NS_LOG_DEBUG("DL MU PPDU with " << m_candidates.size() << " STAs, earliest deadline "
+                 << m_candidates.front().deadline.As(Time::MS));
+    return DL_MU_TX;
+}
+
+MultiUserScheduler::DlMuInfo DeadlineMultiUserScheduler::ComputeDlMuInfo() {
+    DlMuInfo dlMuInfo;
+    if (m_candidates.empty()) {
+        return dlMuInfo;
+    }
+
+    // 最終的な STA 数で RU を割り当て直す（締切順に RU インデックスを付与）
+    std::size_t nStations = m_candidates.size();
+    std::size_t nCentral26TonesRus = 0;
+    auto ruType = HeRu::GetEqualSizedRusForStations(m_allowedWidth, nStations, nCentral26TonesRus);
+    auto ruSet = HeRu::GetRusOfType(m_allowedWidth, ruType);
+    m_candidates.resize(std::min(nStations, ruSet.size()));
+
+    Ptr<WifiRemoteStationManager> manager = GetWifiRemoteStationManager(m_linkId);
+    InitDlMuTxVector(dlMuInfo.txParams.m_txVector);
+    for (std::size_t i = 0; i < m_candidates.size(); i++) {
+        const Candidate& candidate = m_candidates[i];
+        WifiTxVector suTxVector = manager->GetDataTxVector(candidate.mpdu->GetHeader(), m_allowedWidth);
+        dlMuInfo.txParams.m_txVector.SetHeMuUserInfo(candidate.aid,
+                                                     {ruSet[i],
+                                                      suTxVector.GetMode().GetMcsValue(),
+                                                      suTxVector.GetNss()});
+    }
+
+    // 確定した TXVECTOR で送信パラメータを計算し直す
+    Time availableTime = m_initialFrame ? Time::Min() : m_availableTime;
+    for (const auto& candidate : m_candidates) {
+        GetHeFem(m_linkId)->TryAddMpdu(candidate.mpdu, dlMuInfo.txParams, availableTime);
+    }
+
+    // 各 STA 宛の PSDU を A-MPDU 集約して作成
+    for (const auto& candidate : m_candidates) {
+        std::vector<Ptr<WifiMpdu>> mpduList =
+            GetHeFem(m_linkId)->GetMpduAggregator()->GetNextAmpdu(candidate.mpdu, dlMuInfo.txParams, m_availableTime);
+        if (mpduList.size() > 1) {
+            dlMuInfo.psduMap[candidate.aid] = Create<WifiPsdu>(std::move(mpduList));
+        } else {
+            dlMuInfo.psduMap[candidate.aid] = Create<WifiPsdu>(candidate.mpdu, true);
+        }
+    }
+
+    m_candidates.clear();
+    return dlMuInfo;
+}
+
+MultiUserScheduler::UlMuInfo DeadlineMultiUserScheduler::ComputeUlMuInfo() {
+    // UL OFDMA は使用しない
+    return UlMuInfo();
+}
+
+}
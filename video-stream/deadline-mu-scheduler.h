@@ -0,0 +1,50 @@
+#ifndef DEADLINE_MU_SCHEDULER_H
+#define DEADLINE_MU_SCHEDULER_H
+
+#include "ns3/multi-user-scheduler.h"
+#include "ns3/wifi-tx-parameters.h"
+#include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+
+// DeadlineMultiUserScheduler: 締切考慮型の DL OFDMA マルチユーザスケジューラ
+// 各 STA 宛キュー先頭の映像パケットについて、送信側が VideoFrameTag に記録した
+// フレーム送信開始時刻 + 許容遅延を締切とし、締切の近い STA から順に RU を割り当てる。
+// 候補はプライマリ AC とそれより優先度の高い AC の全 TID から選ぶので、AC_VO の I フレームと
+// AC_BE の P/B フレームも締切順に比べられる（STA ごとに 1 TID の A-MPDU を送る）。
+// RU は等サイズ割り当て（中央 26-tone RU は使用しない）、UL OFDMA は扱わない。
+class DeadlineMultiUserScheduler : public MultiUserScheduler {
+public:
+    static TypeId GetTypeId();
+    DeadlineMultiUserScheduler();
+    ~DeadlineMultiUserScheduler() override;
+
+private:
+    TxFormat SelectTxFormat() override;
+    DlMuInfo ComputeDlMuInfo() override;
+    UlMuInfo ComputeUlMuInfo() override;
+
+    // MPDU の締切時刻を取得
+    Time GetDeadline(Ptr<const WifiMpdu> mpdu) const;
+    // DL MU PPDU 用 TXVECTOR の共通部分を設定
+    void InitDlMuTxVector(WifiTxVector& txVector) const;
+
+    // DL MU PPDU の候補 STA
+    struct Candidate {
+        uint16_t aid;
+        Mac48Address address;
+        Ptr<WifiMpdu> mpdu;   // 候補 STA 宛の先頭 MPDU
+        Time deadline;        // 先頭 MPDU の締切
+    };
+
+    uint8_t m_nStations;                  // 1つの DL MU PPDU で割り当てる最大 STA 数
+    Time m_deadline;                      // 許容遅延
+    std::vector<Candidate> m_candidates;  // 締切順に並べた候補 STA
+    WifiTxParameters m_txParams;          // 候補選択時の仮の送信パラメータ
+};
+
+}
+
+#endif // DEADLINE_MU_SCHEDULER_H
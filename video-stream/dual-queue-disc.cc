@@ -0,0 +1,186 @@
+#include "dual-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("DualQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(DualQueueDisc);
+
+TypeId DualQueueDisc::GetTypeId() {
+    static TypeId tid = TypeId("ns3::DualQueueDisc")
+        .SetParent<QueueDisc>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<DualQueueDisc>()
+        .AddAttribute("MaxSize",
+                      "The max queue size (both queues together)",
+                      QueueSizeValue(QueueSize("1000p")),
+                      MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                      MakeQueueSizeChecker())
+        .AddAttribute("Target",
+                      "Target queue delay of the classic queue",
+                      TimeValue(MilliSeconds(15)),
+                      MakeTimeAccessor(&DualQueueDisc::m_target),
+                      MakeTimeChecker())
+        .AddAttribute("Tupdate",
+                      "Update interval of the PI controller",
+                      TimeValue(MilliSeconds(16)),
+                      MakeTimeAccessor(&DualQueueDisc::m_tupdate),
+                      MakeTimeChecker())
+        .AddAttribute("Alpha",
+                      "Integral gain of the PI controller (Hz)",
+                      DoubleValue(0.16),
+                      MakeDoubleAccessor(&DualQueueDisc::m_alpha),
+                      MakeDoubleChecker<double>(0.0))
+        .AddAttribute("Beta",
+                      "Proportional gain of the PI controller (Hz)",
+                      DoubleValue(3.2),
+                      MakeDoubleAccessor(&DualQueueDisc::m_beta),
+                      MakeDoubleChecker<double>(0.0))
+        .AddAttribute("K",
+                      "Coupling factor between the base probability and the L queue marking probability",
+                      DoubleValue(2.0),
+                      MakeDoubleAccessor(&DualQueueDisc::m_k),
+                      MakeDoubleChecker<double>(0.0))
+        .AddAttribute("StepThreshold",
+                      "Sojourn time above which every L queue packet is marked",
+                      TimeValue(MilliSeconds(1)),
+                      MakeTimeAccessor(&DualQueueDisc::m_stepThreshold),
+                      MakeTimeChecker())
+        .AddAttribute("TimeShift",
+                      "Head-of-line wait by which the classic queue may overtake the L queue",
+                      TimeValue(MilliSeconds(30)),
+                      MakeTimeAccessor(&DualQueueDisc::m_timeShift),
+                      MakeTimeChecker());
+    return tid;
+}
+
+DualQueueDisc::DualQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::MULTIPLE_QUEUES), m_alpha(0.16), m_beta(3.2), m_k(2.0), m_baseProb(0.0) {
+    m_uv = CreateObject<UniformRandomVariable>();
+}
+
+DualQueueDisc::~DualQueueDisc() {
+}
+
+int64_t DualQueueDisc::AssignStreams(int64_t stream) {
+    m_uv->SetStream(stream);
+    return 1;
+}
+
+double DualQueueDisc::GetBaseProbability() const {
+    return m_baseProb;
+}
+
+// ECN フィールドが ECT(1) (01) または CE (11) なら L4S
+bool DualQueueDisc::IsL4s(Ptr<const QueueDiscItem> item) {
+    uint8_t tos = 0;
+    if (!item->GetUint8Value(QueueItem::IP_DSFIELD, tos)) {
+        return false;
+    }
+    return (tos & 0x01) != 0;
+}
+
+// キュー 0 = L, 1 = C
+Time DualQueueDisc::GetHeadSojourn(uint32_t queue) const {
+    Ptr<const QueueDiscItem> head = GetInternalQueue(queue)->Peek();
+    if (!head) {
+        return Time(0);
+    }
+    return Simulator::Now() - head->GetTimeStamp();
+}
+
+bool DualQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item) {
+    if (GetCurrentSize() + item > GetMaxSize()) {
+        NS_LOG_LOGIC("Queue full -- dropping pkt");
+        DropBeforeEnqueue(item, LIMIT_EXCEEDED_DROP);
+        return false;
+    }
+    item->SetTimeStamp(Simulator::Now());  // 滞留時間の基準
+    return GetInternalQueue(IsL4s(item) ? 0 : 1)->Enqueue(item);
+}
+
+Ptr<QueueDiscItem> DualQueueDisc::DoDequeue() {
+    while (true) {
+        bool lEmpty = GetInternalQueue(0)->IsEmpty();
+        bool cEmpty = GetInternalQueue(1)->IsEmpty();
+        if (lEmpty && cEmpty) {
+            NS_LOG_LOGIC("Queue empty");
+            return nullptr;
+        }
+
+        // L 優先。C の先頭が L の先頭より TimeShift 以上長く待っていれば C を出す
+        bool fromL = !lEmpty && (cEmpty || GetHeadSojourn(1) <= GetHeadSojourn(0) + m_timeShift);
+        Time sojourn = GetHeadSojourn(fromL ? 0 : 1);
+        Ptr<QueueDiscItem> item = GetInternalQueue(fromL ? 0 : 1)->Dequeue();
+
+        if (fromL) {
+            double markProb = std::min(m_k * m_baseProb, 1.0);
+            if (sojourn > m_stepThreshold || m_uv->GetValue() < markProb) {
+                if (!Mark(item, L4S_MARK)) {
+                    DropAfterDequeue(item, L4S_DROP);
+                    continue;
+                }
+            }
+            return item;
+        }
+
+        if (m_uv->GetValue() < m_baseProb * m_baseProb) {
+            if (!Mark(item, CLASSIC_MARK)) {
+                DropAfterDequeue(item, CLASSIC_DROP);
+                continue;
+            }
+        }
+        return item;
+    }
+}
+
+// p' ← p' + α·(qdelay − target) + β·(qdelay − 前回の qdelay)（[0, 1] に制限）
+void DualQueueDisc::UpdateProbability() {
+    Time qdelay = std::max(GetHeadSojourn(0), GetHeadSojourn(1));
+    m_baseProb += m_alpha * (qdelay - m_target).GetSeconds() + m_beta * (qdelay - m_prevQdelay).GetSeconds();
+    m_baseProb = std::max(0.0, std::min(m_baseProb, 1.0));
+    m_prevQdelay = qdelay;
+    NS_LOG_LOGIC("qdelay " << qdelay.GetMilliSeconds() << " ms, p' " << m_baseProb);
+    m_updateEvent = Simulator::Schedule(m_tupdate, &DualQueueDisc::UpdateProbability, this);
+}
+
+bool DualQueueDisc::CheckConfig() {
+    if (GetNQueueDiscClasses() > 0) {
+        NS_LOG_ERROR("DualQueueDisc cannot have classes");
+        return false;
+    }
+    if (GetNPacketFilters() > 0) {
+        NS_LOG_ERROR("DualQueueDisc needs no packet filter");
+        return false;
+    }
+    if (GetNInternalQueues() == 0) {
+        for (uint32_t i = 0; i < 2; i++) {
+            AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+                "MaxSize", QueueSizeValue(GetMaxSize())));
+        }
+    }
+    if (GetNInternalQueues() != 2) {
+        NS_LOG_ERROR("DualQueueDisc needs 2 internal queues");
+        return false;
+    }
+    return true;
+}
+
+void DualQueueDisc::InitializeParams() {
+    m_baseProb = 0.0;
+    m_prevQdelay = Time(0);
+    m_updateEvent = Simulator::Schedule(m_tupdate, &DualQueueDisc::UpdateProbability, this);
+}
+
+void DualQueueDisc::DoDispose() {
+    m_updateEvent.Cancel();
+    m_uv = nullptr;
+    QueueDisc::DoDispose();
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef DUAL_QUEUE_DISC_H
+#define DUAL_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+// DualQueueDisc: L4S 風の結合デュアルキュー（RFC 9332 の DualPI2 を簡略化したもの）
+// ECN が ECT(1)/CE のパケットを低遅延（L）キュー、それ以外を古典（C）キューに振り分ける。
+// PI 制御器が先頭パケットの滞留時間から基準確率 p' を Tupdate ごとに更新し、
+//   C キュー: 確率 p'^2 で破棄（ECT(0) はマーク）
+//   L キュー: 滞留時間が StepThreshold を超えるか、確率 min(K·p', 1) で CE マーク（非 ECT は破棄）
+// を取り出し時に適用する。スケジューラは L 優先で、C の先頭が L の先頭より TimeShift 以上長く
+// 待っているときだけ C を先に出す（時間シフト FIFO）。
+class DualQueueDisc : public QueueDisc {
+public:
+    static TypeId GetTypeId();
+    DualQueueDisc();
+    ~DualQueueDisc() override;
+
+    // 破棄・マーク理由
+    static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";
+    static constexpr const char* CLASSIC_DROP = "Classic queue PI drop";
+    static constexpr const char* CLASSIC_MARK = "Classic queue PI mark";
+    static constexpr const char* L4S_DROP = "L queue drop of non-ECT packet";
+    static constexpr const char* L4S_MARK = "L queue CE mark";
+
+    int64_t AssignStreams(int64_t stream);
+
+    // 現在の基準確率 p'
+    double GetBaseProbability() const;
+
+private:
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+    void DoDispose() override;
+
+    static bool IsL4s(Ptr<const QueueDiscItem> item);
+    Time GetHeadSojourn(uint32_t queue) const;
+    void UpdateProbability();
+
+    Time m_target;                        // C キューの目標滞留時間
+    Time m_tupdate;                       // PI の更新周期
+    double m_alpha;                       // 積分ゲイン (Hz)
+    double m_beta;                        // 比例ゲイン (Hz)
+    double m_k;                           // L キューへの結合係数
+    Time m_stepThreshold;                 // L キューのステップマーク閾値
+    Time m_timeShift;                     // C キュー保護用の時間シフト
+    double m_baseProb;                    // 基準確率 p'
+    Time m_prevQdelay;                    // 前回更新時の滞留時間
+    EventId m_updateEvent;
+    Ptr<UniformRandomVariable> m_uv;
+};
+
+}
+
+#endif // DUAL_QUEUE_DISC_H
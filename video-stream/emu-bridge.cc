@@ -0,0 +1,374 @@
+#include "emu-bridge.h"
+#include "ns3/realtime-simulator-impl.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("EmuBridge");
+
+// RtpIngressBridge Implementation
+RtpIngressBridge::RtpIngressBridge()
+    : m_hostSocket(-1), m_bridgeFd(-1), m_deviceFd(-1), m_ingressPort(5004), m_dstPort(9), m_tos(0),
+      m_ipBaseSum(0), m_ipId(0), m_running(false), m_rxDatagrams(0), m_rxBytes(0), m_dropped(0) {
+    std::memset(m_template, 0, sizeof(m_template));
+}
+
+RtpIngressBridge::~RtpIngressBridge() {
+    Stop();
+    if (m_bridgeFd >= 0) {
+        close(m_bridgeFd);
+    }
+}
+
+int RtpIngressBridge::CreateDeviceFd() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) < 0) {
+        NS_FATAL_ERROR("socketpair failed: " << std::strerror(errno));
+    }
+    // 50Mbps のバーストを吸収できるよう送受信バッファを拡大
+    int bufSize = 8 * 1024 * 1024;
+    setsockopt(fds[0], SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+    m_deviceFd = fds[0];
+    m_bridgeFd = fds[1];
+    return m_deviceFd;
+}
+
+void RtpIngressBridge::SetIngressPort(uint16_t port) {
+    m_ingressPort = port;
+}
+
+void RtpIngressBridge::SetFrameAddresses(Mac48Address deviceMac, Ipv4Address srcIp, Ipv4Address dstIp,
+                                         uint16_t dstPort, uint8_t tos) {
+    m_deviceMac = deviceMac;
+    m_srcIp = srcIp;
+    m_dstIp = dstIp;
+    m_dstPort = dstPort;
+    m_tos = tos;
+}
+
+// Ethernet/IPv4/UDP ヘッダのテンプレートを作成（可変部: IP全長, IP ID, チェックサム, UDP長）
+void RtpIngressBridge::BuildHeaderTemplate() {
+    uint8_t* eth = m_template;
+    m_deviceMac.CopyTo(eth);                                    // 宛先 MAC
+    const uint8_t srcMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};  // 仮想ホスト（ローカル管理アドレス）
+    std::memcpy(eth + 6, srcMac, 6);
+    eth[12] = 0x08;  // EtherType IPv4
+    eth[13] = 0x00;
+
+    uint8_t* ip = m_template + 14;
+    ip[0] = 0x45;
+    ip[1] = m_tos;
+    ip[6] = 0x40;  // DF
+    ip[8] = 64;    // TTL
+    ip[9] = 17;    // UDP
+    uint32_t src = htonl(m_srcIp.Get());
+    uint32_t dst = htonl(m_dstIp.Get());
+    std::memcpy(ip + 12, &src, 4);
+    std::memcpy(ip + 16, &dst, 4);
+
+    m_ipBaseSum = 0;
+    for (uint32_t i = 0; i < 20; i += 2) {
+        m_ipBaseSum += (ip[i] << 8) | ip[i + 1];
+    }
+
+    uint8_t* udp = m_template + 34;
+    udp[0] = m_ingressPort >> 8;
+    udp[1] = m_ingressPort & 0xff;
+    udp[2] = m_dstPort >> 8;
+    udp[3] = m_dstPort & 0xff;
+    // UDP チェックサム 0（IPv4 では省略可）
+}
+
+void RtpIngressBridge::Start() {
+    NS_ABORT_MSG_IF(m_bridgeFd < 0, "CreateDeviceFd must be called before Start");
+    BuildHeaderTemplate();
+
+    m_hostSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_hostSocket < 0) {
+        NS_FATAL_ERROR("Failed to create ingress socket: " << std::strerror(errno));
+    }
+    int bufSize = 8 * 1024 * 1024;
+    setsockopt(m_hostSocket, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(m_ingressPort);
+    if (bind(m_hostSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        NS_FATAL_ERROR("Failed to bind ingress port " << m_ingressPort << ": " << std::strerror(errno));
+    }
+
+    m_running = true;
+    m_thread = std::thread(&RtpIngressBridge::ReadLoop, this);
+    NS_LOG_INFO("RTP ingress bridge listening on 127.0.0.1:" << m_ingressPort);
+}
+
+void RtpIngressBridge::Stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    close(m_hostSocket);
+    m_hostSocket = -1;
+}
+
+void RtpIngressBridge::ReadLoop() {
+    // バッチ単位のバッファはスレッド開始時に一度だけ確保
+    std::vector<uint8_t> payloads(BATCH * (MAX_PAYLOAD + 1));
+    std::vector<uint8_t> headers(BATCH * HEADER_SIZE);
+    std::vector<mmsghdr> inMsgs(BATCH);
+    std::vector<iovec> inIov(BATCH);
+    std::vector<mmsghdr> outMsgs(BATCH);
+    std::vector<iovec> outIov(BATCH * 2);
+    std::vector<uint8_t> discard(2048);
+
+    for (uint32_t i = 0; i < BATCH; i++) {
+        inIov[i].iov_base = &payloads[i * (MAX_PAYLOAD + 1)];
+        inIov[i].iov_len = MAX_PAYLOAD + 1;  // 1 バイト多く受けて MTU 超過を検出
+        std::memset(&inMsgs[i], 0, sizeof(mmsghdr));
+        inMsgs[i].msg_hdr.msg_iov = &inIov[i];
+        inMsgs[i].msg_hdr.msg_iovlen = 1;
+        std::memcpy(&headers[i * HEADER_SIZE], m_template, HEADER_SIZE);
+    }
+
+    pollfd fds[2];
+    fds[0].fd = m_hostSocket;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_bridgeFd;
+    fds[1].events = POLLIN;
+
+    while (m_running) {
+        if (poll(fds, 2, 10) <= 0) {
+            continue;
+        }
+
+        // FdNetDevice 側からの送信（ARP など）は読み捨てる
+        if (fds[1].revents & POLLIN) {
+            while (recv(m_bridgeFd, discard.data(), discard.size(), MSG_DONTWAIT) > 0) {
+            }
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        int n = recvmmsg(m_hostSocket, inMsgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            continue;
+        }
+
+        uint32_t nOut = 0;
+        for (int i = 0; i < n; i++) {
+            uint32_t len = inMsgs[i].msg_len;
+            if (len > MAX_PAYLOAD) {
+                m_dropped++;  // MTU を超えるデータグラムは破棄
+                continue;
+            }
+            m_rxDatagrams++;
+            m_rxBytes += len;
+
+            // 可変フィールドのみ書き換え、IPv4 チェックサムは差分で計算
+            uint8_t* hdr = &headers[i * HEADER_SIZE];
+            uint16_t ipLen = 20 + 8 + len;
+            uint16_t udpLen = 8 + len;
+            uint16_t ipId = m_ipId++;
+            hdr[16] = ipLen >> 8;
+            hdr[17] = ipLen & 0xff;
+            hdr[18] = ipId >> 8;
+            hdr[19] = ipId & 0xff;
+            uint32_t sum = m_ipBaseSum + ipLen + ipId;
+            sum = (sum & 0xffff) + (sum >> 16);
+            sum = (sum & 0xffff) + (sum >> 16);
+            uint16_t checksum = ~sum & 0xffff;
+            hdr[24] = checksum >> 8;
+            hdr[25] = checksum & 0xff;
+            hdr[38] = udpLen >> 8;
+            hdr[39] = udpLen & 0xff;
+
+            outIov[nOut * 2].iov_base = hdr;
+            outIov[nOut * 2].iov_len = HEADER_SIZE;
+            outIov[nOut * 2 + 1].iov_base = inIov[i].iov_base;
+            outIov[nOut * 2 + 1].iov_len = len;
+            std::memset(&outMsgs[nOut], 0, sizeof(mmsghdr));
+            outMsgs[nOut].msg_hdr.msg_iov = &outIov[nOut * 2];
+            outMsgs[nOut].msg_hdr.msg_iovlen = 2;
+            nOut++;
+        }
+
+        uint32_t sent = 0;
+        while (sent < nOut) {
+            int ret = sendmmsg(m_bridgeFd, &outMsgs[sent], nOut - sent, MSG_DONTWAIT);
+            if (ret <= 0) {
+                // FdNetDevice 側が追いつかない: 残りは破棄して計上
+                m_dropped += nOut - sent;
+                break;
+            }
+            sent += ret;
+        }
+    }
+}
+
+uint64_t RtpIngressBridge::GetRxDatagrams() const { return m_rxDatagrams; }
+uint64_t RtpIngressBridge::GetRxBytes() const { return m_rxBytes; }
+uint64_t RtpIngressBridge::GetDroppedDatagrams() const { return m_dropped; }
+
+// RtpEgressApplication Implementation
+TypeId RtpEgressApplication::GetTypeId() {
+    static TypeId tid = TypeId("ns3::RtpEgressApplication")
+        .SetParent<Application>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<RtpEgressApplication>();
+    return tid;
+}
+
+RtpEgressApplication::RtpEgressApplication()
+    : m_port(9), m_egressHost("127.0.0.1"), m_egressPort(5006), m_hostSocket(-1), m_buffer(65536),
+      m_rxPackets(0), m_rxBytes(0), m_egressDrops(0), m_seqValid(false), m_expectedSeq(0),
+      m_rtpLost(0), m_rtpReordered(0) {
+}
+
+RtpEgressApplication::~RtpEgressApplication() {
+}
+
+void RtpEgressApplication::SetPort(uint16_t port) {
+    m_port = port;
+}
+
+void RtpEgressApplication::SetEgressAddress(std::string host, uint16_t port) {
+    m_egressHost = host;
+    m_egressPort = port;
+}
+
+void RtpEgressApplication::StartApplication() {
+    if (m_socket == nullptr) {
+        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+        m_socket = Socket::CreateSocket(GetNode(), tid);
+        if (m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_port)) == -1) {
+            NS_FATAL_ERROR("Failed to bind socket");
+        }
+        m_socket->SetAttribute("RcvBufSize", UintegerValue(1048576));
+        m_socket->SetRecvCallback(MakeCallback(&RtpEgressApplication::HandleRead, this));
+    }
+
+    // ホスト側の送り返し先（ノンブロッキング: シミュレーションスレッドを止めない）
+    m_hostSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (m_hostSocket < 0) {
+        NS_FATAL_ERROR("Failed to create egress socket: " << std::strerror(errno));
+    }
+    int bufSize = 8 * 1024 * 1024;
+    setsockopt(m_hostSocket, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_egressPort);
+    inet_pton(AF_INET, m_egressHost.c_str(), &addr.sin_addr);
+    if (connect(m_hostSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        NS_FATAL_ERROR("Failed to connect egress socket: " << std::strerror(errno));
+    }
+    NS_LOG_INFO("RTP egress to " << m_egressHost << ":" << m_egressPort);
+}
+
+void RtpEgressApplication::StopApplication() {
+    if (m_socket) {
+        m_socket->Close();
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+    if (m_hostSocket >= 0) {
+        close(m_hostSocket);
+        m_hostSocket = -1;
+    }
+}
+
+void RtpEgressApplication::HandleRead(Ptr<Socket> socket) {
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv())) {
+        uint32_t size = packet->CopyData(m_buffer.data(), m_buffer.size());
+        m_rxPackets++;
+        m_rxBytes += size;
+
+        if (send(m_hostSocket, m_buffer.data(), size, MSG_DONTWAIT) < 0) {
+            m_egressDrops++;
+        }
+
+        // RTP (version 2) のシーケンス番号でロスと順序逆転を検出
+        if (size >= 12 && (m_buffer[0] >> 6) == 2) {
+            uint16_t seq = (m_buffer[2] << 8) | m_buffer[3];
+            if (m_seqValid) {
+                int16_t diff = static_cast<int16_t>(seq - m_expectedSeq);
+                if (diff > 0) {
+                    m_rtpLost += diff;
+                } else if (diff < 0) {
+                    m_rtpReordered++;
+                    if (m_rtpLost > 0) {
+                        m_rtpLost--;  // 遅れて届いたパケットはロスから除外
+                    }
+                    continue;
+                }
+            }
+            m_seqValid = true;
+            m_expectedSeq = seq + 1;
+        }
+    }
+}
+
+uint64_t RtpEgressApplication::GetRxPackets() const { return m_rxPackets; }
+uint64_t RtpEgressApplication::GetRxBytes() const { return m_rxBytes; }
+uint64_t RtpEgressApplication::GetEgressDrops() const { return m_egressDrops; }
+uint64_t RtpEgressApplication::GetRtpLost() const { return m_rtpLost; }
+uint64_t RtpEgressApplication::GetRtpReordered() const { return m_rtpReordered; }
+
+// RealtimeLagMonitor Implementation
+RealtimeLagMonitor::RealtimeLagMonitor()
+    : m_probes(0), m_missed(0) {
+}
+
+void RealtimeLagMonitor::Start(Time interval, Time tolerance) {
+    m_interval = interval;
+    m_tolerance = tolerance;
+    m_event = Simulator::Schedule(m_interval, &RealtimeLagMonitor::Probe, this);
+}
+
+void RealtimeLagMonitor::Stop() {
+    Simulator::Cancel(m_event);
+}
+
+void RealtimeLagMonitor::Probe() {
+    Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl>(Simulator::GetImplementation());
+    NS_ABORT_MSG_IF(impl == nullptr, "RealtimeLagMonitor requires ns3::RealtimeSimulatorImpl");
+
+    // このイベントの予定時刻（= 現在のシミュレーション時刻）に対する実時間の遅れ
+    Time lag = impl->RealtimeNow() - Simulator::Now();
+    if (lag.IsStrictlyNegative()) {
+        lag = Time(0);
+    }
+    m_probes++;
+    m_totalLag += lag;
+    if (lag > m_maxLag) {
+        m_maxLag = lag;
+    }
+    if (lag > m_tolerance) {
+        m_missed++;
+        NS_LOG_WARN("Real-time deadline missed by " << lag.As(Time::MS) << " at " << Simulator::Now().As(Time::S));
+    }
+    m_event = Simulator::Schedule(m_interval, &RealtimeLagMonitor::Probe, this);
+}
+
+uint64_t RealtimeLagMonitor::GetProbes() const { return m_probes; }
+uint64_t RealtimeLagMonitor::GetMissedDeadlines() const { return m_missed; }
+Time RealtimeLagMonitor::GetMaxLag() const { return m_maxLag; }
+Time RealtimeLagMonitor::GetMeanLag() const {
+    return m_probes > 0 ? NanoSeconds(m_totalLag.GetNanoSeconds() / static_cast<int64_t>(m_probes)) : Time(0);
+}
+
+}
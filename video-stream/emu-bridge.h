@@ -0,0 +1,130 @@
+#ifndef EMU_BRIDGE_H
+#define EMU_BRIDGE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+// RtpIngressBridge: ローカルプロセスの RTP/UDP ストリームを FdNetDevice に注入するブリッジ
+// ホストの UDP ソケット (127.0.0.1:ingressPort) で受信したデータグラムを
+// Ethernet/IPv4/UDP でカプセル化し、socketpair 経由で FdNetDevice へ書き込む。
+// 受信・書き込みは専用スレッドで recvmmsg/sendmmsg によりまとめて行い、
+// ヘッダはテンプレートから差分計算するだけなのでパケットごとの確保は発生しない。
+class RtpIngressBridge : public SimpleRefCount<RtpIngressBridge> {
+public:
+    RtpIngressBridge();
+    ~RtpIngressBridge();
+
+    // FdNetDevice に渡すファイルディスクリプタ（socketpair の片側）を作成
+    int CreateDeviceFd();
+    void SetIngressPort(uint16_t port);
+    // 注入フレームの宛先（FdNetDevice の MAC と、転送先 STA の IP/ポート）
+    void SetFrameAddresses(Mac48Address deviceMac, Ipv4Address srcIp, Ipv4Address dstIp,
+                           uint16_t dstPort, uint8_t tos);
+    void Start();
+    void Stop();
+
+    uint64_t GetRxDatagrams() const;
+    uint64_t GetRxBytes() const;
+    uint64_t GetDroppedDatagrams() const;
+
+private:
+    void ReadLoop();
+    void BuildHeaderTemplate();
+
+    static constexpr uint32_t HEADER_SIZE = 14 + 20 + 8;  // Ethernet + IPv4 + UDP
+    static constexpr uint32_t MAX_PAYLOAD = 1500 - 20 - 8;
+    static constexpr uint32_t BATCH = 64;
+
+    int m_hostSocket;     // ローカルプロセスからの受信用
+    int m_bridgeFd;       // socketpair のブリッジ側
+    int m_deviceFd;       // socketpair の FdNetDevice 側
+    uint16_t m_ingressPort;
+    Mac48Address m_deviceMac;
+    Ipv4Address m_srcIp;
+    Ipv4Address m_dstIp;
+    uint16_t m_dstPort;
+    uint8_t m_tos;
+    uint8_t m_template[HEADER_SIZE];
+    uint32_t m_ipBaseSum;  // 可変フィールドを除いた IPv4 ヘッダの部分チェックサム
+    uint16_t m_ipId;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_rxDatagrams;
+    std::atomic<uint64_t> m_rxBytes;
+    std::atomic<uint64_t> m_dropped;
+};
+
+// RtpEgressApplication: STA で受信したパケットをホストの UDP ソケットへ送り返すアプリ
+// RTP ヘッダのシーケンス番号からロス・順序逆転も集計する
+class RtpEgressApplication : public Application {
+public:
+    static TypeId GetTypeId();
+    RtpEgressApplication();
+    ~RtpEgressApplication() override;
+
+    void SetPort(uint16_t port);
+    void SetEgressAddress(std::string host, uint16_t port);
+
+    uint64_t GetRxPackets() const;
+    uint64_t GetRxBytes() const;
+    uint64_t GetEgressDrops() const;
+    uint64_t GetRtpLost() const;
+    uint64_t GetRtpReordered() const;
+
+private:
+    void StartApplication() override;
+    void StopApplication() override;
+    void HandleRead(Ptr<Socket> socket);
+
+    Ptr<Socket> m_socket;
+    uint16_t m_port;
+    std::string m_egressHost;
+    uint16_t m_egressPort;
+    int m_hostSocket;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_rxPackets;
+    uint64_t m_rxBytes;
+    uint64_t m_egressDrops;
+    bool m_seqValid;
+    uint16_t m_expectedSeq;
+    uint64_t m_rtpLost;
+    uint64_t m_rtpReordered;
+};
+
+// RealtimeLagMonitor: リアルタイム実行の遅れを一定間隔で計測
+// 壁時計とシミュレーション時刻の差が許容値を超えたプローブを「締切超過」として数える
+class RealtimeLagMonitor : public SimpleRefCount<RealtimeLagMonitor> {
+public:
+    RealtimeLagMonitor();
+
+    void Start(Time interval, Time tolerance);
+    void Stop();
+
+    uint64_t GetProbes() const;
+    uint64_t GetMissedDeadlines() const;
+    Time GetMaxLag() const;
+    Time GetMeanLag() const;
+
+private:
+    void Probe();
+
+    Time m_interval;
+    Time m_tolerance;
+    EventId m_event;
+    uint64_t m_probes;
+    uint64_t m_missed;
+    Time m_maxLag;
+    Time m_totalLag;
+};
+
+}
+
+#endif // EMU_BRIDGE_H
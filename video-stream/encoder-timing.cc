@@ -0,0 +1,57 @@
+#include "encoder-timing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+EncoderTimingModel::EncoderTimingModel() : m_decodeTime(MilliSeconds(3)) {
+    // 1080p のハードウェア符号化器程度（I > P > B）
+    m_meanEncode[0] = MilliSeconds(12);
+    m_meanEncode[1] = MilliSeconds(7);
+    m_meanEncode[2] = MilliSeconds(5);
+    for (double& cv : m_cv) {
+        cv = 0.2;
+    }
+    m_normal = CreateObject<NormalRandomVariable>();
+    m_normal->SetAttribute("Mean", DoubleValue(0.0));
+    m_normal->SetAttribute("Variance", DoubleValue(1.0));
+}
+
+void EncoderTimingModel::SetEncodeTime(uint32_t frameType, Time mean, double cv) {
+    NS_ABORT_MSG_IF(frameType > 2, "Unknown frame type " << frameType);
+    NS_ABORT_MSG_IF(mean.IsNegative() || cv < 0.0, "Invalid encode time distribution");
+    m_meanEncode[frameType] = mean;
+    m_cv[frameType] = cv;
+}
+
+void EncoderTimingModel::SetDecodeTime(Time decodeTime) {
+    m_decodeTime = decodeTime;
+}
+
+int64_t EncoderTimingModel::AssignStreams(int64_t stream) {
+    m_normal->SetStream(stream);
+    return 1;
+}
+
+// 対数正規分布: σ² = ln(1 + cv²), μ = ln(平均) - σ²/2 として平均を保つ
+Time EncoderTimingModel::SampleEncodeTime(uint32_t frameType) {
+    double meanUs = m_meanEncode[std::min(frameType, 2u)].GetMicroSeconds();
+    double cv = m_cv[std::min(frameType, 2u)];
+    if (meanUs <= 0.0 || cv == 0.0) {
+        return MicroSeconds(static_cast<int64_t>(meanUs));
+    }
+    double sigma2 = std::log(1.0 + cv * cv);
+    double mu = std::log(meanUs) - sigma2 / 2.0;
+    return MicroSeconds(static_cast<int64_t>(std::exp(mu + std::sqrt(sigma2) * m_normal->GetValue())));
+}
+
+Time EncoderTimingModel::GetDecodeTime() const {
+    return m_decodeTime;
+}
+
+Time EncoderTimingModel::GetMeanEncodeTime(uint32_t frameType) const {
+    return m_meanEncode[std::min(frameType, 2u)];
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef ENCODER_TIMING_H
+#define ENCODER_TIMING_H
+
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// EncoderTimingModel: フレームタイプ別の符号化時間と復号時間
+// 符号化時間はフレームタイプごとの平均と変動係数から対数正規分布で引く（長い裾を持つ）。
+// 符号化器は 1 つだけで、前のフレームの符号化が終わるまで次のフレームは待たされる
+// （高フレームレートで I フレームの符号化がフレーム間隔を超えると待ちが積み上がる）。
+// スライス分割時は各スライスがフレームの符号化時間を等分して順に完成するとみなす。
+// 復号時間はフレームタイプによらず一定で、スライス分割時はスライス数で等分する。
+class EncoderTimingModel : public SimpleRefCount<EncoderTimingModel> {
+public:
+    EncoderTimingModel();
+
+    void SetEncodeTime(uint32_t frameType, Time mean, double cv);
+    void SetDecodeTime(Time decodeTime);
+    int64_t AssignStreams(int64_t stream);
+
+    Time SampleEncodeTime(uint32_t frameType);
+    Time GetDecodeTime() const;
+    Time GetMeanEncodeTime(uint32_t frameType) const;
+
+private:
+    Time m_meanEncode[3];  // 0=I, 1=P, 2=B
+    double m_cv[3];
+    Time m_decodeTime;
+    Ptr<NormalRandomVariable> m_normal;
+};
+
+}
+
+#endif // ENCODER_TIMING_H
@@ -0,0 +1,230 @@
+#include "flow-stats-store.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <iomanip>
+#include <new>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("FlowStatsStore");
+
+FrameRecordPool::FrameRecordPool(size_t blocksPerSlab)
+    : m_blockSize(0), m_blocksPerSlab(blocksPerSlab), m_freeList(nullptr), m_blocksInUse(0) {
+    NS_ABORT_MSG_IF(blocksPerSlab == 0, "FrameRecordPool needs at least one block per slab");
+}
+
+FrameRecordPool::~FrameRecordPool() {
+    if (m_blocksInUse > 0) {
+        NS_LOG_WARN(m_blocksInUse << " frame record(s) still in use when the pool is destroyed");
+    }
+    for (void* slab : m_slabs) {
+        ::operator delete(slab);
+    }
+}
+
+size_t FrameRecordPool::RoundUp(size_t bytes) {
+    const size_t align = alignof(std::max_align_t);
+    bytes = std::max(bytes, sizeof(void*));
+    return (bytes + align - 1) / align * align;
+}
+
+void FrameRecordPool::AddSlab() {
+    char* slab = static_cast<char*>(::operator new(m_blockSize * m_blocksPerSlab));
+    m_slabs.push_back(slab);
+    // 末尾から積んで、先頭のブロックから順に払い出す
+    for (size_t i = m_blocksPerSlab; i > 0; i--) {
+        void* block = slab + (i - 1) * m_blockSize;
+        *static_cast<void**>(block) = m_freeList;
+        m_freeList = block;
+    }
+}
+
+void* FrameRecordPool::Allocate(size_t bytes) {
+    size_t size = RoundUp(bytes);
+    if (m_blockSize == 0) {
+        m_blockSize = size;
+    }
+    if (size != m_blockSize) {
+        return ::operator new(bytes);
+    }
+    if (!m_freeList) {
+        AddSlab();
+    }
+    void* block = m_freeList;
+    m_freeList = *static_cast<void**>(block);
+    m_blocksInUse++;
+    return block;
+}
+
+void FrameRecordPool::Deallocate(void* p, size_t bytes) {
+    if (!p) {
+        return;
+    }
+    if (RoundUp(bytes) != m_blockSize) {
+        ::operator delete(p);
+        return;
+    }
+    *static_cast<void**>(p) = m_freeList;
+    m_freeList = p;
+    m_blocksInUse--;
+}
+
+size_t FrameRecordPool::GetBlocksInUse() const {
+    return m_blocksInUse;
+}
+
+size_t FrameRecordPool::GetSlabs() const {
+    return m_slabs.size();
+}
+
+size_t FrameRecordPool::GetBlockSize() const {
+    return m_blockSize;
+}
+
+FlowStatsStore::FlowStatsStore() : m_logFlowId(true), m_lastLogTime(-1.0), m_lastFlushTime(-1.0) {
+}
+
+FlowStatsStore::~FlowStatsStore() {
+    ClosePacketLog();
+}
+
+uint32_t FlowStatsStore::AddFlow() {
+    uint32_t flowId = static_cast<uint32_t>(m_rxPackets.size());
+    m_rxPackets.push_back(0);
+    m_rxBytes.push_back(0);
+    m_duplicatePackets.push_back(0);
+    m_liveRxPackets.push_back(0);
+    m_liveRxBytes.push_back(0);
+    m_firstRxTime.push_back(-1.0);
+    m_lastRxTime.push_back(-1.0);
+    return flowId;
+}
+
+uint32_t FlowStatsStore::GetNFlows() const {
+    return static_cast<uint32_t>(m_rxPackets.size());
+}
+
+void FlowStatsStore::RecordPacket(uint32_t flowId, uint32_t bytes, double rxTime) {
+    m_rxPackets[flowId]++;
+    m_rxBytes[flowId] += bytes;
+    m_liveRxPackets[flowId]++;
+    m_liveRxBytes[flowId] += bytes;
+    if (m_firstRxTime[flowId] < 0) {
+        m_firstRxTime[flowId] = rxTime;
+    }
+    m_lastRxTime[flowId] = rxTime;
+}
+
+void FlowStatsStore::RecordDuplicate(uint32_t flowId) {
+    m_duplicatePackets[flowId]++;
+}
+
+void FlowStatsStore::TakeLiveCounters(uint32_t flowId, uint64_t& packets, uint64_t& bytes) {
+    packets = m_liveRxPackets[flowId];
+    bytes = m_liveRxBytes[flowId];
+    m_liveRxPackets[flowId] = 0;
+    m_liveRxBytes[flowId] = 0;
+}
+
+uint64_t FlowStatsStore::GetRxPackets(uint32_t flowId) const {
+    return m_rxPackets[flowId];
+}
+
+uint64_t FlowStatsStore::GetRxBytes(uint32_t flowId) const {
+    return m_rxBytes[flowId];
+}
+
+uint64_t FlowStatsStore::GetDuplicatePackets(uint32_t flowId) const {
+    return m_duplicatePackets[flowId];
+}
+
+FrameRecordPool* FlowStatsStore::GetFramePool() {
+    return &m_framePool;
+}
+
+bool FlowStatsStore::OpenPacketLog(const std::string& filename, bool withFlowId) {
+    ClosePacketLog();
+    m_packetLog.open(filename);
+    if (!m_packetLog.is_open()) {
+        NS_LOG_ERROR("Failed to open packet log file: " << filename);
+        return false;
+    }
+    m_logFlowId = withFlowId;
+    m_lastLogTime = -1.0;
+    m_lastFlushTime = -1.0;
+    m_logBuffer.reserve(LOG_BUFFER_BYTES + 256);
+    m_logBuffer = "TxTime(sec),RxTime(sec),Latency(ms),FrameID,FrameType,PacketIndex,TotalPackets,FwdRef,BwdRef,"
+                  "SendTime(sec)";
+    m_logBuffer += withFlowId ? ",FlowID\n" : "\n";
+    return true;
+}
+
+void FlowStatsStore::LogPacket(uint32_t flowId, uint32_t frameId, uint32_t frameType, uint32_t packetIndex,
+                               uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef,
+                               double sendTime) {
+    if (!m_packetLog.is_open()) {
+        return;
+    }
+    static const char* const typeNames[] = {"I", "P", "B"};
+    const char* typeName = frameType < 3 ? typeNames[frameType] : "?";
+    char line[192];
+    int n = m_logFlowId
+        ? std::snprintf(line, sizeof(line), "%.6f,%.6f,%.3f,%u,%s,%u,%u,%d,%d,%.6f,%u\n",
+                        txTime, rxTime, (rxTime - txTime) * 1000.0, frameId, typeName,
+                        packetIndex, totalPackets, fwdRef, bwdRef, sendTime, flowId)
+        : std::snprintf(line, sizeof(line), "%.6f,%.6f,%.3f,%u,%s,%u,%u,%d,%d,%.6f\n",
+                        txTime, rxTime, (rxTime - txTime) * 1000.0, frameId, typeName,
+                        packetIndex, totalPackets, fwdRef, bwdRef, sendTime);
+    if (n > 0) {
+        m_logBuffer.append(line, std::min(static_cast<size_t>(n), sizeof(line) - 1));
+    }
+    m_lastLogTime = rxTime;
+    if (m_lastFlushTime < 0.0) {
+        m_lastFlushTime = rxTime;
+    }
+    if (m_logBuffer.size() >= LOG_BUFFER_BYTES || rxTime - m_lastFlushTime >= LOG_FLUSH_INTERVAL) {
+        FlushPacketLog();
+    }
+}
+
+void FlowStatsStore::FlushPacketLog() {
+    if (!m_packetLog.is_open() || m_logBuffer.empty()) {
+        return;
+    }
+    m_packetLog.write(m_logBuffer.data(), static_cast<std::streamsize>(m_logBuffer.size()));
+    m_packetLog.flush();
+    m_logBuffer.clear();
+    m_lastFlushTime = m_lastLogTime;
+}
+
+void FlowStatsStore::ClosePacketLog() {
+    if (!m_packetLog.is_open()) {
+        return;
+    }
+    FlushPacketLog();
+    m_packetLog.close();
+}
+
+void FlowStatsStore::WriteFlowTable(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        NS_LOG_ERROR("Failed to open flow table file: " << filename);
+        return;
+    }
+    out << "FlowID,RxPackets,RxBytes,DuplicatePackets,FirstRx(sec),LastRx(sec),Throughput(Mbps)\n";
+    out << std::fixed;
+    for (uint32_t flowId = 0; flowId < GetNFlows(); flowId++) {
+        double span = m_lastRxTime[flowId] - m_firstRxTime[flowId];
+        double mbps = (m_firstRxTime[flowId] >= 0 && span > 0) ? m_rxBytes[flowId] * 8.0 / span / 1e6 : 0.0;
+        out << flowId << "," << m_rxPackets[flowId] << "," << m_rxBytes[flowId] << ","
+            << m_duplicatePackets[flowId] << ","
+            << std::setprecision(6) << m_firstRxTime[flowId] << "," << m_lastRxTime[flowId] << ","
+            << std::setprecision(3) << mbps << "\n";
+    }
+}
+
+}
@@ -0,0 +1,152 @@
+#ifndef FLOW_STATS_STORE_H
+#define FLOW_STATS_STORE_H
+
+#include "ns3/simple-ref-count.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ns3 {
+
+// FrameRecordPool: フレーム統計レコード（受信側の map のノード）を固定サイズのブロックとしてスラブから切り出すプール
+// ブロックサイズは最初の確保で決まり、それ以外のサイズの要求は通常のヒープに回す。
+// 解放したブロックはフリーリストで再利用し、スラブはプールの破棄までまとめて保持する。
+class FrameRecordPool {
+public:
+    explicit FrameRecordPool(size_t blocksPerSlab = 1024);
+    ~FrameRecordPool();
+
+    FrameRecordPool(const FrameRecordPool&) = delete;
+    FrameRecordPool& operator=(const FrameRecordPool&) = delete;
+
+    void* Allocate(size_t bytes);
+    void Deallocate(void* p, size_t bytes);
+
+    size_t GetBlocksInUse() const;
+    size_t GetSlabs() const;
+    size_t GetBlockSize() const;
+
+private:
+    static size_t RoundUp(size_t bytes);
+    void AddSlab();
+
+    size_t m_blockSize;      // 0 = 未確定
+    size_t m_blocksPerSlab;
+    std::vector<void*> m_slabs;
+    void* m_freeList;        // 空きブロックの単方向リスト（ブロック先頭に次のブロックを書く）
+    size_t m_blocksInUse;
+};
+
+// FramePoolAllocator: FrameRecordPool から 1 要素ずつ確保するアロケータ（プールなしなら通常のヒープ）
+// ムーブ代入・swap でプールも移るので、空の map を別プールの map で置き換えられる。
+template <class T>
+class FramePoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    FramePoolAllocator() noexcept : m_pool(nullptr) {}
+    explicit FramePoolAllocator(FrameRecordPool* pool) noexcept : m_pool(pool) {}
+    template <class U>
+    FramePoolAllocator(const FramePoolAllocator<U>& other) noexcept : m_pool(other.GetPool()) {}
+
+    T* allocate(size_t n) {
+        if (m_pool && n == 1) {
+            return static_cast<T*>(m_pool->Allocate(sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (m_pool && n == 1) {
+            m_pool->Deallocate(p, sizeof(T));
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    FrameRecordPool* GetPool() const noexcept {
+        return m_pool;
+    }
+
+private:
+    FrameRecordPool* m_pool;
+};
+
+template <class T, class U>
+bool operator==(const FramePoolAllocator<T>& a, const FramePoolAllocator<U>& b) {
+    return a.GetPool() == b.GetPool();
+}
+
+template <class T, class U>
+bool operator!=(const FramePoolAllocator<T>& a, const FramePoolAllocator<U>& b) {
+    return a.GetPool() != b.GetPool();
+}
+
+// FlowStatsStore: 全受信アプリで共有するフロー統計の置き場
+// フロー単位のカウンタはフローIDを添字とする配列ごとに持ち（structure of arrays）、
+// 毎パケットの更新は配列要素の加算だけで済む。フレーム統計レコードは共有プールから確保する。
+// パケットログは全フローで 1 本のファイル（複数フローなら末尾に FlowID 列）にまとめ、メモリ上のバッファが
+// 一定量たまったとき、または前回の書き出しから一定のシミュレーション時間が経ったときに書き出すので、
+// フロー数が増えてもファイルハンドルは 1 つで済み、途中で異常終了しても失うのは直近の分だけになる。
+class FlowStatsStore : public SimpleRefCount<FlowStatsStore> {
+public:
+    FlowStatsStore();
+    ~FlowStatsStore();
+
+    // フローを登録して ID を返す（0 から連番）
+    uint32_t AddFlow();
+    uint32_t GetNFlows() const;
+
+    // 受信（重複を除く）と重複受信の記録
+    void RecordPacket(uint32_t flowId, uint32_t bytes, double rxTime);
+    void RecordDuplicate(uint32_t flowId);
+    // 前回呼び出し以降のパケット数・バイト数を取得してリセット（ライブメトリクス用）
+    void TakeLiveCounters(uint32_t flowId, uint64_t& packets, uint64_t& bytes);
+
+    uint64_t GetRxPackets(uint32_t flowId) const;
+    uint64_t GetRxBytes(uint32_t flowId) const;
+    uint64_t GetDuplicatePackets(uint32_t flowId) const;
+
+    FrameRecordPool* GetFramePool();
+
+    // 全フロー共通のパケットログ（withFlowId = false なら 1 フロー用で FlowID 列なし）
+    bool OpenPacketLog(const std::string& filename, bool withFlowId = true);
+    // txTime はフレームの送信開始、sendTime はパケット自身の送信時刻（秒）
+    void LogPacket(uint32_t flowId, uint32_t frameId, uint32_t frameType, uint32_t packetIndex,
+                   uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef,
+                   double sendTime);
+    void FlushPacketLog();
+    void ClosePacketLog();
+
+    // フロー単位のカウンタを 1 ファイルに出力
+    void WriteFlowTable(const std::string& filename) const;
+
+private:
+    static const size_t LOG_BUFFER_BYTES = 1 << 20;
+    static constexpr double LOG_FLUSH_INTERVAL = 1.0;  // 書き出しの最大間隔 (シミュレーション秒)
+
+    // フロー単位のカウンタ（添字 = フローID）
+    std::vector<uint64_t> m_rxPackets;
+    std::vector<uint64_t> m_rxBytes;
+    std::vector<uint64_t> m_duplicatePackets;
+    std::vector<uint64_t> m_liveRxPackets;
+    std::vector<uint64_t> m_liveRxBytes;
+    std::vector<double> m_firstRxTime;  // 最初の受信時刻 (秒, -1=未受信)
+    std::vector<double> m_lastRxTime;
+
+    FrameRecordPool m_framePool;
+    std::ofstream m_packetLog;
+    std::string m_logBuffer;
+    bool m_logFlowId;       // FlowID 列を出力するか
+    double m_lastLogTime;   // 最後に記録したパケットの受信時刻 (秒)
+    double m_lastFlushTime; // 最後に書き出したときの受信時刻 (秒, -1=未記録)
+};
+
+}
+
+#endif // FLOW_STATS_STORE_H
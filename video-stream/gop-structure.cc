@@ -0,0 +1,182 @@
+#include "gop-structure.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+
+GopStructure::GopStructure(GopMode mode, uint32_t gopSize, uint32_t bFrames, bool openGop)
+    : m_mode(mode), m_gopSize(gopSize), m_bFrames(bFrames), m_openGop(openGop), m_reorderDepth(0) {
+    NS_ABORT_MSG_IF(gopSize == 0, "gopSize must be at least 1");
+    if (m_mode == GOP_IPPP || m_mode == GOP_INTRA_REFRESH) {
+        m_bFrames = 0;
+    }
+    if (m_bFrames == 0) {
+        m_openGop = false;
+    }
+
+    m_type.assign(m_gopSize, 2);
+    m_fwdPos.assign(m_gopSize, -1);
+    m_bwdPos.assign(m_gopSize, -1);
+    m_isRef.assign(m_gopSize, 0);
+
+    // アンカー（I/P）の位置: B フレーム数ごとに 1 枚。closed GOP では GOP 末尾も P にする
+    const uint32_t anchorInterval = m_bFrames + 1;
+    std::vector<uint32_t> anchors;
+    for (uint32_t pos = 0; pos < m_gopSize; pos += anchorInterval) {
+        anchors.push_back(pos);
+    }
+    if (!m_openGop && anchors.back() != m_gopSize - 1) {
+        anchors.push_back(m_gopSize - 1);
+    }
+
+    for (size_t i = 0; i < anchors.size(); i++) {
+        uint32_t pos = anchors[i];
+        m_type[pos] = (i == 0 && m_mode != GOP_INTRA_REFRESH) ? 0 : 1;
+        m_fwdPos[pos] = (i == 0) ? -1 : static_cast<int32_t>(anchors[i - 1]);
+        m_isRef[pos] = 1;
+    }
+
+    // デコード順: アンカーの直後に、そのアンカーを後方参照する B を並べる
+    // open GOP の末尾 B は次 GOP の I の直後（負のオフセット）でデコードされる
+    std::vector<int32_t> trailing;
+    BuildSegment(anchors.back(), m_gopSize, trailing);
+    m_decodeOrder.push_back(0);
+    for (int32_t offset : trailing) {
+        m_decodeOrder.push_back(offset - static_cast<int32_t>(m_gopSize));
+    }
+    for (size_t i = 1; i < anchors.size(); i++) {
+        m_decodeOrder.push_back(anchors[i]);
+        BuildSegment(anchors[i - 1], anchors[i], m_decodeOrder);
+    }
+
+    m_decodeRank.assign(m_gopSize, 0);
+    for (size_t slot = 0; slot < m_decodeOrder.size(); slot++) {
+        int32_t offset = m_decodeOrder[slot];
+        if (offset >= 0) {
+            m_decodeRank[offset] = slot;
+        } else {
+            m_decodeRank[offset + m_gopSize] = slot + m_decodeOrder.size();
+        }
+    }
+
+    // 並べ替え深さ: 表示位置がデコード順をどれだけ先行するか
+    // 先頭 GOP には前 GOP の末尾 B がないため、その分だけデコード順が前に詰まる
+    int32_t depth = 0;
+    for (size_t slot = 0; slot < m_decodeOrder.size(); slot++) {
+        depth = std::max(depth, m_decodeOrder[slot] - static_cast<int32_t>(slot));
+    }
+    m_reorderDepth = static_cast<uint32_t>(depth) + trailing.size();
+}
+
+// アンカー left と right（right == gopSize なら次 GOP の I）の間の B フレームを構成
+void GopStructure::BuildSegment(uint32_t left, uint32_t right, std::vector<int32_t>& order) {
+    if (right <= left + 1) {
+        return;
+    }
+    if (m_mode == GOP_HIERARCHICAL) {
+        // 中央の B を参照 B とし、左右の区間を再帰的に構成
+        uint32_t mid = (left + right) / 2;
+        m_type[mid] = 2;
+        m_fwdPos[mid] = left;
+        m_bwdPos[mid] = right;
+        m_isRef[mid] = (mid - left > 1 || right - mid > 1) ? 1 : 0;
+        order.push_back(mid);
+        BuildSegment(left, mid, order);
+        BuildSegment(mid, right, order);
+        return;
+    }
+    for (uint32_t pos = left + 1; pos < right; pos++) {
+        m_type[pos] = 2;
+        m_fwdPos[pos] = left;
+        m_bwdPos[pos] = right;
+        m_isRef[pos] = 0;
+        order.push_back(pos);
+    }
+}
+
+GopMode GopStructure::ParseMode(const std::string& name) {
+    if (name == "ippp") {
+        return GOP_IPPP;
+    }
+    if (name == "ibbp") {
+        return GOP_IBBP;
+    }
+    if (name == "hierarchical") {
+        return GOP_HIERARCHICAL;
+    }
+    if (name == "intra") {
+        return GOP_INTRA_REFRESH;
+    }
+    NS_ABORT_MSG("Unknown GOP mode: " << name);
+    return GOP_IBBP;
+}
+
+uint32_t GopStructure::GetFrameType(uint32_t frameId) const {
+    return m_type[frameId % m_gopSize];
+}
+
+int32_t GopStructure::GetForwardRef(uint32_t frameId) const {
+    if (m_mode == GOP_INTRA_REFRESH) {
+        return static_cast<int32_t>(frameId) - 1;
+    }
+    int32_t pos = m_fwdPos[frameId % m_gopSize];
+    if (pos < 0) {
+        return -1;
+    }
+    return static_cast<int32_t>(frameId - frameId % m_gopSize) + pos;
+}
+
+int32_t GopStructure::GetBackwardRef(uint32_t frameId) const {
+    int32_t pos = m_bwdPos[frameId % m_gopSize];
+    if (pos < 0) {
+        return -1;
+    }
+    return static_cast<int32_t>(frameId - frameId % m_gopSize) + pos;
+}
+
+bool GopStructure::IsReference(uint32_t frameId) const {
+    return m_isRef[frameId % m_gopSize] != 0;
+}
+
+bool GopStructure::IsIntraRefresh() const {
+    return m_mode == GOP_INTRA_REFRESH;
+}
+
+uint32_t GopStructure::GetRefreshPosition(uint32_t frameId) const {
+    return frameId % m_gopSize;
+}
+
+const std::vector<int32_t>& GopStructure::GetDecodeOrder() const {
+    return m_decodeOrder;
+}
+
+uint64_t GopStructure::GetDecodeIndex(uint32_t frameId) const {
+    return static_cast<uint64_t>(frameId / m_gopSize) * m_decodeOrder.size() + m_decodeRank[frameId % m_gopSize];
+}
+
+uint32_t GopStructure::GetReorderDepth() const {
+    return m_reorderDepth;
+}
+
+GopMode GopStructure::GetMode() const {
+    return m_mode;
+}
+
+uint32_t GopStructure::GetGopSize() const {
+    return m_gopSize;
+}
+
+std::string GopStructure::GetDescription() const {
+    const char* modeStr[] = {"ippp", "ibbp", "hierarchical", "intra"};
+    std::ostringstream oss;
+    if (m_mode == GOP_INTRA_REFRESH) {
+        oss << modeStr[m_mode] << " (refresh period " << m_gopSize << ", no I frames)";
+        return oss.str();
+    }
+    oss << modeStr[m_mode] << " (GOP " << m_gopSize << ", " << m_bFrames << " B, "
+        << (m_openGop ? "open" : "closed") << ")";
+    return oss.str();
+}
+
+}
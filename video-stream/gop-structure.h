@@ -0,0 +1,69 @@
+#ifndef GOP_STRUCTURE_H
+#define GOP_STRUCTURE_H
+
+#include "ns3/core-module.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// GOP 構造の種類
+enum GopMode {
+    GOP_IPPP = 0,      // 低遅延: I P P P ...（各 P は直前フレームを参照）
+    GOP_IBBP,          // I B..B P B..B P ...（B は前後のアンカー I/P を参照）
+    GOP_HIERARCHICAL,  // 階層 B: アンカー間の中央の B を参照 B とし再帰的に二分
+    GOP_INTRA_REFRESH  // I フレームなし: 全フレーム P で、イントラ列を gopSize フレームかけて 1 周させる
+};
+
+// GopStructure: GOP 内の各位置のフレームタイプ・参照・デコード順を事前計算したテーブル
+// 構成時に 1 回だけ計算し、フレームごとの問い合わせは配列参照のみで済ませる。
+// フレームIDは表示順の通し番号で、GOP 内の位置は frameId % gopSize。
+// closed GOP では GOP 末尾を P アンカーにして GOP 外を参照しない。
+// open GOP では末尾の B が次 GOP の I フレームを後方参照する。
+// イントラリフレッシュ（GDR）では gopSize がリフレッシュ周期で、GOP 内の位置がその周期のイントラ列の位置になる。
+// 各 P は直前フレームを参照し、周期の境界をまたいでも参照は途切れない。
+class GopStructure : public SimpleRefCount<GopStructure> {
+public:
+    GopStructure(GopMode mode, uint32_t gopSize, uint32_t bFrames, bool openGop);
+
+    static GopMode ParseMode(const std::string& name);
+
+    uint32_t GetFrameType(uint32_t frameId) const;       // 0=I, 1=P, 2=B
+    int32_t GetForwardRef(uint32_t frameId) const;       // 前方参照フレームID (-1=参照なし)
+    int32_t GetBackwardRef(uint32_t frameId) const;      // 後方参照フレームID (-1=参照なし)
+    bool IsReference(uint32_t frameId) const;            // 他フレームから参照されるか
+    bool IsIntraRefresh() const;
+    uint32_t GetRefreshPosition(uint32_t frameId) const;  // イントラ列の位置（0..gopSize-1）
+
+    // 定常状態の GOP 1 つ分のデコード順（GOP 先頭からの表示位置オフセット）
+    // open GOP では前 GOP 末尾の B が負のオフセットで I の直後に並ぶ
+    const std::vector<int32_t>& GetDecodeOrder() const;
+    // フレームのデコード順の通し番号（先頭 GOP で欠ける前 GOP の末尾 B の分は詰めない）
+    uint64_t GetDecodeIndex(uint32_t frameId) const;
+    // 表示順に対してデコードが先行する最大フレーム数（並べ替えバッファの深さ）
+    uint32_t GetReorderDepth() const;
+
+    GopMode GetMode() const;
+    uint32_t GetGopSize() const;
+    std::string GetDescription() const;
+
+private:
+    void BuildSegment(uint32_t left, uint32_t right, std::vector<int32_t>& order);
+
+    GopMode m_mode;
+    uint32_t m_gopSize;
+    uint32_t m_bFrames;
+    bool m_openGop;
+
+    std::vector<uint8_t> m_type;        // 位置ごとのフレームタイプ
+    std::vector<int32_t> m_fwdPos;      // 前方参照の位置 (-1=なし)
+    std::vector<int32_t> m_bwdPos;      // 後方参照の位置 (-1=なし, gopSize=次 GOP の I)
+    std::vector<uint8_t> m_isRef;
+    std::vector<int32_t> m_decodeOrder;
+    std::vector<uint32_t> m_decodeRank;  // 位置ごとの GOP 内デコード順（次 GOP でデコードされる末尾 B は +デコード順の長さ）
+    uint32_t m_reorderDepth;
+};
+
+}
+
+#endif // GOP_STRUCTURE_H
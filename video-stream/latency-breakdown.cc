@@ -0,0 +1,335 @@
+#include "latency-breakdown.h"
+#include "ns3/ampdu-subframe-header.h"
+#include "ns3/ppp-header.h"
+#include "ns3/qos-utils.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("LatencyBreakdown");
+
+namespace {
+
+const char* STAGE_NAMES[] = {"App", "Wired", "Forward", "MacQueue", "Retry", "Airtime", "PhyRx", "Reorder"};
+
+double Percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    return sorted[static_cast<size_t>(q * (sorted.size() - 1))];
+}
+
+}
+
+LatencyBreakdown::LatencyBreakdown() {
+}
+
+void LatencyBreakdown::Install(Ptr<NetDevice> serverDevice, Ptr<NetDevice> apWiredDevice, Ptr<WifiNetDevice> apDevice,
+                               Ptr<WifiNetDevice> staDevice, Ptr<VideoFrameReceiverApplication> receiver,
+                               Ipv4Address destination) {
+    m_destination = destination;
+
+    // MLO では AP のキューは MLD アドレス宛、PHY 上はリンクアドレス宛になるので両方を対象にする
+    Ptr<WifiMac> staMac = staDevice->GetMac();
+    m_staAddresses.insert(staMac->GetAddress());
+    for (uint8_t linkId = 0; linkId < staDevice->GetNPhys(); linkId++) {
+        m_staAddresses.insert(staMac->GetFrameExchangeManager(linkId)->GetAddress());
+    }
+
+    serverDevice->TraceConnectWithoutContext("MacTx", MakeCallback(&LatencyBreakdown::WireTx, this));
+    apWiredDevice->TraceConnectWithoutContext("MacRx", MakeCallback(&LatencyBreakdown::WireRx, this));
+
+    Ptr<WifiMac> apMac = apDevice->GetMac();
+    for (AcIndex ac : {AC_BE, AC_BK, AC_VI, AC_VO}) {
+        Ptr<WifiMacQueue> queue = apMac->GetTxopQueue(ac)->GetWifiMacQueue();
+        queue->TraceConnectWithoutContext("Enqueue", MakeCallback(&LatencyBreakdown::MacEnqueue, this));
+        queue->TraceConnectWithoutContext("Dequeue", MakeCallback(&LatencyBreakdown::MacDequeue, this));
+    }
+    for (uint8_t linkId = 0; linkId < apDevice->GetNPhys(); linkId++) {
+        Ptr<WifiPhy> phy = apDevice->GetPhy(linkId);
+        phy->TraceConnectWithoutContext("PhyTxPsduBegin",
+                                        MakeBoundCallback(&LatencyBreakdown::PhyTxBegin, this, phy->GetPhyBand()));
+    }
+    for (uint8_t linkId = 0; linkId < staDevice->GetNPhys(); linkId++) {
+        staDevice->GetPhy(linkId)->TraceConnectWithoutContext("MonitorSnifferRx",
+                                                              MakeCallback(&LatencyBreakdown::PhyRx, this));
+    }
+
+    receiver->TraceConnectWithoutContext("Rx", MakeCallback(&LatencyBreakdown::AppRx, this));
+}
+
+bool LatencyBreakdown::IsWiredToDestination(Ptr<const Packet> packet) const {
+    Ptr<Packet> pktCopy = packet->Copy();
+    PppHeader ppp;
+    pktCopy->RemoveHeader(ppp);
+    if (ppp.GetProtocol() != 0x0021) {
+        return false;  // IPv4 以外
+    }
+    Ipv4Header ipHdr;
+    pktCopy->PeekHeader(ipHdr);
+    return ipHdr.GetDestination() == m_destination;
+}
+
+HopRecord* LatencyBreakdown::Lookup(Ptr<const Packet> packet) {
+    VideoFrameTag tag;
+    if (!packet->PeekPacketTag(tag) || tag.GetFrameId() == static_cast<uint32_t>(-1)) {
+        return nullptr;  // 映像パケット以外・ウォームアップは対象外
+    }
+
+    uint64_t key = (static_cast<uint64_t>(tag.GetFrameId()) << 32) | tag.GetPacketIndex();
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        return &m_records[it->second];
+    }
+
+    HopRecord record;
+    record.frameId = tag.GetFrameId();
+    record.packetIndex = static_cast<uint16_t>(tag.GetPacketIndex());
+    record.frameType = static_cast<uint8_t>(tag.GetFrameType());
+    record.ac = AC_UNDEF;
+    record.txAttempts = 0;
+    record.frameStart = Seconds(tag.GetTransmissionStartTime()).GetNanoSeconds();
+    record.wireTx = -1;
+    record.wireRx = -1;
+    record.macEnqueue = -1;
+    record.firstPhyTx = -1;
+    record.lastPhyTx = -1;
+    record.lastPhyTxEnd = -1;
+    record.macDequeue = -1;
+    record.phyRx = -1;
+    record.appRx = -1;
+    m_index[key] = m_records.size();
+    m_records.push_back(record);
+    return &m_records.back();
+}
+
+void LatencyBreakdown::WireTx(Ptr<const Packet> packet) {
+    if (!IsWiredToDestination(packet)) {
+        return;
+    }
+    HopRecord* record = Lookup(packet);
+    if (record && record->wireTx < 0) {
+        record->wireTx = Simulator::Now().GetNanoSeconds();
+    }
+}
+
+void LatencyBreakdown::WireRx(Ptr<const Packet> packet) {
+    if (!IsWiredToDestination(packet)) {
+        return;
+    }
+    HopRecord* record = Lookup(packet);
+    if (record && record->wireRx < 0) {
+        record->wireRx = Simulator::Now().GetNanoSeconds();
+    }
+}
+
+void LatencyBreakdown::MacEnqueue(Ptr<const WifiMpdu> mpdu) {
+    const WifiMacHeader& hdr = mpdu->GetHeader();
+    if (!hdr.IsQosData() || m_staAddresses.count(hdr.GetAddr1()) == 0) {
+        return;
+    }
+    HopRecord* record = Lookup(mpdu->GetPacket());
+    if (record && record->macEnqueue < 0) {
+        record->macEnqueue = Simulator::Now().GetNanoSeconds();
+        record->ac = QosUtilsMapTidToAc(hdr.GetQosTid());
+    }
+}
+
+void LatencyBreakdown::MacDequeue(Ptr<const WifiMpdu> mpdu) {
+    const WifiMacHeader& hdr = mpdu->GetHeader();
+    if (!hdr.IsQosData() || m_staAddresses.count(hdr.GetAddr1()) == 0) {
+        return;
+    }
+    HopRecord* record = Lookup(mpdu->GetPacket());
+    if (record) {
+        record->macDequeue = Simulator::Now().GetNanoSeconds();
+    }
+}
+
+void LatencyBreakdown::PhyTxBegin(LatencyBreakdown* tracker, WifiPhyBand band, WifiConstPsduMap psduMap,
+                                  WifiTxVector txVector, double txPowerW) {
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    int64_t end = now + WifiPhy::CalculateTxDuration(psduMap, txVector, band).GetNanoSeconds();
+    for (const auto& entry : psduMap) {
+        for (const auto& mpdu : *entry.second) {
+            const WifiMacHeader& hdr = mpdu->GetHeader();
+            if (!hdr.IsQosData() || tracker->m_staAddresses.count(hdr.GetAddr1()) == 0) {
+                continue;
+            }
+            HopRecord* record = tracker->Lookup(mpdu->GetPacket());
+            if (!record) {
+                continue;
+            }
+            if (record->firstPhyTx < 0) {
+                record->firstPhyTx = now;
+            }
+            // STA が受信した後の再送（BlockAck の喪失など）は区間に含めず、受信に成功した試行で止める
+            if (record->phyRx < 0) {
+                record->lastPhyTx = now;
+                record->lastPhyTxEnd = end;
+            }
+            if (record->txAttempts < UINT8_MAX) {
+                record->txAttempts++;
+            }
+        }
+    }
+}
+
+void LatencyBreakdown::PhyRx(Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                             MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId) {
+    Ptr<Packet> pktCopy = packet->Copy();
+    if (txVector.IsAggregation()) {
+        AmpduSubframeHeader subHdr;
+        pktCopy->RemoveHeader(subHdr);
+    }
+    WifiMacHeader hdr;
+    pktCopy->PeekHeader(hdr);
+    if (!hdr.IsQosData() || m_staAddresses.count(hdr.GetAddr1()) == 0) {
+        return;  // 他 STA 宛の傍受フレームは対象外
+    }
+    HopRecord* record = Lookup(packet);
+    if (record && record->phyRx < 0) {
+        record->phyRx = Simulator::Now().GetNanoSeconds();
+    }
+}
+
+void LatencyBreakdown::AppRx(Ptr<const Packet> packet, const Address& from) {
+    HopRecord* record = Lookup(packet);
+    if (record && record->appRx < 0) {
+        record->appRx = Simulator::Now().GetNanoSeconds();
+    }
+}
+
+bool LatencyBreakdown::GetStages(const HopRecord& record, double* stages) {
+    if (record.wireTx < 0 || record.wireRx < 0 || record.macEnqueue < 0 || record.firstPhyTx < 0 ||
+        record.phyRx < 0 || record.appRx < 0) {
+        return false;
+    }
+    const int64_t points[] = {record.frameStart, record.wireTx, record.wireRx, record.macEnqueue,
+                              record.firstPhyTx, record.lastPhyTx, record.lastPhyTxEnd, record.phyRx,
+                              record.appRx};
+    // 時刻が前後する記録（タグの取り違えなど）は負の区間を平均に混ぜないよう除外する
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        if (points[s + 1] < points[s]) {
+            return false;
+        }
+    }
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        stages[s] = (points[s + 1] - points[s]) / 1e6;
+    }
+    return true;
+}
+
+void LatencyBreakdown::WriteSummary(const std::string& filename) const {
+    // [フレームタイプ(0..2) + 全体(3)][区間 + エンドツーエンド]
+    std::vector<double> samples[4][STAGE_COUNT + 1];
+    uint64_t observed[4] = {0, 0, 0, 0};
+    uint64_t rejected[4] = {0, 0, 0, 0};  // 全区間そろったが時刻が単調でない記録
+    double stages[STAGE_COUNT];
+    for (const HopRecord& record : m_records) {
+        uint32_t type = std::min<uint32_t>(record.frameType, 2);
+        observed[type]++;
+        observed[3]++;
+        if (!GetStages(record, stages)) {
+            if (record.wireTx >= 0 && record.wireRx >= 0 && record.macEnqueue >= 0 && record.firstPhyTx >= 0 &&
+                record.phyRx >= 0 && record.appRx >= 0) {
+                rejected[type]++;
+                rejected[3]++;
+            }
+            continue;
+        }
+        double total = 0.0;
+        for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+            samples[type][s].push_back(stages[s]);
+            samples[3][s].push_back(stages[s]);
+            total += stages[s];
+        }
+        samples[type][STAGE_COUNT].push_back(total);
+        samples[3][STAGE_COUNT].push_back(total);
+    }
+
+    std::ofstream out(filename);
+    const char* typeStr[] = {"I", "P", "B", "All"};
+    out << "FrameType,Stage,Packets,Delivered,NonMonotonic,Mean(ms),P50(ms),P95(ms),P99(ms),Share(%)" << std::endl;
+    for (uint32_t type = 0; type < 4; type++) {
+        std::vector<double>& totals = samples[type][STAGE_COUNT];
+        double totalSum = 0.0;
+        for (double v : totals) {
+            totalSum += v;
+        }
+        for (uint32_t s = 0; s <= STAGE_COUNT; s++) {
+            std::vector<double>& values = samples[type][s];
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double v : values) {
+                sum += v;
+            }
+            out << typeStr[type] << ","
+                << (s < STAGE_COUNT ? STAGE_NAMES[s] : "EndToEnd") << ","
+                << observed[type] << ","
+                << values.size() << ","
+                << rejected[type] << ","
+                << std::fixed << std::setprecision(3) << (values.empty() ? 0.0 : sum / values.size()) << ","
+                << Percentile(values, 0.50) << ","
+                << Percentile(values, 0.95) << ","
+                << Percentile(values, 0.99) << ","
+                << std::setprecision(1) << (totalSum > 0.0 ? sum * 100.0 / totalSum : 0.0) << std::endl;
+        }
+    }
+}
+
+void LatencyBreakdown::WritePackets(const std::string& filename) const {
+    std::ofstream out(filename);
+    const char* acStr[] = {"BE", "BK", "VI", "VO"};
+    out << "FrameID,FrameType,PacketIndex,AC,TxAttempts";
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        out << "," << STAGE_NAMES[s] << "(ms)";
+    }
+    out << ",EndToEnd(ms),MacRelease(ms)" << std::endl;
+
+    double stages[STAGE_COUNT];
+    for (const HopRecord& record : m_records) {
+        if (!GetStages(record, stages)) {
+            continue;
+        }
+        double total = 0.0;
+        out << record.frameId << ","
+            << static_cast<int>(record.frameType) << ","
+            << record.packetIndex << ","
+            << (record.ac < 4 ? acStr[record.ac] : "-") << ","
+            << static_cast<int>(record.txAttempts);
+        out << std::fixed << std::setprecision(3);
+        for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+            out << "," << stages[s];
+            total += stages[s];
+        }
+        // 送信完了から WifiMacQueue を離れるまで（Block Ack の受信待ち）
+        out << "," << total << ","
+            << (record.macDequeue >= 0 ? (record.macDequeue - record.lastPhyTxEnd) / 1e6 : -1.0) << std::endl;
+    }
+}
+
+void LatencyBreakdown::PrintSummary(std::ostream& os) const {
+    double sums[STAGE_COUNT] = {};
+    double stages[STAGE_COUNT];
+    uint64_t delivered = 0;
+    for (const HopRecord& record : m_records) {
+        if (!GetStages(record, stages)) {
+            continue;
+        }
+        delivered++;
+        for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+            sums[s] += stages[s];
+        }
+    }
+    os << "\n=== Latency Breakdown (first flow, mean ms) ===" << std::endl;
+    os << "Packets: " << delivered << " / " << m_records.size() << " fully traced" << std::endl;
+    if (delivered == 0) {
+        return;
+    }
+    os << std::fixed << std::setprecision(3);
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        os << "  " << std::left << std::setw(9) << STAGE_NAMES[s] << std::right << sums[s] / delivered << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef LATENCY_BREAKDOWN_H
+#define LATENCY_BREAKDOWN_H
+
+#include "video-frame.h"
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+// HopRecord: 1 パケット分の経路上の時刻（ナノ秒, -1 = 未観測）
+// キーはパケットに付いている VideoFrameTag の (フレームID, パケット番号)
+struct HopRecord {
+    uint32_t frameId;
+    uint16_t packetIndex;
+    uint8_t frameType;   // 0=I, 1=P, 2=B
+    uint8_t ac;          // AP で積まれた AC
+    uint8_t txAttempts;  // AP からの PHY 送信回数（再送を含む）
+    int64_t frameStart;  // フレーム送信開始（アプリ）
+    int64_t wireTx;      // サーバー側 p2p デバイスへの投入
+    int64_t wireRx;      // AP 側 p2p デバイスでの受信
+    int64_t macEnqueue;  // AP の WifiMacQueue への投入
+    int64_t firstPhyTx;  // AP の最初の PHY 送信開始
+    int64_t lastPhyTx;   // STA が最初に受信した試行の PHY 送信開始（それ以降の再送は含めない）
+    int64_t lastPhyTxEnd;
+    int64_t macDequeue;  // WifiMacQueue からの取り出し（ACK 受信またはドロップ）
+    int64_t phyRx;       // STA の PHY 受信完了
+    int64_t appRx;       // 受信アプリへの到着
+};
+
+// LatencyBreakdown: 1 フローのエンドツーエンド遅延を区間ごとに分解する
+// サーバー p2p → AP p2p → AP の AC キュー → AP PHY 送信 → STA PHY 受信 → 受信アプリ の各点に
+// トレースを張り、(フレームID, パケット番号) ごとに時刻を記録する。
+// 区間は
+//   App      フレーム送信開始 → p2p 投入（フレーム内のパケット間隔）
+//   Wired    p2p 投入 → AP の p2p 受信（キューイング・シリアライズ・伝搬）
+//   Forward  AP の p2p 受信 → WifiMacQueue 投入（IP 転送と TrafficControl キュー）
+//   MacQueue WifiMacQueue 投入 → 最初の PHY 送信（チャネルアクセスとキュー待ち）
+//   Retry    最初の PHY 送信 → 最後の PHY 送信（再送）
+//   Airtime  最後の PHY 送信 → 送信完了
+//   PhyRx    送信完了 → STA の PHY 受信完了
+//   Reorder  STA の PHY 受信 → 受信アプリ（Block Ack の並べ替え待ちなど）
+class LatencyBreakdown : public SimpleRefCount<LatencyBreakdown> {
+public:
+    LatencyBreakdown();
+
+    // 対象フローの経路上のデバイスと受信アプリにトレースを接続
+    void Install(Ptr<NetDevice> serverDevice, Ptr<NetDevice> apWiredDevice, Ptr<WifiNetDevice> apDevice,
+                 Ptr<WifiNetDevice> staDevice, Ptr<VideoFrameReceiverApplication> receiver,
+                 Ipv4Address destination);
+
+    // 区間別の集計（フレームタイプ × 区間）
+    void WriteSummary(const std::string& filename) const;
+    // パケット単位の区間遅延
+    void WritePackets(const std::string& filename) const;
+    void PrintSummary(std::ostream& os) const;
+
+private:
+    enum Stage {
+        STAGE_APP = 0,
+        STAGE_WIRED,
+        STAGE_FORWARD,
+        STAGE_MAC_QUEUE,
+        STAGE_RETRY,
+        STAGE_AIRTIME,
+        STAGE_PHY_RX,
+        STAGE_REORDER,
+        STAGE_COUNT
+    };
+
+    void WireTx(Ptr<const Packet> packet);
+    void WireRx(Ptr<const Packet> packet);
+    void MacEnqueue(Ptr<const WifiMpdu> mpdu);
+    void MacDequeue(Ptr<const WifiMpdu> mpdu);
+    static void PhyTxBegin(LatencyBreakdown* tracker, WifiPhyBand band, WifiConstPsduMap psduMap,
+                           WifiTxVector txVector, double txPowerW);
+    void PhyRx(Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu,
+               SignalNoiseDbm signalNoise, uint16_t staId);
+    void AppRx(Ptr<const Packet> packet, const Address& from);
+
+    bool IsWiredToDestination(Ptr<const Packet> packet) const;
+    // タグから記録を引く（なければ作る）。映像パケット以外は nullptr
+    HopRecord* Lookup(Ptr<const Packet> packet);
+    // 全区間がそろい、時刻が単調に並ぶ記録の区間遅延（ミリ秒）
+    static bool GetStages(const HopRecord& record, double* stages);
+
+    Ipv4Address m_destination;
+    std::set<Mac48Address> m_staAddresses;  // STA の MLD アドレスとリンクアドレス
+    std::vector<HopRecord> m_records;
+    std::unordered_map<uint64_t, uint32_t> m_index;  // (フレームID << 32 | パケット番号) → m_records の位置
+};
+
+}
+
+#endif // LATENCY_BREAKDOWN_H
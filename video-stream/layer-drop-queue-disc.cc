@@ -0,0 +1,110 @@
+#include "layer-drop-queue-disc.h"
+#include "video-frame.h"
+#include "ns3/drop-tail-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("LayerDropQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(LayerDropQueueDisc);
+
+TypeId LayerDropQueueDisc::GetTypeId() {
+    static TypeId tid = TypeId("ns3::LayerDropQueueDisc")
+        .SetParent<QueueDisc>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<LayerDropQueueDisc>()
+        .AddAttribute("MaxSize",
+                      "The max queue size",
+                      QueueSizeValue(QueueSize("1000p")),
+                      MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                      MakeQueueSizeChecker())
+        .AddAttribute("ShedThreshold",
+                      "Queue length (packets) at which the first enhancement layer is shed",
+                      UintegerValue(100),
+                      MakeUintegerAccessor(&LayerDropQueueDisc::m_shedThreshold),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("LayerStep",
+                      "Threshold reduction (packets) for each higher enhancement layer",
+                      UintegerValue(25),
+                      MakeUintegerAccessor(&LayerDropQueueDisc::m_layerStep),
+                      MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+LayerDropQueueDisc::LayerDropQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE), m_shedThreshold(100), m_layerStep(25) {
+}
+
+LayerDropQueueDisc::~LayerDropQueueDisc() {
+}
+
+const std::vector<uint64_t>& LayerDropQueueDisc::GetShedPackets() const {
+    return m_shedPackets;
+}
+
+uint32_t LayerDropQueueDisc::GetLayerThreshold(uint32_t layerId) const {
+    uint32_t reduction = (layerId - 1) * m_layerStep;
+    if (reduction + m_layerStep > m_shedThreshold) {
+        return m_layerStep;
+    }
+    return m_shedThreshold - reduction;
+}
+
+bool LayerDropQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item) {
+    VideoFrameTag tag;
+    if (item->GetPacket()->PeekPacketTag(tag) && tag.GetLayerId() > 0) {
+        uint32_t layerId = tag.GetLayerId();
+        if (GetNPackets() >= GetLayerThreshold(layerId)) {
+            if (m_shedPackets.size() <= layerId) {
+                m_shedPackets.resize(layerId + 1, 0);
+            }
+            m_shedPackets[layerId]++;
+            NS_LOG_LOGIC("Shed layer " << layerId << " packet, queue length " << GetNPackets());
+            DropBeforeEnqueue(item, LAYER_SHED_DROP);
+            return false;
+        }
+    }
+
+    if (GetCurrentSize() + item > GetMaxSize()) {
+        NS_LOG_LOGIC("Queue full -- dropping pkt");
+        DropBeforeEnqueue(item, LIMIT_EXCEEDED_DROP);
+        return false;
+    }
+
+    return GetInternalQueue(0)->Enqueue(item);
+}
+
+Ptr<QueueDiscItem> LayerDropQueueDisc::DoDequeue() {
+    Ptr<QueueDiscItem> item = GetInternalQueue(0)->Dequeue();
+    if (!item) {
+        NS_LOG_LOGIC("Queue empty");
+        return nullptr;
+    }
+    return item;
+}
+
+bool LayerDropQueueDisc::CheckConfig() {
+    if (GetNQueueDiscClasses() > 0) {
+        NS_LOG_ERROR("LayerDropQueueDisc cannot have classes");
+        return false;
+    }
+    if (GetNPacketFilters() > 0) {
+        NS_LOG_ERROR("LayerDropQueueDisc needs no packet filter");
+        return false;
+    }
+    if (GetNInternalQueues() == 0) {
+        AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+            "MaxSize", QueueSizeValue(GetMaxSize())));
+    }
+    if (GetNInternalQueues() != 1) {
+        NS_LOG_ERROR("LayerDropQueueDisc needs 1 internal queue");
+        return false;
+    }
+    return true;
+}
+
+void LayerDropQueueDisc::InitializeParams() {
+    m_shedPackets.assign(1, 0);
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef LAYER_DROP_QUEUE_DISC_H
+#define LAYER_DROP_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include <vector>
+
+namespace ns3 {
+
+// LayerDropQueueDisc: SVC 拡張レイヤを優先的に破棄する FIFO キューディスク
+// AP の WiFi デバイスで mq の各 AC キューの子として使う。
+// 拡張レイヤ l (>= 1) はキュー長が ShedThreshold - (l - 1)·LayerStep（下限 LayerStep）以上なら破棄するので、
+// キューが伸びるにつれて上位レイヤから順に落ちていく。
+// ベースレイヤ（レイヤ 0）とタグのないパケットは MaxSize を超えたときのみ破棄する。
+// キュー長はこのキューディスク内の滞留だけを見る。下の WifiMacQueue が満杯になるまでは伸びないので、
+// 使う側で MAC キューを小さくしておく（video-stream-simulation の layerMacQueue）。
+class LayerDropQueueDisc : public QueueDisc {
+public:
+    static TypeId GetTypeId();
+    LayerDropQueueDisc();
+    ~LayerDropQueueDisc() override;
+
+    // 破棄理由
+    static constexpr const char* LAYER_SHED_DROP = "Enhancement layer shed";
+    static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";
+
+    // レイヤごとの破棄パケット数（インデックス = レイヤID）
+    const std::vector<uint64_t>& GetShedPackets() const;
+
+private:
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+
+    uint32_t GetLayerThreshold(uint32_t layerId) const;
+
+    uint32_t m_shedThreshold;           // 最上位の拡張レイヤを破棄し始めるキュー長 (パケット)
+    uint32_t m_layerStep;               // レイヤ間の閾値の差 (パケット)
+    std::vector<uint64_t> m_shedPackets;
+};
+
+}
+
+#endif // LAYER_DROP_QUEUE_DISC_H
@@ -3,6 +3,8 @@
 #include "ns3/simulator.h"
 #include "ns3/qos-utils.h"
 #include "ns3/ampdu-subframe-header.h"
+#include <algorithm>
+#include <iomanip>
 
 namespace ns3 {
 
@@ -60,5 +62,380 @@ void PhyRxTrace(Ptr<OutputStreamWrapper> stream, std::string context, Ptr<const
     }
 }
 
+// PHY 層受信失敗トレースコールバック
+void PhyRxDropTrace(ContentionCounters* counters, std::string context,
+                    Ptr<const Packet> packet, WifiPhyRxfailureReason reason)
+{
+    counters->phyRxDrops++;
+}
+
+// MAC 送信失敗（再送）トレースコールバック
+void MacTxDataFailedTrace(ContentionCounters* counters, std::string context, Mac48Address address)
+{
+    counters->txRetries++;
+}
+
+// 再送上限到達トレースコールバック
+void MacTxFinalDataFailedTrace(ContentionCounters* counters, std::string context, Mac48Address address)
+{
+    counters->txFinalFailures++;
+}
+
+// リンク単位の送信時間（エアタイム）トレースコールバック
+void LinkTxAirtimeTrace(LinkStats* stats, WifiPhyBand band, std::string context,
+                        WifiConstPsduMap psduMap, WifiTxVector txVector, double txPowerW)
+{
+    stats->airtime += WifiPhy::CalculateTxDuration(psduMap, txVector, band).GetSeconds();
+    stats->psdus++;
+}
+
+// リンク単位の映像パケット受信トレースコールバック（STA 側）
+void LinkRxTrace(LinkStats* stats, std::string context, Ptr<const Packet> packet,
+                 uint16_t channelFreqMhz, WifiTxVector txVector,
+                 MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId)
+{
+    VideoFrameTag vTag;
+    if (!packet->PeekPacketTag(vTag) || vTag.GetFrameId() == static_cast<uint32_t>(-1)) {
+        return;  // 映像パケット以外・ウォームアップは対象外
+    }
+    stats->rxMpdus++;
+    // MAC 再送やブロック ACK 喪失による重複受信は初回だけ数える
+    if (!stats->seen.insert(std::make_pair(vTag.GetFrameId(), vTag.GetPacketIndex())).second) {
+        return;
+    }
+    stats->videoPackets++;
+    stats->latencies.push_back((Simulator::Now().GetSeconds() - vTag.GetTransmissionStartTime()) * 1000.0);
+}
+
+
+// キュー長の最大値トレースコールバック（PacketsInQueue）
+void QueueDepthTrace(uint32_t* peak, uint32_t oldValue, uint32_t newValue)
+{
+    *peak = std::max(*peak, newValue);
+}
+
+void RadioStateStats::Add(uint32_t state, double from, double to)
+{
+    from = std::max(from, accounted);
+    to = std::min(to, stop);
+    if (state >= NUM_STATES || to <= from) {
+        return;
+    }
+    stateTime[state] += to - from;
+    double windowFrom = std::max(from, windowStart);
+    if (to > windowFrom) {
+        windowTime[state] += to - windowFrom;
+    }
+    accounted = to;
+}
+
+double RadioStateStats::GetAwakeTime(bool window) const
+{
+    const double* times = window ? windowTime : stateTime;
+    double awake = 0.0;
+    for (uint32_t s = 0; s < NUM_STATES; s++) {
+        if (s != static_cast<uint32_t>(WifiPhyState::SLEEP) && s != static_cast<uint32_t>(WifiPhyState::OFF)) {
+            awake += times[s];
+        }
+    }
+    return awake;
+}
+
+double RadioStateStats::GetSleepTime(bool window) const
+{
+    const double* times = window ? windowTime : stateTime;
+    return times[static_cast<uint32_t>(WifiPhyState::SLEEP)];
+}
+
+double RadioStateStats::GetEnergy(bool window) const
+{
+    // IDLE, CCA_BUSY, TX, RX, SWITCHING, SLEEP, OFF の電流 (A)
+    static const double currentA[NUM_STATES] = {0.273, 0.273, 0.380, 0.313, 0.273, 0.033, 0.0};
+    const double voltage = 3.0;
+    const double* times = window ? windowTime : stateTime;
+    double energy = 0.0;
+    for (uint32_t s = 0; s < NUM_STATES; s++) {
+        energy += times[s] * currentA[s] * voltage;
+    }
+    return energy;
+}
+
+// PHY 状態の滞在時間トレースコールバック（WifiPhyStateHelper の State、状態を抜けたときに通知）
+void PhyStateTrace(RadioStateStats* stats, std::string context, Time start, Time duration, WifiPhyState state)
+{
+    stats->Add(static_cast<uint32_t>(state), start.GetSeconds(), (start + duration).GetSeconds());
+}
+
+// stop の時点で続いている PHY 状態を stop まで加える（stop に Schedule する）
+void FlushRadioState(RadioStateStats* stats, Ptr<WifiPhy> phy)
+{
+    stats->Add(static_cast<uint32_t>(phy->GetState()->GetState()), stats->accounted,
+               Simulator::Now().GetSeconds());
+}
+
+// パケット数のカウンタトレースコールバック（WAN 区間の損失 PhyRxDrop など）
+void PacketCountTrace(uint64_t* count, Ptr<const Packet> packet)
+{
+    (*count)++;
+}
+
+// 輻輳制御の目標ビットレートトレースコールバック（送信側）
+void CcTargetRateTrace(Ptr<OutputStreamWrapper> stream, double targetBps)
+{
+    *stream->GetStream() << std::fixed << std::setprecision(6) << Simulator::Now().GetSeconds() << ","
+                         << std::setprecision(3) << targetBps / 1e6 << std::endl;
+}
+
+// 遅延勾配トレースコールバック（受信側の帯域推定）
+void CcDelayGradientTrace(Ptr<OutputStreamWrapper> stream, double modifiedTrend, double threshold, uint32_t usage,
+                          double targetBps, double ceAlpha)
+{
+    const char* usageStr[] = {"normal", "underuse", "overuse"};
+    *stream->GetStream() << std::fixed << std::setprecision(6) << Simulator::Now().GetSeconds() << ","
+                         << std::setprecision(3) << modifiedTrend << ","
+                         << threshold << ","
+                         << usageStr[std::min(usage, 2u)] << ","
+                         << targetBps / 1e6 << ","
+                         << ceAlpha << std::endl;
+}
+
+// A-MPDU 集約トレースコールバック（AP の MonitorSnifferTx）
+void AmpduTxTrace(AmpduAggregator* aggregator, std::string context, Ptr<const Packet> packet,
+                  uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu, uint16_t staId)
+{
+    aggregator->AddMpdu(packet, channelFreqMhz, txVector, aMpdu, staId);
+}
+
+void Histogram::Add(double value) {
+    size_t bin = static_cast<size_t>(value / binWidth);
+    counts[std::min(bin, counts.size() - 1)]++;
+    samples++;
+    sum += value;
+    max = std::max(max, value);
+}
+
+void Histogram::Merge(const Histogram& other) {
+    for (size_t bin = 0; bin < counts.size() && bin < other.counts.size(); bin++) {
+        counts[bin] += other.counts[bin];
+    }
+    samples += other.samples;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+double Histogram::Mean() const {
+    return samples > 0 ? sum / samples : 0.0;
+}
+
+double Histogram::Percentile(double q) const {
+    if (samples == 0) {
+        return 0.0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * (samples - 1));
+    uint64_t seen = 0;
+    for (size_t bin = 0; bin < counts.size(); bin++) {
+        if (seen + counts[bin] > target) {
+            if (discrete) {
+                return std::min(bin * binWidth, max);
+            }
+            // ビン内に一様に分布しているとみなして補間
+            double fraction = (target - seen + 0.5) / counts[bin];
+            return std::min((bin + fraction) * binWidth, max);
+        }
+        seen += counts[bin];
+    }
+    return max;
+}
+
+AmpduAggregator::AmpduAggregator() {
+}
+
+void AmpduAggregator::AddMpdu(Ptr<const Packet> packet, uint16_t channelFreqMhz, const WifiTxVector& txVector,
+                              const MpduInfo& aMpdu, uint16_t staId)
+{
+    // サブフレームヘッダを外して MAC ヘッダを確認（QoS データのみ対象）
+    Ptr<Packet> pktCopy = packet->Copy();
+    if (txVector.IsAggregation()) {
+        AmpduSubframeHeader subHdr;
+        pktCopy->RemoveHeader(subHdr);
+    }
+    WifiMacHeader hdr;
+    pktCopy->PeekHeader(hdr);
+    if (!hdr.IsQosData()) {
+        return;
+    }
+
+    OpenAggregate single;
+    OpenAggregate* agg = &single;
+    uint64_t key = (static_cast<uint64_t>(channelFreqMhz) << 48) | (static_cast<uint64_t>(staId) << 32) |
+                   aMpdu.mpduRefNumber;
+    bool aggregated = (aMpdu.type != NORMAL_MPDU && aMpdu.type != SINGLE_MPDU) || txVector.IsAggregation();
+    if (aggregated) {
+        auto it = m_open.find(key);
+        if (it == m_open.end()) {
+            it = m_open.emplace(key, OpenAggregate()).first;
+            it->second.subframes = 0;
+            it->second.bytes = 0;
+        }
+        agg = &it->second;
+    } else {
+        single.subframes = 0;
+        single.bytes = 0;
+    }
+
+    agg->ac = QosUtilsMapTidToAc(hdr.GetQosTid());
+    agg->channelFreqMhz = channelFreqMhz;
+    agg->staId = staId;
+    agg->receiver = hdr.GetAddr1();
+    agg->txVector = txVector;
+    agg->subframes++;
+    agg->bytes += packet->GetSize();
+
+    VideoFrameTag vTag;
+    if (packet->PeekPacketTag(vTag) && vTag.GetFrameId() != static_cast<uint32_t>(-1)) {
+        uint32_t frameId = vTag.GetFrameId();
+        if (std::find(agg->frameIds.begin(), agg->frameIds.end(), frameId) == agg->frameIds.end()) {
+            agg->frameIds.push_back(frameId);
+            agg->frameTypes.push_back(static_cast<uint8_t>(vTag.GetFrameType()));
+        }
+    }
+
+    if (!aggregated) {
+        Close(single);
+    } else if (aMpdu.type == LAST_MPDU_IN_AGGREGATE || aMpdu.type == SINGLE_MPDU) {
+        Close(*agg);
+        m_open.erase(key);
+    }
+}
+
+void AmpduAggregator::Close(OpenAggregate& agg) {
+    AcStats& stats = m_acStats[agg.ac];
+    WifiPhyBand band = (agg.channelFreqMhz < 3000)   ? WIFI_PHY_BAND_2_4GHZ
+                       : (agg.channelFreqMhz < 5950) ? WIFI_PHY_BAND_5GHZ
+                                                     : WIFI_PHY_BAND_6GHZ;
+    double airtimeUs = WifiPhy::CalculateTxDuration(agg.bytes, agg.txVector, band, agg.staId).GetMicroSeconds();
+
+    stats.aggregates++;
+    stats.subframes.Add(agg.subframes);
+    stats.bytes.Add(agg.bytes);
+    stats.airtimeUs.Add(airtimeUs);
+    stats.frames.Add(agg.frameIds.size());
+    if (agg.frameIds.size() > 1) {
+        stats.multiFrameAggregates++;
+    }
+
+    for (size_t i = 0; i < agg.frameIds.size(); i++) {
+        auto key = std::make_pair(agg.receiver, agg.frameIds[i]);
+        auto it = m_frameSpans.find(key);
+        if (it == m_frameSpans.end()) {
+            FrameSpan span;
+            span.frameType = agg.frameTypes[i];
+            span.aggregates = 0;
+            it = m_frameSpans.emplace(key, span).first;
+        }
+        it->second.aggregates++;
+    }
+}
+
+void AmpduAggregator::Flush() {
+    for (auto& entry : m_open) {
+        Close(entry.second);
+    }
+    m_open.clear();
+}
+
+void AmpduAggregator::Merge(const AmpduAggregator& other) {
+    for (uint32_t ac = 0; ac < 4; ac++) {
+        AcStats& stats = m_acStats[ac];
+        const AcStats& otherStats = other.m_acStats[ac];
+        stats.aggregates += otherStats.aggregates;
+        stats.subframes.Merge(otherStats.subframes);
+        stats.bytes.Merge(otherStats.bytes);
+        stats.airtimeUs.Merge(otherStats.airtimeUs);
+        stats.frames.Merge(otherStats.frames);
+        stats.multiFrameAggregates += otherStats.multiFrameAggregates;
+    }
+    for (const auto& entry : other.m_frameSpans) {
+        auto it = m_frameSpans.find(entry.first);
+        if (it == m_frameSpans.end()) {
+            m_frameSpans.insert(entry);
+        } else {
+            it->second.aggregates += entry.second.aggregates;
+        }
+    }
+}
+
+void AmpduAggregator::WriteSummary(const std::string& filename) const {
+    std::ofstream out(filename);
+    const char* acStr[] = {"BE", "BK", "VI", "VO"};
+    out << "AC,Aggregates,MeanSubframes,P50Subframes,P95Subframes,MaxSubframes,MeanBytes,MaxBytes,"
+        << "MeanAirtime(us),P95Airtime(us),MeanFramesPerAggregate,MultiFrameAggregates(%)" << std::endl;
+    for (uint32_t ac = 0; ac < 4; ac++) {
+        const AcStats& stats = m_acStats[ac];
+        if (stats.aggregates == 0) {
+            continue;
+        }
+        out << acStr[ac] << ","
+            << stats.aggregates << ","
+            << std::fixed << std::setprecision(2) << stats.subframes.Mean() << ","
+            << std::setprecision(0) << stats.subframes.Percentile(0.50) << ","
+            << stats.subframes.Percentile(0.95) << ","
+            << stats.subframes.max << ","
+            << stats.bytes.Mean() << ","
+            << stats.bytes.max << ","
+            << std::setprecision(1) << stats.airtimeUs.Mean() << ","
+            << stats.airtimeUs.Percentile(0.95) << ","
+            << std::setprecision(2) << stats.frames.Mean() << ","
+            << std::setprecision(1) << stats.multiFrameAggregates * 100.0 / stats.aggregates << std::endl;
+    }
+
+    // 映像フレームが複数の A-MPDU に分割された割合（フレームタイプ別）
+    const char* typeStr[] = {"I", "P", "B"};
+    uint64_t frames[3] = {0, 0, 0};
+    uint64_t split[3] = {0, 0, 0};
+    uint64_t spanSum[3] = {0, 0, 0};
+    for (const auto& entry : m_frameSpans) {
+        uint8_t type = std::min<uint8_t>(entry.second.frameType, 2);
+        frames[type]++;
+        spanSum[type] += entry.second.aggregates;
+        if (entry.second.aggregates > 1) {
+            split[type]++;
+        }
+    }
+    out << std::endl << "FrameType,Frames,SplitFrames,SplitRatio(%),MeanAggregatesPerFrame" << std::endl;
+    for (uint32_t type = 0; type < 3; type++) {
+        out << typeStr[type] << ","
+            << frames[type] << ","
+            << split[type] << ","
+            << std::fixed << std::setprecision(1) << (frames[type] > 0 ? split[type] * 100.0 / frames[type] : 0.0) << ","
+            << std::setprecision(2) << (frames[type] > 0 ? static_cast<double>(spanSum[type]) / frames[type] : 0.0)
+            << std::endl;
+    }
+}
+
+void AmpduAggregator::WriteHistograms(const std::string& filename) const {
+    std::ofstream out(filename);
+    const char* acStr[] = {"BE", "BK", "VI", "VO"};
+    out << "AC,Metric,BinStart,Count" << std::endl;
+    for (uint32_t ac = 0; ac < 4; ac++) {
+        const AcStats& stats = m_acStats[ac];
+        const std::pair<const char*, const Histogram*> metrics[] = {
+            {"Subframes", &stats.subframes},
+            {"Bytes", &stats.bytes},
+            {"Airtime(us)", &stats.airtimeUs},
+            {"VideoFrames", &stats.frames},
+        };
+        for (const auto& metric : metrics) {
+            const Histogram& hist = *metric.second;
+            for (size_t bin = 0; bin < hist.counts.size(); bin++) {
+                if (hist.counts[bin] == 0) {
+                    continue;  // 空ビンは省略
+                }
+                out << acStr[ac] << "," << metric.first << "," << bin * hist.binWidth << "," << hist.counts[bin]
+                    << std::endl;
+            }
+        }
+    }
+}
 
 }
@@ -5,11 +5,136 @@
 #include "ns3/wifi-phy.h"
 #include "ns3/wifi-mac-header.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/wifi-psdu.h"
 #include <fstream>
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3 {
 
+// BSS 単位の競合・再送カウンタ
+struct ContentionCounters {
+    uint64_t phyRxDrops;      // PHY 受信失敗数（衝突・プリアンブル検出失敗など）
+    uint64_t txRetries;       // MAC 送信失敗数（ACK 未受信による再送）
+    uint64_t txFinalFailures; // 再送上限到達による破棄数
+
+    ContentionCounters() : phyRxDrops(0), txRetries(0), txFinalFailures(0) {}
+};
+
+// MLO リンク単位の統計
+struct LinkStats {
+    double airtime;                 // 送信時間の合計 (秒)
+    uint64_t psdus;                 // 送信 PSDU 数
+    uint64_t rxMpdus;               // STA が受信した映像 MPDU 数（再送・重複を含む）
+    uint64_t videoPackets;          // STA が受信した映像パケット数（フレームID・パケット番号で重複を除く）
+    std::vector<double> latencies;  // 受信映像パケットの遅延 (ミリ秒、初回受信のみ)
+    std::set<std::pair<uint32_t, uint32_t>> seen;  // 受信済みの (フレームID, パケット番号)
+
+    LinkStats() : airtime(0.0), psdus(0), rxMpdus(0), videoPackets(0) {}
+};
+
+// STA 無線部の PHY 状態ごとの滞在時間と消費エネルギー（TWT の省電力評価用）
+// 電流は WifiRadioEnergyModel の既定値、電圧は 3 V（BasicEnergySource の既定値）
+// 全体は [0, stop]、評価区間は [windowStart, stop]（最初の SP から）の滞在時間を持つ。
+// stop 以降の状態は数えず、stop で続いている状態は FlushRadioState で stop までを加える。
+struct RadioStateStats {
+    static const uint32_t NUM_STATES = 7;  // WifiPhyState（IDLE, CCA_BUSY, TX, RX, SWITCHING, SLEEP, OFF）
+    double stateTime[NUM_STATES];          // 状態ごとの滞在時間 (秒)
+    double windowTime[NUM_STATES];         // 評価区間での状態ごとの滞在時間 (秒)
+    double windowStart;                    // 評価区間の開始 (秒)
+    double stop;                           // 集計の終了 (秒)
+    double accounted;                      // 集計済みの時刻 (秒)
+
+    RadioStateStats() : stateTime{}, windowTime{}, windowStart(0.0), stop(0.0), accounted(0.0) {}
+
+    // 状態 state の滞在 [from, to] を加える（集計済みの時刻より前と stop より後は除く）
+    void Add(uint32_t state, double from, double to);
+
+    double GetAwakeTime(bool window = false) const;  // SLEEP/OFF 以外
+    double GetSleepTime(bool window = false) const;
+    double GetEnergy(bool window = false) const;     // ジュール
+};
+
+// 固定幅ビンのヒストグラム（最終ビンは上限超えをまとめる）
+struct Histogram {
+    double binWidth;
+    std::vector<uint64_t> counts;
+    uint64_t samples;
+    double sum;
+    double max;
+    bool discrete;  // 整数値を幅 1 のビンで数える（ビンの値が 1 つに決まる）
+
+    Histogram(double width = 1.0, uint32_t bins = 64, bool isDiscrete = false)
+        : binWidth(width), counts(bins, 0), samples(0), sum(0.0), max(0.0), discrete(isDiscrete) {}
+
+    void Add(double value);
+    void Merge(const Histogram& other);
+    double Mean() const;
+    double Percentile(double q) const;  // 離散ならビンの値、連続ならビン内で線形補間
+};
+
+// AmpduAggregator: AP の送信 A-MPDU を mpduRefNumber ごとにメモリ上で集約し、AC 別に統計をとる
+// MonitorSnifferTx の MPDU 単位の通知を、最終サブフレーム（LAST_MPDU_IN_AGGREGATE）が来た時点で
+// 1 つの A-MPDU として確定する。集約なしの MPDU は 1 サブフレームの送信として数える。
+class AmpduAggregator {
+public:
+    AmpduAggregator();
+
+    void AddMpdu(Ptr<const Packet> packet, uint16_t channelFreqMhz, const WifiTxVector& txVector,
+                 const MpduInfo& aMpdu, uint16_t staId);
+    // 未確定の A-MPDU を確定させる（シミュレーション終了時）
+    void Flush();
+    // 他の AP の集計を合算（BSS ごとに mpduRefNumber が独立なため AP 単位で集約してから合わせる）
+    void Merge(const AmpduAggregator& other);
+
+    void WriteSummary(const std::string& filename) const;
+    void WriteHistograms(const std::string& filename) const;
+
+private:
+    // 組み立て中の A-MPDU
+    struct OpenAggregate {
+        uint8_t ac;
+        uint32_t subframes;
+        uint32_t bytes;
+        uint16_t channelFreqMhz;
+        uint16_t staId;  // MU PPDU 内のユーザ識別（SU は SU_STA_ID）
+        WifiTxVector txVector;
+        Mac48Address receiver;
+        std::vector<uint32_t> frameIds;  // 含まれる映像フレームID（重複なし）
+        std::vector<uint8_t> frameTypes;
+    };
+
+    // AC ごとの統計
+    struct AcStats {
+        uint64_t aggregates;
+        Histogram subframes;
+        Histogram bytes;
+        Histogram airtimeUs;
+        Histogram frames;
+        uint64_t multiFrameAggregates;
+
+        AcStats()
+            : aggregates(0), subframes(1.0, 257, true), bytes(1000.0, 1025), airtimeUs(100.0, 101),
+              frames(1.0, 65, true),
+              multiFrameAggregates(0) {}
+    };
+
+    // 映像フレームごとの分割状況
+    struct FrameSpan {
+        uint8_t frameType;
+        uint32_t aggregates;  // このフレームのパケットを含んだ A-MPDU 数
+    };
+
+    void Close(OpenAggregate& agg);
+
+    std::unordered_map<uint64_t, OpenAggregate> m_open;  // (周波数, staId, mpduRefNumber) → 組み立て中
+    AcStats m_acStats[4];
+    std::map<std::pair<Mac48Address, uint32_t>, FrameSpan> m_frameSpans;  // (受信 STA, フレームID)
+};
+
 // PHY 層受信トレースコールバック
 void PhyRxTrace(Ptr<OutputStreamWrapper> stream,
                 std::string context,
@@ -20,6 +145,71 @@ void PhyRxTrace(Ptr<OutputStreamWrapper> stream,
                 ns3::SignalNoiseDbm signalNoise,
                 uint16_t staId);
 
+// PHY 層受信失敗トレースコールバック
+void PhyRxDropTrace(ContentionCounters* counters,
+                    std::string context,
+                    ns3::Ptr<const ns3::Packet> packet,
+                    ns3::WifiPhyRxfailureReason reason);
+
+// MAC 送信失敗（再送）トレースコールバック
+void MacTxDataFailedTrace(ContentionCounters* counters,
+                          std::string context,
+                          ns3::Mac48Address address);
+
+// 再送上限到達トレースコールバック
+void MacTxFinalDataFailedTrace(ContentionCounters* counters,
+                               std::string context,
+                               ns3::Mac48Address address);
+
+// リンク単位の送信時間（エアタイム）トレースコールバック
+void LinkTxAirtimeTrace(LinkStats* stats,
+                        ns3::WifiPhyBand band,
+                        std::string context,
+                        ns3::WifiConstPsduMap psduMap,
+                        ns3::WifiTxVector txVector,
+                        double txPowerW);
+
+// A-MPDU 集約トレースコールバック（AP の MonitorSnifferTx）
+void AmpduTxTrace(AmpduAggregator* aggregator,
+                  std::string context,
+                  ns3::Ptr<const ns3::Packet> packet,
+                  uint16_t channelFreqMhz,
+                  ns3::WifiTxVector txVector,
+                  ns3::MpduInfo aMpdu,
+                  uint16_t staId);
+
+// リンク単位の映像パケット受信トレースコールバック（STA 側）
+void LinkRxTrace(LinkStats* stats,
+                 std::string context,
+                 ns3::Ptr<const ns3::Packet> packet,
+                 uint16_t channelFreqMhz,
+                 ns3::WifiTxVector txVector,
+                 ns3::MpduInfo aMpdu,
+                 ns3::SignalNoiseDbm signalNoise,
+                 uint16_t staId);
+
+// キュー長の最大値トレースコールバック（PacketsInQueue）
+void QueueDepthTrace(uint32_t* peak, uint32_t oldValue, uint32_t newValue);
+
+// PHY 状態の滞在時間トレースコールバック（WifiPhyStateHelper の State、状態を抜けたときに通知）
+void PhyStateTrace(RadioStateStats* stats, std::string context, Time start, Time duration, WifiPhyState state);
+// stop の時点で続いている PHY 状態を stop まで加える（stop に Schedule する）
+void FlushRadioState(RadioStateStats* stats, Ptr<WifiPhy> phy);
+
+// パケット数のカウンタトレースコールバック（WAN 区間の損失 PhyRxDrop など）
+void PacketCountTrace(uint64_t* count, Ptr<const Packet> packet);
+
+// 輻輳制御の目標ビットレートトレースコールバック（送信側）
+void CcTargetRateTrace(Ptr<OutputStreamWrapper> stream, double targetBps);
+
+// 遅延勾配トレースコールバック（受信側の帯域推定）
+void CcDelayGradientTrace(Ptr<OutputStreamWrapper> stream,
+                          double modifiedTrend,
+                          double threshold,
+                          uint32_t usage,
+                          double targetBps,
+                          double ceAlpha);
+
 }
 
 
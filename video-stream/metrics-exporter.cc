@@ -0,0 +1,194 @@
+#include "metrics-exporter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("MetricsExporter");
+
+LiveMetricsSampler::LiveMetricsSampler()
+    : m_sinkType(SINK_NONE), m_ring(nullptr), m_slots(nullptr), m_mapSize(0), m_socket(-1),
+      m_published(0), m_dropped(0) {
+}
+
+LiveMetricsSampler::~LiveMetricsSampler() {
+    Close();
+}
+
+bool LiveMetricsSampler::Open(const std::string& sink, uint32_t ringCapacity) {
+    Close();
+
+    if (sink.compare(0, 4, "shm:") == 0) {
+        NS_ABORT_MSG_IF(ringCapacity == 0, "ringCapacity must be at least 1");
+        m_shmName = sink.substr(4);
+        int fd = shm_open(m_shmName.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            NS_LOG_ERROR("shm_open failed for " << m_shmName << ": " << std::strerror(errno));
+            return false;
+        }
+        m_mapSize = sizeof(MetricsRingHeader) + static_cast<size_t>(ringCapacity) * sizeof(MetricsRecord);
+        if (ftruncate(fd, m_mapSize) < 0) {
+            NS_LOG_ERROR("ftruncate failed for " << m_shmName << ": " << std::strerror(errno));
+            close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            NS_LOG_ERROR("mmap failed for " << m_shmName << ": " << std::strerror(errno));
+            return false;
+        }
+        // 全ページを事前に確保しておき、サンプリング中にページフォルトで止まらないようにする
+        std::memset(addr, 0, m_mapSize);
+        m_ring = new (addr) MetricsRingHeader;
+        m_ring->capacity = ringCapacity;
+        m_ring->recordSize = sizeof(MetricsRecord);
+        m_ring->version = METRICS_RING_VERSION;
+        m_ring->head.store(0, std::memory_order_relaxed);
+        m_ring->tail.store(0, std::memory_order_relaxed);
+        // magic は最後に書き、読み手が初期化途中のヘッダを見ないようにする
+        std::atomic_thread_fence(std::memory_order_release);
+        m_ring->magic = METRICS_RING_MAGIC;
+        m_slots = reinterpret_cast<MetricsRecord*>(static_cast<uint8_t*>(addr) + sizeof(MetricsRingHeader));
+        m_sinkType = SINK_SHM;
+        return true;
+    }
+
+    if (sink.compare(0, 5, "unix:") == 0) {
+        m_socketPath = sink.substr(5);
+        if (m_socketPath.size() >= sizeof(sockaddr_un::sun_path)) {
+            NS_LOG_ERROR("Socket path too long: " << m_socketPath);
+            return false;
+        }
+        m_socket = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        if (m_socket < 0) {
+            NS_LOG_ERROR("socket failed: " << std::strerror(errno));
+            return false;
+        }
+        m_sinkType = SINK_UNIX;
+        return true;
+    }
+
+    NS_LOG_ERROR("Unknown metrics sink: " << sink << " (use shm:<name> or unix:<path>)");
+    return false;
+}
+
+void LiveMetricsSampler::Close() {
+    Stop();
+    if (m_ring != nullptr) {
+        munmap(m_ring, m_mapSize);
+        m_ring = nullptr;
+        m_slots = nullptr;
+    }
+    if (m_socket >= 0) {
+        close(m_socket);
+        m_socket = -1;
+    }
+    m_sinkType = SINK_NONE;
+}
+
+void LiveMetricsSampler::AddFlow(uint32_t bss, uint32_t sta, Ptr<VideoFrameReceiverApplication> receiver) {
+    Flow flow;
+    flow.bss = bss;
+    flow.sta = sta;
+    flow.receiver = receiver;
+    m_flows.push_back(flow);
+}
+
+void LiveMetricsSampler::SetBssQueues(uint32_t bss, std::vector<Ptr<WifiMacQueue>> queues) {
+    if (m_bssQueues.size() <= bss) {
+        m_bssQueues.resize(bss + 1);
+    }
+    m_bssQueues[bss] = queues;
+}
+
+void LiveMetricsSampler::Start(Time interval, Time finalizeAge) {
+    m_interval = interval;
+    m_finalizeAge = finalizeAge;
+    m_event = Simulator::Schedule(m_interval, &LiveMetricsSampler::Sample, this);
+}
+
+void LiveMetricsSampler::Stop() {
+    if (m_event.IsPending()) {
+        Simulator::Cancel(m_event);
+    }
+}
+
+uint64_t LiveMetricsSampler::GetPublished() const { return m_published; }
+uint64_t LiveMetricsSampler::GetDropped() const { return m_dropped; }
+
+void LiveMetricsSampler::Sample() {
+    double now = Simulator::Now().GetSeconds();
+    double seconds = m_interval.GetSeconds();
+
+    for (uint32_t flowId = 0; flowId < m_flows.size(); flowId++) {
+        const Flow& flow = m_flows[flowId];
+        VideoLiveSample sample = flow.receiver->TakeLiveSample(m_finalizeAge);
+
+        MetricsRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.simTime = now;
+        record.flowId = flowId;
+        record.bss = flow.bss;
+        record.sta = flow.sta;
+        record.finalizedFrames = sample.finalizedFrames;
+        record.rxPackets = sample.rxPackets;
+        record.rxBytes = sample.rxBytes;
+        record.expectedPackets = sample.expectedPackets;
+        record.lostPackets = sample.lostPackets;
+        record.throughputMbps = sample.rxBytes * 8.0 / seconds / 1e6;
+        record.lossRatio = sample.expectedPackets > 0 ? sample.lostPackets * 100.0 / sample.expectedPackets : 0.0;
+        record.p50Latency = sample.p50Latency;
+        record.p95Latency = sample.p95Latency;
+        record.p99Latency = sample.p99Latency;
+        if (flow.bss < m_bssQueues.size()) {
+            const std::vector<Ptr<WifiMacQueue>>& queues = m_bssQueues[flow.bss];
+            for (size_t ac = 0; ac < queues.size() && ac < 4; ac++) {
+                record.queueDepth[ac] = queues[ac] ? queues[ac]->GetNPackets() : 0;
+            }
+        }
+        Publish(record);
+    }
+
+    m_event = Simulator::Schedule(m_interval, &LiveMetricsSampler::Sample, this);
+}
+
+// 非ブロッキングで公開（満杯・読み手不在ならレコードを捨てる）
+void LiveMetricsSampler::Publish(const MetricsRecord& record) {
+    if (m_sinkType == SINK_SHM) {
+        uint64_t head = m_ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = m_ring->tail.load(std::memory_order_acquire);
+        if (head - tail >= m_ring->capacity) {
+            m_dropped++;
+            return;
+        }
+        m_slots[head % m_ring->capacity] = record;
+        m_ring->head.store(head + 1, std::memory_order_release);
+        m_published++;
+        return;
+    }
+
+    if (m_sinkType == SINK_UNIX) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, m_socketPath.c_str(), m_socketPath.size());
+        ssize_t sent = sendto(m_socket, &record, sizeof(record), MSG_DONTWAIT,
+                              reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        if (sent == static_cast<ssize_t>(sizeof(record))) {
+            m_published++;
+        } else {
+            // EAGAIN（受信バッファ満杯）、ENOENT/ECONNREFUSED（ダッシュボード未起動）など
+            m_dropped++;
+        }
+    }
+}
+
+}
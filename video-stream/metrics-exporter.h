@@ -0,0 +1,106 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "video-frame.h"
+#include "ns3/wifi-mac-queue.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// MetricsRecord: 1 フロー 1 サンプル分のライブメトリクス（ダッシュボードとの共有フォーマット）
+// 共有メモリリングと Unix ドメインソケットのどちらでもこの構造体をそのままバイナリで書き出す
+struct MetricsRecord {
+    double simTime;          // サンプル時刻 (秒)
+    uint32_t flowId;
+    uint32_t bss;
+    uint32_t sta;
+    uint32_t finalizedFrames;
+    uint64_t rxPackets;
+    uint64_t rxBytes;
+    uint64_t expectedPackets;
+    uint64_t lostPackets;
+    double throughputMbps;
+    double lossRatio;        // 確定フレームのパケットロス率 (%)
+    double p50Latency;       // ミリ秒
+    double p95Latency;
+    double p99Latency;
+    uint32_t queueDepth[4];  // AP の WifiMacQueue 長（AC_BE, AC_BK, AC_VI, AC_VO の順）
+};
+
+// MetricsRingHeader: 共有メモリリングの先頭に置くヘッダ（単一書き手・単一読み手）
+// 書き手（シミュレーション）は head を、読み手（ダッシュボード）は tail を進める。
+// レコード i はヘッダ直後の (i % capacity) 番目のスロットに置かれる。
+// 満杯なら書き手はレコードを捨てるだけで待たない。
+struct MetricsRingHeader {
+    uint32_t magic;       // METRICS_RING_MAGIC
+    uint32_t version;
+    uint32_t capacity;    // スロット数
+    uint32_t recordSize;  // sizeof(MetricsRecord)
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "metrics ring requires lock-free 64-bit atomics");
+
+const uint32_t METRICS_RING_MAGIC = 0x564d5452;  // "VMTR"
+const uint32_t METRICS_RING_VERSION = 1;
+
+// LiveMetricsSampler: シミュレーション時間で一定間隔ごとにフローの状態をサンプリングして公開する
+// 公開先は "shm:<名前>"（POSIX 共有メモリのリング）または "unix:<パス>"（Unix データグラムソケット）。
+// どちらも非ブロッキングで、読み手が追いつかない・存在しない場合はレコードを捨てて数えるだけ。
+class LiveMetricsSampler : public SimpleRefCount<LiveMetricsSampler> {
+public:
+    LiveMetricsSampler();
+    ~LiveMetricsSampler();
+
+    bool Open(const std::string& sink, uint32_t ringCapacity);
+    void Close();
+
+    void AddFlow(uint32_t bss, uint32_t sta, Ptr<VideoFrameReceiverApplication> receiver);
+    // BSS の AP キュー（AC_BE, AC_BK, AC_VI, AC_VO の順）
+    void SetBssQueues(uint32_t bss, std::vector<Ptr<WifiMacQueue>> queues);
+
+    void Start(Time interval, Time finalizeAge);
+    void Stop();
+
+    uint64_t GetPublished() const;
+    uint64_t GetDropped() const;
+
+private:
+    struct Flow {
+        uint32_t bss;
+        uint32_t sta;
+        Ptr<VideoFrameReceiverApplication> receiver;
+    };
+
+    void Sample();
+    void Publish(const MetricsRecord& record);
+
+    enum SinkType {
+        SINK_NONE = 0,
+        SINK_SHM,
+        SINK_UNIX
+    };
+
+    SinkType m_sinkType;
+    std::string m_shmName;
+    MetricsRingHeader* m_ring;
+    MetricsRecord* m_slots;
+    size_t m_mapSize;
+    int m_socket;
+    std::string m_socketPath;
+
+    std::vector<Flow> m_flows;
+    std::vector<std::vector<Ptr<WifiMacQueue>>> m_bssQueues;
+    Time m_interval;
+    Time m_finalizeAge;
+    EventId m_event;
+    uint64_t m_published;
+    uint64_t m_dropped;
+};
+
+}
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,114 @@
+#include "multicast-convert-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("MulticastConvertQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(MulticastConvertQueueDisc);
+
+TypeId MulticastConvertQueueDisc::GetTypeId() {
+    static TypeId tid = TypeId("ns3::MulticastConvertQueueDisc")
+        .SetParent<QueueDisc>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<MulticastConvertQueueDisc>()
+        .AddAttribute("MaxSize",
+                      "The max queue size",
+                      QueueSizeValue(QueueSize("1000p")),
+                      MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                      MakeQueueSizeChecker());
+    return tid;
+}
+
+MulticastConvertQueueDisc::MulticastConvertQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE), m_convertedPackets(0), m_unicastCopies(0) {
+}
+
+MulticastConvertQueueDisc::~MulticastConvertQueueDisc() {
+}
+
+void MulticastConvertQueueDisc::SetMembers(const std::vector<Mac48Address>& members) {
+    m_members = members;
+}
+
+uint64_t MulticastConvertQueueDisc::GetConvertedPackets() const {
+    return m_convertedPackets;
+}
+
+uint64_t MulticastConvertQueueDisc::GetUnicastCopies() const {
+    return m_unicastCopies;
+}
+
+bool MulticastConvertQueueDisc::EnqueueItem(Ptr<QueueDiscItem> item) {
+    if (GetCurrentSize() + item > GetMaxSize()) {
+        NS_LOG_LOGIC("Queue full -- dropping pkt");
+        DropBeforeEnqueue(item, LIMIT_EXCEEDED_DROP);
+        return false;
+    }
+    return GetInternalQueue(0)->Enqueue(item);
+}
+
+// 複製は格納時に行い、各複製を 1 パケットとして MaxSize の判定と統計に乗せる。
+// 1 個目はこの呼び出しで格納し、残りは Enqueue を通して別パケットとして受け付けるので、
+// 受信数 = 格納数 + 格納前廃棄数 の整合も保たれる。
+bool MulticastConvertQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item) {
+    Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem>(item);
+    if (!ipv4Item || m_members.empty() || !Mac48Address::IsMatchingType(item->GetAddress())) {
+        return EnqueueItem(item);
+    }
+    Mac48Address destination = Mac48Address::ConvertFrom(item->GetAddress());
+    if (!destination.IsGroup() || destination.IsBroadcast()) {
+        return EnqueueItem(item);
+    }
+
+    // メンバごとに IP ヘッダを共有したまま宛先 MAC を差し替えた複製を作る
+    m_convertedPackets++;
+    bool enqueued = false;
+    for (size_t i = 0; i < m_members.size(); i++) {
+        Ptr<Ipv4QueueDiscItem> copy = Create<Ipv4QueueDiscItem>(ipv4Item->GetPacket()->Copy(), m_members[i],
+                                                                ipv4Item->GetProtocol(), ipv4Item->GetHeader());
+        m_unicastCopies++;
+        if (i == 0) {
+            enqueued = EnqueueItem(copy);
+        } else {
+            Enqueue(copy);
+        }
+    }
+    NS_LOG_LOGIC("Converted group packet into " << m_members.size() << " unicast copies");
+    return enqueued;
+}
+
+Ptr<QueueDiscItem> MulticastConvertQueueDisc::DoDequeue() {
+    Ptr<QueueDiscItem> item = GetInternalQueue(0)->Dequeue();
+    if (!item) {
+        NS_LOG_LOGIC("Queue empty");
+        return nullptr;
+    }
+    return item;
+}
+
+bool MulticastConvertQueueDisc::CheckConfig() {
+    if (GetNQueueDiscClasses() > 0) {
+        NS_LOG_ERROR("MulticastConvertQueueDisc cannot have classes");
+        return false;
+    }
+    if (GetNPacketFilters() > 0) {
+        NS_LOG_ERROR("MulticastConvertQueueDisc needs no packet filter");
+        return false;
+    }
+    if (GetNInternalQueues() == 0) {
+        AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+            "MaxSize", QueueSizeValue(GetMaxSize())));
+    }
+    if (GetNInternalQueues() != 1) {
+        NS_LOG_ERROR("MulticastConvertQueueDisc needs 1 internal queue");
+        return false;
+    }
+    return true;
+}
+
+void MulticastConvertQueueDisc::InitializeParams() {
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef MULTICAST_CONVERT_QUEUE_DISC_H
+#define MULTICAST_CONVERT_QUEUE_DISC_H
+
+#include "ns3/mac48-address.h"
+#include "ns3/queue-disc.h"
+#include <vector>
+
+namespace ns3 {
+
+// MulticastConvertQueueDisc: グループ宛てのパケットをメンバ STA ごとのユニキャストに複製する FIFO キューディスク
+// AP の WiFi デバイスで mq の各 AC キューの子として使う（multicast-to-unicast 変換）。
+// 複製は宛先 MAC だけを STA に置き換え、IP 宛先はグループアドレスのまま残すので、
+// 受信側の UDP ソケットからは通常のマルチキャストと同じに見える。
+// ユニキャストになるため STA ごとの ACK・再送・A-MPDU 集約・レート制御の対象になる。
+// 複製はそれぞれ 1 パケットとして MaxSize と統計（受信・格納・廃棄）に数える。
+// グループ宛て以外（ブロードキャストを含む）はそのまま通す。
+class MulticastConvertQueueDisc : public QueueDisc {
+public:
+    static TypeId GetTypeId();
+    MulticastConvertQueueDisc();
+    ~MulticastConvertQueueDisc() override;
+
+    static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";
+
+    // 変換先の STA（AP に関連付けた映像 STA の MAC アドレス）
+    void SetMembers(const std::vector<Mac48Address>& members);
+    // 変換したグループ宛てパケット数と、生成したユニキャストのパケット数
+    uint64_t GetConvertedPackets() const;
+    uint64_t GetUnicastCopies() const;
+
+private:
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+
+    bool EnqueueItem(Ptr<QueueDiscItem> item);
+
+    std::vector<Mac48Address> m_members;
+    uint64_t m_convertedPackets;
+    uint64_t m_unicastCopies;
+};
+
+}
+
+#endif // MULTICAST_CONVERT_QUEUE_DISC_H
@@ -0,0 +1,122 @@
+#include "quality-estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+namespace {
+
+// フレームタイプ別のモデル係数
+struct QualityTableEntry {
+    double cleanPsnr;     // 無損失時の PSNR (dB)
+    double concealPsnr;   // 隠蔽領域の PSNR (dB)（I: 空間補間, P/B: 参照からの動き補償コピー）
+    double cleanSsim;
+    double concealSsim;
+    double propagation;   // 参照フレームの劣化が伝搬する割合（イントラ MB による減衰を含む）
+};
+
+// 0=I, 1=P, 2=B
+const QualityTableEntry QUALITY_TABLE[3] = {
+    {40.0, 22.0, 0.980, 0.62, 0.00},
+    {38.5, 26.0, 0.975, 0.74, 0.90},
+    {37.0, 28.0, 0.970, 0.80, 0.75},
+};
+
+// フリーズ（フレーム全体の欠落）時の画質
+const double FROZEN_PSNR = 20.0;
+const double FROZEN_SSIM = 0.60;
+
+// バースト長 1 パケットあたりの隠蔽難易度の割り増し
+const double BURST_PENALTY = 0.15;
+const double BURST_PENALTY_MAX = 2.0;
+
+// SVC 拡張レイヤ 1 つあたりの画質差（空間・SNR スケーラビリティの典型的なレイヤ間差）
+const double LAYER_PSNR_STEP = 2.5;
+const double LAYER_SSIM_STEP = 0.012;
+
+const double PEAK_SQUARED = 255.0 * 255.0;
+
+double PsnrToMse(double psnr) {
+    return PEAK_SQUARED / std::pow(10.0, psnr / 10.0);
+}
+
+}
+
+double QualityEstimator::LossDamage(const std::vector<bool>& receivedMask) {
+    return LossDamage(receivedMask, receivedMask.size());
+}
+
+double QualityEstimator::LossDamage(const std::vector<bool>& receivedMask, size_t count) {
+    count = std::min(count, receivedMask.size());
+    if (count == 0) {
+        return 0.0;
+    }
+
+    double damagedArea = 0.0;
+    uint32_t burst = 0;
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count && !receivedMask[i]) {
+            burst++;
+            continue;
+        }
+        if (burst > 0) {
+            double weight = std::min(1.0 + BURST_PENALTY * (burst - 1), BURST_PENALTY_MAX);
+            damagedArea += burst * weight;
+            burst = 0;
+        }
+    }
+    return std::min(damagedArea / count, 1.0);
+}
+
+double QualityEstimator::TotalDamage(uint32_t frameType, double ownDamage, double fwdRefDamage,
+                                     double bwdRefDamage) {
+    const QualityTableEntry& entry = QUALITY_TABLE[std::min(frameType, 2u)];
+
+    double refDamage = 0.0;
+    if (fwdRefDamage >= 0.0 && bwdRefDamage >= 0.0) {
+        // 双予測は 2 参照の平均なので劣化も平均化される
+        refDamage = 0.5 * (fwdRefDamage + bwdRefDamage);
+    } else if (fwdRefDamage >= 0.0) {
+        refDamage = fwdRefDamage;
+    } else if (bwdRefDamage >= 0.0) {
+        refDamage = bwdRefDamage;
+    }
+    refDamage *= entry.propagation;
+
+    return 1.0 - (1.0 - ownDamage) * (1.0 - refDamage);
+}
+
+FrameQuality QualityEstimator::Estimate(uint32_t frameType, double damage) {
+    const QualityTableEntry& entry = QUALITY_TABLE[std::min(frameType, 2u)];
+    damage = std::max(0.0, std::min(damage, 1.0));
+
+    double mse = (1.0 - damage) * PsnrToMse(entry.cleanPsnr) + damage * PsnrToMse(entry.concealPsnr);
+
+    FrameQuality quality;
+    quality.psnr = 10.0 * std::log10(PEAK_SQUARED / mse);
+    quality.ssim = (1.0 - damage) * entry.cleanSsim + damage * entry.concealSsim;
+    return quality;
+}
+
+FrameQuality QualityEstimator::ApplyLayerLoss(FrameQuality quality, uint32_t missingLayers) {
+    quality.psnr -= LAYER_PSNR_STEP * missingLayers;
+    quality.ssim -= LAYER_SSIM_STEP * missingLayers;
+    return quality;
+}
+
+double QualityEstimator::RefreshedDamage(double damage, uint32_t refreshedFrames, uint32_t period) {
+    if (period == 0 || refreshedFrames >= period) {
+        return 0.0;
+    }
+    return damage * (1.0 - static_cast<double>(refreshedFrames) / period);
+}
+
+FrameQuality QualityEstimator::FrozenQuality() {
+    FrameQuality quality;
+    quality.psnr = FROZEN_PSNR;
+    quality.ssim = FROZEN_SSIM;
+    return quality;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef QUALITY_ESTIMATOR_H
+#define QUALITY_ESTIMATOR_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+// 推定画質（PSNR/SSIM）
+struct FrameQuality {
+    double psnr;  // dB
+    double ssim;
+};
+
+// QualityEstimator: デコードを行わずにロスパターンから画質を推定する解析モデル
+// フレームタイプごとのテーブル（無損失時と隠蔽領域の PSNR/SSIM、参照劣化の伝搬率）を引くだけなので
+// フレームあたりの計算量はパケット数に比例する程度で、長時間・多フローでも常時計算できる。
+//
+// 劣化率 D（フレーム面積のうち正しく復号できない割合）は
+//   自フレームのロス: 各パケットが等面積の領域を運ぶとし、連続ロス（バースト）は周辺情報がなく
+//                     隠蔽が難しいため長さに応じて割り増す
+//   参照の劣化:       参照フレームの劣化率 × 伝搬率（B は 2 参照の平均）
+// を 1 - (1 - 自フレーム)(1 - 参照) で合成する。
+// PSNR は MSE = (1-D)·MSE_clean + D·MSE_conceal から、SSIM は線形補間で求める。
+// イントラリフレッシュでは参照をたどらず、直近 1 周期の各フレームの劣化が
+// イントラ列で書き換えられずに残った面積 D·(1 - k/周期)（k は後続フレーム数）を合成する。
+class QualityEstimator {
+public:
+    // パケットの受信状況から自フレームの劣化率を算出
+    static double LossDamage(const std::vector<bool>& receivedMask);
+    // 先頭 count パケットだけで算出（SVC のベースレイヤなど。マスクをコピーしない）
+    static double LossDamage(const std::vector<bool>& receivedMask, size_t count);
+    // 参照フレームの劣化率（-1 = 参照なし）を含めた総劣化率
+    static double TotalDamage(uint32_t frameType, double ownDamage, double fwdRefDamage, double bwdRefDamage);
+    // 総劣化率から PSNR/SSIM を推定
+    static FrameQuality Estimate(uint32_t frameType, double damage);
+    // 復号できなかった SVC 拡張レイヤの数だけ画質を下げる
+    static FrameQuality ApplyLayerLoss(FrameQuality quality, uint32_t missingLayers);
+    // イントラリフレッシュ: 劣化した領域はその後のフレームのイントラ列で書き換えられ、1 周期で消える
+    static double RefreshedDamage(double damage, uint32_t refreshedFrames, uint32_t period);
+    // 1 パケットも届かなかったフレーム（直前フレームの表示継続）の画質
+    static FrameQuality FrozenQuality();
+};
+
+}
+
+#endif // QUALITY_ESTIMATOR_H
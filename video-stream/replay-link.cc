@@ -0,0 +1,606 @@
+#include "replay-link.h"
+#include "video-frame.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/qos-utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ReplayLink");
+
+NS_OBJECT_ENSURE_REGISTERED(ReplaySimpleChannel);
+
+namespace {
+
+const double LOAD_WINDOW_MS = 100.0;
+const uint64_t MIN_SAMPLES = 30;      // これ未満の条件は粗い集計へフォールバック
+const double RANK_JITTER = 0.05;      // フレーム内で遅延順位を揺らす幅
+const uint16_t IPV4_PROTOCOL = 0x0800;
+
+// packet_log の 1 フレーム分（受信できたパケット番号 → 遅延）
+struct LoggedFrame {
+    double txTime;
+    uint8_t frameType;
+    uint32_t totalPackets;
+    std::map<uint32_t, double> latencies;   // フレーム送信開始から受信まで (ミリ秒)
+    std::map<uint32_t, double> sendDelays;  // パケット自身の送信から受信まで (ミリ秒、SendTime 列があるログのみ)
+};
+
+std::vector<std::string> SplitCsv(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        fields.push_back(item);
+    }
+    return fields;
+}
+
+uint8_t ParseFrameType(const std::string& type) {
+    if (type == "P") {
+        return 1;
+    }
+    if (type == "B") {
+        return 2;
+    }
+    return 0;
+}
+
+// CSV の数値フィールド（数値でなければファイル名と行番号を付けて中断）
+uint32_t ParseUnsignedField(const std::vector<std::string>& fields, size_t index, const std::string& filename,
+                            uint64_t lineNumber) {
+    const std::string& field = fields[index];
+    char* end = nullptr;
+    errno = 0;
+    unsigned long value = std::strtoul(field.c_str(), &end, 10);
+    NS_ABORT_MSG_IF(field.empty() || field[0] == '-' || *end != '\0' || errno != 0 ||
+                        value > std::numeric_limits<uint32_t>::max(),
+                    filename << ":" << lineNumber << ": column " << index + 1 << " is not an unsigned integer: '"
+                             << field << "'");
+    return static_cast<uint32_t>(value);
+}
+
+double ParseDoubleField(const std::vector<std::string>& fields, size_t index, const std::string& filename,
+                        uint64_t lineNumber) {
+    const std::string& field = fields[index];
+    char* end = nullptr;
+    errno = 0;
+    double value = std::strtod(field.c_str(), &end);
+    NS_ABORT_MSG_IF(field.empty() || *end != '\0' || errno != 0 || !std::isfinite(value),
+                    filename << ":" << lineNumber << ": column " << index + 1 << " is not a number: '" << field
+                             << "'");
+    return value;
+}
+
+// 列が足りない行は中断（空行は飛ばす）
+bool CheckFieldCount(const std::vector<std::string>& fields, size_t required, const std::string& filename,
+                     uint64_t lineNumber) {
+    if (fields.empty()) {
+        return false;
+    }
+    NS_ABORT_MSG_IF(fields.size() < required, filename << ":" << lineNumber << ": expected at least " << required
+                                                       << " columns, got " << fields.size());
+    return true;
+}
+
+// hasSendTime: SendTime 列（パケット自身の送信時刻）があるログか
+bool ReadPacketLog(const std::string& filename, std::map<uint32_t, LoggedFrame>& frames, bool& hasSendTime) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        return false;
+    }
+    // 先頭 9 列は固定。SendTime と FlowID（複数フローのみ）はヘッダの列名で探す
+    std::string line;
+    std::getline(in, line);
+    std::vector<std::string> header = SplitCsv(line);
+    size_t sendTimeColumn = 0;
+    size_t flowIdColumn = 0;
+    for (size_t i = 9; i < header.size(); i++) {
+        if (header[i] == "SendTime(sec)") {
+            sendTimeColumn = i;
+        } else if (header[i] == "FlowID") {
+            flowIdColumn = i;
+        }
+    }
+    hasSendTime = sendTimeColumn > 0;
+    size_t required = std::max<size_t>(9, std::max(sendTimeColumn, flowIdColumn) + 1);
+
+    uint64_t lineNumber = 1;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::vector<std::string> fields = SplitCsv(line);
+        if (!CheckFieldCount(fields, required, filename, lineNumber)) {
+            continue;
+        }
+        // 複数フローの実行ではパケットログが 1 ファイルにまとまっているので先頭フローだけを使う
+        if (flowIdColumn > 0 && ParseUnsignedField(fields, flowIdColumn, filename, lineNumber) != 0) {
+            continue;
+        }
+        uint32_t frameId = ParseUnsignedField(fields, 3, filename, lineNumber);
+        uint32_t packetIndex = ParseUnsignedField(fields, 5, filename, lineNumber);
+        double rxTime = ParseDoubleField(fields, 1, filename, lineNumber);
+        double latencyMs = ParseDoubleField(fields, 2, filename, lineNumber);
+        LoggedFrame& frame = frames[frameId];
+        if (frame.latencies.empty()) {
+            frame.txTime = ParseDoubleField(fields, 0, filename, lineNumber);
+            frame.frameType = ParseFrameType(fields[4]);
+            frame.totalPackets = ParseUnsignedField(fields, 6, filename, lineNumber);
+        }
+        frame.latencies.emplace(packetIndex, latencyMs);
+        if (hasSendTime) {
+            double sendTime = ParseDoubleField(fields, sendTimeColumn, filename, lineNumber);
+            frame.sendDelays.emplace(packetIndex, (rxTime - sendTime) * 1000.0);
+        }
+    }
+    return true;
+}
+
+double Quantile(const std::vector<double>& sorted, double u) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    double pos = std::min(std::max(u, 0.0), 1.0) * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(pos);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (pos - lower);
+}
+
+// 検証用のフレームタイプ別集計（インデックス 3 = 全体）
+struct LogSummary {
+    std::vector<double> latencies[4];
+    uint64_t expected[4] = {0, 0, 0, 0};
+    uint64_t received[4] = {0, 0, 0, 0};
+    uint32_t frames[4] = {0, 0, 0, 0};
+    uint32_t completeFrames[4] = {0, 0, 0, 0};
+    uint32_t onTimeFrames[4] = {0, 0, 0, 0};
+};
+
+LogSummary SummarizeLog(const std::map<uint32_t, LoggedFrame>& frames, double deadlineMs) {
+    LogSummary summary;
+    for (const auto& entry : frames) {
+        const LoggedFrame& frame = entry.second;
+        bool complete = frame.latencies.size() >= frame.totalPackets;
+        double frameLatency = 0.0;
+        for (const auto& packet : frame.latencies) {
+            frameLatency = std::max(frameLatency, packet.second);
+        }
+        for (uint32_t scope : {static_cast<uint32_t>(frame.frameType), 3u}) {
+            summary.expected[scope] += frame.totalPackets;
+            summary.received[scope] += frame.latencies.size();
+            summary.frames[scope]++;
+            summary.completeFrames[scope] += complete ? 1 : 0;
+            summary.onTimeFrames[scope] += (complete && frameLatency <= deadlineMs) ? 1 : 0;
+            for (const auto& packet : frame.latencies) {
+                summary.latencies[scope].push_back(packet.second);
+            }
+        }
+    }
+    for (auto& latencies : summary.latencies) {
+        std::sort(latencies.begin(), latencies.end());
+    }
+    return summary;
+}
+
+}
+
+ReplayLinkModel::ReplayLinkModel()
+    : m_hasAc(false), m_packetRelative(false), m_trainingPackets(0), m_fixedDelay(Seconds(0)) {
+}
+
+uint32_t ReplayLinkModel::MakeKey(uint8_t ac, uint8_t position, uint8_t load) {
+    return (static_cast<uint32_t>(ac) << 16) | (static_cast<uint32_t>(position) << 8) | load;
+}
+
+void ReplayLinkModel::AddSample(uint8_t ac, uint8_t position, uint8_t load, bool lost, bool previousLost,
+                                double delayMs) {
+    // 細かい条件から全体まで、フォールバック先の集計にも同じサンプルを入れる
+    const uint32_t keys[] = {
+        MakeKey(ac, position, load), MakeKey(ac, position, ANY), MakeKey(ac, ANY, load),
+        MakeKey(ac, ANY, ANY), MakeKey(ANY, ANY, ANY),
+    };
+    for (uint32_t key : keys) {
+        Bucket& bucket = m_buckets[key];
+        bucket.sent++;
+        if (lost) {
+            bucket.lost++;
+        } else {
+            bucket.delaysMs.push_back(delayMs);
+        }
+        if (previousLost) {
+            bucket.afterLoss++;
+            bucket.lostAfterLoss += lost ? 1 : 0;
+        }
+    }
+}
+
+bool ReplayLinkModel::Load(const std::string& packetLog, const std::string& qosLog) {
+    std::map<uint32_t, LoggedFrame> frames;
+    if (!ReadPacketLog(packetLog, frames, m_packetRelative) || frames.empty()) {
+        return false;
+    }
+
+    // PhyRx ログの TID から (フレームID, パケット番号) ごとの AC を引く（最初の受信を採用）
+    std::map<uint64_t, uint8_t> packetAc;
+    m_hasAc = false;
+    if (!qosLog.empty()) {
+        std::ifstream in(qosLog);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::string line;
+        std::getline(in, line);  // ヘッダ
+        uint64_t lineNumber = 1;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            std::vector<std::string> fields = SplitCsv(line);
+            if (!CheckFieldCount(fields, 5, qosLog, lineNumber)) {
+                continue;
+            }
+            uint32_t tid = ParseUnsignedField(fields, 4, qosLog, lineNumber);
+            NS_ABORT_MSG_IF(tid > 7, qosLog << ":" << lineNumber << ": TID out of range: " << tid);
+            uint64_t key = (static_cast<uint64_t>(ParseUnsignedField(fields, 1, qosLog, lineNumber)) << 32) |
+                           ParseUnsignedField(fields, 3, qosLog, lineNumber);
+            packetAc.emplace(key, static_cast<uint8_t>(QosUtilsMapTidToAc(static_cast<uint8_t>(tid))));
+        }
+        m_hasAc = !packetAc.empty();
+    }
+
+    // 負荷: フレーム送信開始時点で直近ウィンドウ内に送られた映像パケット数
+    std::vector<std::pair<double, uint32_t>> frameStarts;
+    for (const auto& entry : frames) {
+        frameStarts.emplace_back(entry.second.txTime, entry.first);
+    }
+    std::sort(frameStarts.begin(), frameStarts.end());
+    std::map<uint32_t, uint32_t> frameLoad;
+    std::vector<uint32_t> packetLoads;
+    size_t head = 0;
+    uint32_t windowPackets = 0;
+    for (size_t i = 0; i < frameStarts.size(); i++) {
+        windowPackets += frames[frameStarts[i].second].totalPackets;
+        while (frameStarts[head].first <= frameStarts[i].first - LOAD_WINDOW_MS / 1000.0) {
+            windowPackets -= frames[frameStarts[head].second].totalPackets;
+            head++;
+        }
+        frameLoad[frameStarts[i].second] = windowPackets;
+        packetLoads.insert(packetLoads.end(), frames[frameStarts[i].second].totalPackets, windowPackets);
+    }
+    std::sort(packetLoads.begin(), packetLoads.end());
+    m_loadThresholds.clear();
+    for (uint32_t bin = 1; bin < LOAD_BINS; bin++) {
+        m_loadThresholds.push_back(packetLoads[packetLoads.size() * bin / LOAD_BINS]);
+    }
+
+    // フレームごとに欠けたパケット番号を損失として数える
+    // フレーム全体が届かなかった場合は packet_log に現れないため対象外
+    m_buckets.clear();
+    m_trainingPackets = 0;
+    for (const auto& entry : frames) {
+        const LoggedFrame& frame = entry.second;
+        uint8_t frameAc = AC_UNKNOWN;
+        if (m_hasAc) {
+            // 損失したパケットには同じフレームで受信できたパケットの AC を使う
+            for (const auto& packet : frame.latencies) {
+                auto it = packetAc.find((static_cast<uint64_t>(entry.first) << 32) | packet.first);
+                if (it != packetAc.end()) {
+                    frameAc = it->second;
+                    break;
+                }
+            }
+        }
+        uint8_t load = GetLoadBin(frameLoad[entry.first]);
+        bool previousLost = false;
+        for (uint32_t index = 0; index < frame.totalPackets; index++) {
+            auto packet = frame.latencies.find(index);
+            bool lost = (packet == frame.latencies.end());
+            uint8_t ac = frameAc;
+            if (!lost && m_hasAc) {
+                auto it = packetAc.find((static_cast<uint64_t>(entry.first) << 32) | index);
+                if (it != packetAc.end()) {
+                    ac = it->second;
+                }
+            }
+            // SendTime 列があればパケット自身の送信からの遅延、なければフレーム送信開始からの遅延
+            double delayMs = 0.0;
+            if (!lost) {
+                delayMs = m_packetRelative ? frame.sendDelays.at(index) : packet->second;
+            }
+            AddSample(ac, GetPositionBin(index, frame.totalPackets), load, lost, previousLost, delayMs);
+            previousLost = lost;
+            m_trainingPackets++;
+        }
+    }
+    for (auto& entry : m_buckets) {
+        std::sort(entry.second.delaysMs.begin(), entry.second.delaysMs.end());
+    }
+    return true;
+}
+
+void ReplayLinkModel::SetFixedDelay(Time delay) {
+    m_fixedDelay = delay;
+}
+
+Time ReplayLinkModel::GetLoadWindow() const {
+    return MicroSeconds(static_cast<int64_t>(LOAD_WINDOW_MS * 1000));
+}
+
+bool ReplayLinkModel::IsPacketRelative() const {
+    return m_packetRelative;
+}
+
+uint8_t ReplayLinkModel::GetModelAc(uint8_t ac) const {
+    return m_hasAc ? ac : AC_UNKNOWN;
+}
+
+uint8_t ReplayLinkModel::GetPositionBin(uint32_t packetIndex, uint32_t totalPackets) {
+    if (packetIndex == 0) {
+        return 0;
+    }
+    if (packetIndex + 1 >= totalPackets) {
+        return POSITION_BINS - 1;
+    }
+    return (packetIndex * 2 < totalPackets) ? 1 : 2;
+}
+
+uint8_t ReplayLinkModel::GetLoadBin(uint32_t windowPackets) const {
+    uint8_t bin = 0;
+    while (bin < m_loadThresholds.size() && windowPackets >= m_loadThresholds[bin]) {
+        bin++;
+    }
+    return bin;
+}
+
+const ReplayLinkModel::Bucket* ReplayLinkModel::FindBucket(uint8_t ac, uint8_t position, uint8_t load) const {
+    const uint32_t keys[] = {
+        MakeKey(ac, position, load), MakeKey(ac, position, ANY), MakeKey(ac, ANY, ANY), MakeKey(ANY, ANY, ANY),
+    };
+    const Bucket* bucket = nullptr;
+    for (uint32_t key : keys) {
+        auto it = m_buckets.find(key);
+        if (it == m_buckets.end()) {
+            continue;
+        }
+        bucket = &it->second;
+        if (bucket->sent >= MIN_SAMPLES && !bucket->delaysMs.empty()) {
+            break;
+        }
+    }
+    return bucket;
+}
+
+bool ReplayLinkModel::SampleLoss(uint8_t ac, uint8_t position, uint8_t load, bool previousLost, double u) const {
+    const Bucket* bucket = FindBucket(ac, position, load);
+    if (bucket == nullptr || bucket->sent == 0) {
+        return false;
+    }
+    double lossProb;
+    uint64_t afterOk = bucket->sent - bucket->afterLoss;
+    if (previousLost && bucket->afterLoss > 0) {
+        lossProb = static_cast<double>(bucket->lostAfterLoss) / bucket->afterLoss;
+    } else if (!previousLost && afterOk > 0) {
+        lossProb = static_cast<double>(bucket->lost - bucket->lostAfterLoss) / afterOk;
+    } else {
+        lossProb = static_cast<double>(bucket->lost) / bucket->sent;
+    }
+    return u < lossProb;
+}
+
+Time ReplayLinkModel::SampleDelay(uint8_t ac, uint8_t position, uint8_t load, double u) const {
+    const Bucket* bucket = FindBucket(ac, position, load);
+    if (bucket == nullptr || bucket->delaysMs.empty()) {
+        return Seconds(0);
+    }
+    Time delay = MicroSeconds(static_cast<int64_t>(Quantile(bucket->delaysMs, u) * 1000.0)) - m_fixedDelay;
+    return std::max(delay, Seconds(0));
+}
+
+Time ReplayLinkModel::SampleFrameLatency(uint8_t ac, uint8_t position, uint8_t load, double u) const {
+    const Bucket* bucket = FindBucket(ac, position, load);
+    if (bucket == nullptr || bucket->delaysMs.empty()) {
+        return Seconds(0);
+    }
+    return MicroSeconds(static_cast<int64_t>(Quantile(bucket->delaysMs, u) * 1000.0));
+}
+
+uint64_t ReplayLinkModel::GetTrainingPackets() const {
+    return m_trainingPackets;
+}
+
+void ReplayLinkModel::WriteModel(const std::string& filename) const {
+    const char* acStr[] = {"BE", "BK", "VI", "VO", "-"};
+    const char* positionStr[] = {"First", "Early", "Late", "Last"};
+
+    std::ofstream out(filename);
+    out << "AC,Position,Load,Packets,LossRate(%),LossAfterLoss(%),P50Delay(ms),P95Delay(ms),P99Delay(ms)" << std::endl;
+    for (const auto& entry : m_buckets) {
+        uint8_t ac = (entry.first >> 16) & 0xff;
+        uint8_t position = (entry.first >> 8) & 0xff;
+        uint8_t load = entry.first & 0xff;
+        const Bucket& bucket = entry.second;
+        out << (ac == ANY ? "*" : acStr[ac]) << ","
+            << (position == ANY ? "*" : positionStr[position]) << ",";
+        if (load == ANY) {
+            out << "*,";
+        } else {
+            out << static_cast<int>(load) << ",";
+        }
+        out << bucket.sent << ","
+            << std::fixed << std::setprecision(3)
+            << (bucket.sent > 0 ? bucket.lost * 100.0 / bucket.sent : 0.0) << ","
+            << (bucket.afterLoss > 0 ? bucket.lostAfterLoss * 100.0 / bucket.afterLoss : 0.0) << ","
+            << Quantile(bucket.delaysMs, 0.50) << ","
+            << Quantile(bucket.delaysMs, 0.95) << ","
+            << Quantile(bucket.delaysMs, 0.99) << std::endl;
+    }
+}
+
+void ReplayLinkModel::WriteValidation(const std::string& referenceLog, const std::string& replayLog,
+                                      const std::string& filename, double deadlineMs) {
+    std::map<uint32_t, LoggedFrame> referenceFrames;
+    std::map<uint32_t, LoggedFrame> replayFrames;
+    bool hasSendTime = false;
+    if (!ReadPacketLog(referenceLog, referenceFrames, hasSendTime) ||
+        !ReadPacketLog(replayLog, replayFrames, hasSendTime)) {
+        NS_LOG_WARN("Replay validation skipped: cannot read " << referenceLog << " or " << replayLog);
+        return;
+    }
+    LogSummary reference = SummarizeLog(referenceFrames, deadlineMs);
+    LogSummary replay = SummarizeLog(replayFrames, deadlineMs);
+
+    std::ofstream out(filename);
+    out << "Scope,Metric,FullStack,Replay,AbsError" << std::endl;
+    auto writeRow = [&out](const char* scope, const char* metric, double fullStack, double replayed) {
+        out << scope << ","
+            << metric << ","
+            << std::fixed << std::setprecision(3) << fullStack << ","
+            << replayed << ","
+            << std::abs(replayed - fullStack) << std::endl;
+    };
+    const char* scopeStr[] = {"I", "P", "B", "All"};
+    for (uint32_t scope = 0; scope < 4; scope++) {
+        if (reference.frames[scope] == 0 && replay.frames[scope] == 0) {
+            continue;
+        }
+        auto lossRate = [scope](const LogSummary& s) {
+            return s.expected[scope] > 0 ? (s.expected[scope] - s.received[scope]) * 100.0 / s.expected[scope] : 0.0;
+        };
+        auto frameRatio = [scope](const LogSummary& s, const uint32_t* counts) {
+            return s.frames[scope] > 0 ? counts[scope] * 100.0 / s.frames[scope] : 0.0;
+        };
+        auto mean = [scope](const LogSummary& s) {
+            double sum = 0.0;
+            for (double latency : s.latencies[scope]) {
+                sum += latency;
+            }
+            return s.latencies[scope].empty() ? 0.0 : sum / s.latencies[scope].size();
+        };
+        writeRow(scopeStr[scope], "PacketLoss(%)", lossRate(reference), lossRate(replay));
+        writeRow(scopeStr[scope], "CompleteFrames(%)", frameRatio(reference, reference.completeFrames),
+                 frameRatio(replay, replay.completeFrames));
+        writeRow(scopeStr[scope], "OnTimeFrames(%)", frameRatio(reference, reference.onTimeFrames),
+                 frameRatio(replay, replay.onTimeFrames));
+        writeRow(scopeStr[scope], "MeanLatency(ms)", mean(reference), mean(replay));
+        writeRow(scopeStr[scope], "P50Latency(ms)", Quantile(reference.latencies[scope], 0.50),
+                 Quantile(replay.latencies[scope], 0.50));
+        writeRow(scopeStr[scope], "P95Latency(ms)", Quantile(reference.latencies[scope], 0.95),
+                 Quantile(replay.latencies[scope], 0.95));
+        writeRow(scopeStr[scope], "P99Latency(ms)", Quantile(reference.latencies[scope], 0.99),
+                 Quantile(replay.latencies[scope], 0.99));
+    }
+}
+
+TypeId ReplaySimpleChannel::GetTypeId() {
+    static TypeId tid = TypeId("ns3::ReplaySimpleChannel")
+        .SetParent<SimpleChannel>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<ReplaySimpleChannel>();
+    return tid;
+}
+
+ReplaySimpleChannel::ReplaySimpleChannel() : m_loadPackets(0) {
+    m_uniform = CreateObject<UniformRandomVariable>();
+}
+
+void ReplaySimpleChannel::SetModel(Ptr<ReplayLinkModel> model) {
+    m_model = model;
+}
+
+void ReplaySimpleChannel::SetAccessPoint(Ptr<SimpleNetDevice> device) {
+    m_accessPoint = device;
+}
+
+int64_t ReplaySimpleChannel::AssignStreams(int64_t stream) {
+    m_uniform->SetStream(stream);
+    return 1;
+}
+
+uint32_t ReplaySimpleChannel::UpdateLoad(bool newFrame, uint32_t totalPackets) {
+    Time now = Simulator::Now();
+    if (newFrame) {
+        m_loadWindow.emplace_back(now, totalPackets);
+        m_loadPackets += totalPackets;
+    }
+    while (!m_loadWindow.empty() && m_loadWindow.front().first <= now - m_model->GetLoadWindow()) {
+        m_loadPackets -= m_loadWindow.front().second;
+        m_loadWindow.pop_front();
+    }
+    return m_loadPackets;
+}
+
+void ReplaySimpleChannel::Send(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                               Ptr<SimpleNetDevice> sender) {
+    Ipv4Header ipHeader;
+    if (!m_model || protocol != IPV4_PROTOCOL || p->PeekHeader(ipHeader) == 0) {
+        Deliver(p, protocol, to, from, sender, Seconds(0));
+        return;
+    }
+
+    // ToS の上位 3 ビットがユーザー優先度（TID）
+    uint8_t ac = static_cast<uint8_t>(QosUtilsMapTidToAc(ipHeader.GetTos() >> 5));
+    uint8_t modelAc = m_model->GetModelAc(ac);
+    DestinationState& state = m_destinations[to];
+    bool downlink = (sender == m_accessPoint);
+
+    VideoFrameTag tag;
+    bool video = p->PeekPacketTag(tag) && tag.GetFrameId() != static_cast<uint32_t>(-1);
+    uint8_t position = ReplayLinkModel::ANY;
+    uint8_t load = ReplayLinkModel::ANY;
+    if (video) {
+        bool newFrame = (tag.GetFrameId() != state.frameId);
+        load = m_model->GetLoadBin(UpdateLoad(newFrame, tag.GetTotalPackets()));
+        position = ReplayLinkModel::GetPositionBin(tag.GetPacketIndex(), tag.GetTotalPackets());
+        if (newFrame) {
+            state.frameId = tag.GetFrameId();
+            state.rank = m_uniform->GetValue();
+            state.previousLost = false;
+        } else {
+            state.rank = std::min(std::max(state.rank + m_uniform->GetValue(-RANK_JITTER, RANK_JITTER), 0.0), 1.0);
+        }
+    }
+
+    if (downlink && m_model->SampleLoss(modelAc, position, load, video && state.previousLost, m_uniform->GetValue())) {
+        if (video) {
+            state.previousLost = true;
+        }
+        return;
+    }
+    if (video) {
+        state.previousLost = false;
+    }
+
+    double rank = video ? state.rank : m_uniform->GetValue();
+    Time arrival;
+    if (downlink && video && !m_model->IsPacketRelative()) {
+        // 送信時刻のない古いログ: 遅延はフレーム送信開始が基準なので、フレーム送信開始に足す
+        arrival = Seconds(tag.GetTransmissionStartTime()) + m_model->SampleFrameLatency(modelAc, position, load, rank);
+        arrival = std::max(arrival, Simulator::Now());
+    } else {
+        // パケット自身の送信からの遅延なので、この再生実行のペーシング・FEC の送信間隔がそのまま到着に反映される
+        arrival = Simulator::Now() + m_model->SampleDelay(modelAc, position, load, rank);
+    }
+    arrival = std::max(arrival, state.lastArrival[ac]);
+    state.lastArrival[ac] = arrival;
+    Deliver(p, protocol, to, from, sender, arrival - Simulator::Now());
+}
+
+void ReplaySimpleChannel::Deliver(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                                  Ptr<SimpleNetDevice> sender, Time delay) {
+    // 受信側のアドレス判定は SimpleNetDevice::Receive に任せる
+    for (std::size_t i = 0; i < GetNDevices(); i++) {
+        Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice>(GetDevice(i));
+        if (device == sender) {
+            continue;
+        }
+        Simulator::ScheduleWithContext(device->GetNode()->GetId(), delay, &SimpleNetDevice::Receive, device,
+                                       p->Copy(), protocol, to, from);
+    }
+}
+
+}
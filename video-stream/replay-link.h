@@ -0,0 +1,126 @@
+#ifndef REPLAY_LINK_H
+#define REPLAY_LINK_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// ReplayLinkModel: 全スタック実行のログから作る Wi-Fi 区間の遅延・損失モデル
+// packet_log（受信アプリ）からパケットごとの遅延（SendTime 列があればパケット自身の送信から、
+// なければフレーム送信開始からの受信まで）と、TotalPackets に対して欠けたパケット番号を損失として取り出し、
+// PhyRx/qos_log の TID から AC を対応付ける。
+// 条件は AC × フレーム内の位置（先頭・前半・後半・末尾）× 負荷（直近ウィンドウ内の映像パケット数の 3 分位）で、
+// サンプルが少ない条件は 負荷 → 位置 → AC の順に条件を外した集計へフォールバックする。
+// 損失は直前のパケット（同一フレーム内）の損失有無で条件付けし、連続損失を再現する。
+class ReplayLinkModel : public SimpleRefCount<ReplayLinkModel> {
+public:
+    static const uint32_t POSITION_BINS = 4;
+    static const uint32_t LOAD_BINS = 3;
+    static const uint8_t AC_UNKNOWN = 4;  // AC の情報がないログ
+    static const uint8_t ANY = 0xff;      // 条件を外した集計
+
+    ReplayLinkModel();
+
+    // qosLog が空なら AC は区別しない。数値でないフィールドや列の足りない行があれば行番号付きで中断する
+    bool Load(const std::string& packetLog, const std::string& qosLog);
+    // 遅延がパケット自身の送信時刻からか（false = SendTime 列のない古いログでフレーム送信開始から）
+    bool IsPacketRelative() const;
+    // 再生リンク以外の区間（有線 p2p など）の固定遅延。ログの遅延から差し引く
+    void SetFixedDelay(Time delay);
+    Time GetLoadWindow() const;
+
+    uint8_t GetModelAc(uint8_t ac) const;
+    static uint8_t GetPositionBin(uint32_t packetIndex, uint32_t totalPackets);
+    uint8_t GetLoadBin(uint32_t windowPackets) const;
+
+    // 条件に合う集計から損失の有無と遅延を引く（u は [0, 1) の一様乱数）
+    bool SampleLoss(uint8_t ac, uint8_t position, uint8_t load, bool previousLost, double u) const;
+    Time SampleDelay(uint8_t ac, uint8_t position, uint8_t load, double u) const;
+    // ログの遅延そのもの（固定遅延を差し引かない。古いログではフレーム送信開始から受信まで）
+    Time SampleFrameLatency(uint8_t ac, uint8_t position, uint8_t load, double u) const;
+
+    uint64_t GetTrainingPackets() const;
+    // 条件ごとのサンプル数・損失率・遅延分位点
+    void WriteModel(const std::string& filename) const;
+
+    // 全スタック実行と再生実行のパケットログをフレームタイプ別に比較
+    static void WriteValidation(const std::string& referenceLog, const std::string& replayLog,
+                                const std::string& filename, double deadlineMs);
+
+private:
+    struct Bucket {
+        std::vector<double> delaysMs;  // 受信できたパケットの遅延（昇順）
+        uint64_t sent;
+        uint64_t lost;
+        uint64_t afterLoss;      // 直前が損失だったパケット数
+        uint64_t lostAfterLoss;  // そのうち損失したパケット数
+
+        Bucket() : sent(0), lost(0), afterLoss(0), lostAfterLoss(0) {}
+    };
+
+    static uint32_t MakeKey(uint8_t ac, uint8_t position, uint8_t load);
+    // サンプル数の足りる最も細かい条件の集計（なければ全体）
+    const Bucket* FindBucket(uint8_t ac, uint8_t position, uint8_t load) const;
+    void AddSample(uint8_t ac, uint8_t position, uint8_t load, bool lost, bool previousLost, double delayMs);
+
+    std::map<uint32_t, Bucket> m_buckets;
+    std::vector<uint32_t> m_loadThresholds;  // 負荷ビンの境界（ウィンドウ内パケット数）
+    bool m_hasAc;
+    bool m_packetRelative;
+    uint64_t m_trainingPackets;
+    Time m_fixedDelay;
+};
+
+// ReplaySimpleChannel: Wi-Fi 区間の代わりに AP と STA の SimpleNetDevice をつなぐチャネル
+// AP からの下りの IPv4 パケットは ToS から AC を、VideoFrameTag からフレーム内の位置を求め、
+// モデルから引いた遅延・損失を与える。同じ宛先・AC の中では到着順を保つ（MAC キューの FIFO 相当）。
+// 同じフレームのパケットは遅延分布上の順位を近い値に保ち、フレーム単位の遅延の揺らぎを再現する。
+// 下りの映像パケットは自身の送信時刻（チャネルに入った時刻）に、パケット自身の送信から受信までの遅延を足して届けるので、
+// 再生実行のペーシング・FEC による送信間隔の違いが到着に反映される。
+// SendTime 列のない古いログでは遅延がフレーム送信開始からなので、フレーム送信開始時刻に足す（間隔を二重に数えない）。
+// 上りはログに情報がないため、AC の遅延分布だけを使い損失させない。IPv4 以外（ARP）は遅延なしで届ける。
+class ReplaySimpleChannel : public SimpleChannel {
+public:
+    static TypeId GetTypeId();
+    ReplaySimpleChannel();
+
+    void SetModel(Ptr<ReplayLinkModel> model);
+    void SetAccessPoint(Ptr<SimpleNetDevice> device);
+    int64_t AssignStreams(int64_t stream);
+
+    void Send(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+              Ptr<SimpleNetDevice> sender) override;
+
+private:
+    struct DestinationState {
+        uint32_t frameId;
+        double rank;        // フレーム内で共有する遅延分布上の順位
+        bool previousLost;
+        Time lastArrival[4];
+
+        DestinationState() : frameId(static_cast<uint32_t>(-1)), rank(0.5), previousLost(false) {}
+    };
+
+    // 新しいフレームの先頭ならウィンドウに加え、直近ウィンドウ内の映像パケット数を返す
+    uint32_t UpdateLoad(bool newFrame, uint32_t totalPackets);
+    void Deliver(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                 Ptr<SimpleNetDevice> sender, Time delay);
+
+    Ptr<ReplayLinkModel> m_model;
+    Ptr<SimpleNetDevice> m_accessPoint;
+    Ptr<UniformRandomVariable> m_uniform;
+    std::map<Mac48Address, DestinationState> m_destinations;
+    std::deque<std::pair<Time, uint32_t>> m_loadWindow;  // (フレーム先頭の到着時刻, フレームのパケット数)
+    uint32_t m_loadPackets;
+};
+
+}
+
+#endif // REPLAY_LINK_H
@@ -0,0 +1,69 @@
+#include "twt-scheduler.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("TwtScheduler");
+
+TwtScheduler::TwtScheduler(Time interval, Time duration, Time guard)
+    : m_interval(interval), m_duration(duration), m_guard(guard), m_servicePeriods(0) {
+    NS_ABORT_MSG_IF(!duration.IsStrictlyPositive(), "TWT service period must be positive");
+    NS_ABORT_MSG_IF(duration + guard >= interval, "TWT service period plus guard must be shorter than the interval");
+}
+
+void TwtScheduler::AddStation(Ptr<WifiNetDevice> apDevice, Ptr<WifiNetDevice> staDevice) {
+    Station station;
+    station.apMac = apDevice->GetMac();
+    station.staPhy = staDevice->GetPhy();
+    station.address = staDevice->GetMac()->GetAddress();
+    m_stations.push_back(station);
+}
+
+void TwtScheduler::Start(Time firstSp, Time stop) {
+    m_stop = stop;
+    Simulator::Schedule(firstSp - Simulator::Now(), &TwtScheduler::BeginServicePeriod, this);
+}
+
+Time TwtScheduler::GetInterval() const {
+    return m_interval;
+}
+
+Time TwtScheduler::GetDuration() const {
+    return m_duration;
+}
+
+uint64_t TwtScheduler::GetServicePeriods() const {
+    return m_servicePeriods;
+}
+
+void TwtScheduler::BeginServicePeriod() {
+    if (Simulator::Now() >= m_stop) {
+        return;
+    }
+    m_servicePeriods++;
+    for (Station& station : m_stations) {
+        if (station.staPhy->IsStateSleep()) {
+            station.staPhy->ResumeFromSleep();
+        }
+        station.apMac->UnblockUnicastTxOnLinks(WifiQueueBlockedReason::POWER_SAVE_MODE, station.address, {0});
+    }
+    Simulator::Schedule(m_duration, &TwtScheduler::EndServicePeriod, this);
+    Simulator::Schedule(m_interval, &TwtScheduler::BeginServicePeriod, this);
+}
+
+void TwtScheduler::EndServicePeriod() {
+    for (Station& station : m_stations) {
+        station.apMac->BlockUnicastTxOnLinks(WifiQueueBlockedReason::POWER_SAVE_MODE, station.address, {0});
+    }
+    Simulator::Schedule(m_guard, &TwtScheduler::Sleep, this);
+}
+
+void TwtScheduler::Sleep() {
+    for (Station& station : m_stations) {
+        if (!station.staPhy->IsStateSleep()) {
+            station.staPhy->SetSleepMode();
+        }
+    }
+    NS_LOG_LOGIC("Service period " << m_servicePeriods << " ended, " << m_stations.size() << " STA(s) asleep");
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef TWT_SCHEDULER_H
+#define TWT_SCHEDULER_H
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+#include <vector>
+
+namespace ns3 {
+
+// TwtScheduler: 映像のフレーム周期に合わせた個別 TWT（Target Wake Time）のサービス期間を再現する
+// 各 STA は Interval ごとに Duration だけ起きる（サービス期間 = SP）。SP の外では
+//   AP: その STA 宛てのユニキャスト送信をキューで止める（POWER_SAVE_MODE でブロック）
+//   STA: PHY をスリープさせる（SP 終了から Guard 後。進行中の送受信は PHY が終わるまで待つ）
+// Guard は SP 終了直前に始まった TXOP の BlockAck をスリープで取りこぼさないための猶予。
+// TWT の交渉（Action フレーム）は省き、STA が関連付け済みで合意済みの周期から始める。
+// 全 STA が同じ SP を共有する（STA ごとに SP の開始をずらさない）ので、SP 内では STA どうしが競合する。
+class TwtScheduler : public SimpleRefCount<TwtScheduler> {
+public:
+    TwtScheduler(Time interval, Time duration, Time guard);
+
+    void AddStation(Ptr<WifiNetDevice> apDevice, Ptr<WifiNetDevice> staDevice);
+    // firstSp に最初の SP を開始し、stop まで周期的に繰り返す
+    void Start(Time firstSp, Time stop);
+
+    Time GetInterval() const;
+    Time GetDuration() const;
+    uint64_t GetServicePeriods() const;
+
+private:
+    struct Station {
+        Ptr<WifiMac> apMac;
+        Ptr<WifiPhy> staPhy;
+        Mac48Address address;
+    };
+
+    void BeginServicePeriod();
+    void EndServicePeriod();
+    void Sleep();
+
+    Time m_interval;
+    Time m_duration;
+    Time m_guard;
+    Time m_stop;
+    std::vector<Station> m_stations;
+    uint64_t m_servicePeriods;
+};
+
+}
+
+#endif // TWT_SCHEDULER_H
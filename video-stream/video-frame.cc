@@ -18,17 +18,22 @@ TypeId VideoFrameTag::GetInstanceTypeId() const {
 
 VideoFrameTag::VideoFrameTag()
     : m_frameId(0), m_frameType(0), m_packetIndex(0), m_totalPackets(0),
-      m_forwardRefFrameId(-1), m_backwardRefFrameId(-1), m_transmissionStartTime(0.0) {
+      m_forwardRefFrameId(-1), m_backwardRefFrameId(-1), m_transmissionStartTime(0.0),
+      m_layerId(0), m_numLayers(1), m_layerPackets(0), m_sendTime(0.0), m_captureTime(0.0),
+      m_sliceId(0), m_numSlices(1), m_slicePackets(0) {
 }
 
 VideoFrameTag::VideoFrameTag(uint32_t frameId, uint32_t frameType, uint32_t packetIndex, uint32_t totalPackets,
                              int32_t forwardRefFrameId, int32_t backwardRefFrameId, double transmissionStartTime)
     : m_frameId(frameId), m_frameType(frameType), m_packetIndex(packetIndex), m_totalPackets(totalPackets),
-      m_forwardRefFrameId(forwardRefFrameId), m_backwardRefFrameId(backwardRefFrameId), m_transmissionStartTime(transmissionStartTime) {
+      m_forwardRefFrameId(forwardRefFrameId), m_backwardRefFrameId(backwardRefFrameId), m_transmissionStartTime(transmissionStartTime),
+      m_layerId(0), m_numLayers(1), m_layerPackets(totalPackets), m_sendTime(transmissionStartTime),
+      m_captureTime(transmissionStartTime), m_sliceId(0), m_numSlices(1), m_slicePackets(totalPackets) {
 }
 
 uint32_t VideoFrameTag::GetSerializedSize() const {
-    return 4 + 4 + 4 + 4 + 4 + 4 + 8;  // 4 uint32_t + 2 int32_t + 1 double
+    // 4 uint32_t + 2 int32_t + 1 double + 3 uint32_t (レイヤ情報) + 送信時刻 + キャプチャ時刻 + 3 uint32_t (スライス情報)
+    return 4 + 4 + 4 + 4 + 4 + 4 + 8 + 4 + 4 + 4 + 8 + 8 + 4 + 4 + 4;
 }
 
 void VideoFrameTag::Serialize(TagBuffer i) const {
@@ -39,6 +44,14 @@ void VideoFrameTag::Serialize(TagBuffer i) const {
     i.WriteU32(static_cast<uint32_t>(m_forwardRefFrameId));
     i.WriteU32(static_cast<uint32_t>(m_backwardRefFrameId));
     i.WriteDouble(m_transmissionStartTime);
+    i.WriteU32(m_layerId);
+    i.WriteU32(m_numLayers);
+    i.WriteU32(m_layerPackets);
+    i.WriteDouble(m_sendTime);
+    i.WriteDouble(m_captureTime);
+    i.WriteU32(m_sliceId);
+    i.WriteU32(m_numSlices);
+    i.WriteU32(m_slicePackets);
 }
 
 void VideoFrameTag::Deserialize(TagBuffer i) {
@@ -49,13 +62,23 @@ void VideoFrameTag::Deserialize(TagBuffer i) {
     m_forwardRefFrameId = static_cast<int32_t>(i.ReadU32());
     m_backwardRefFrameId = static_cast<int32_t>(i.ReadU32());
     m_transmissionStartTime = i.ReadDouble();
+    m_layerId = i.ReadU32();
+    m_numLayers = i.ReadU32();
+    m_layerPackets = i.ReadU32();
+    m_sendTime = i.ReadDouble();
+    m_captureTime = i.ReadDouble();
+    m_sliceId = i.ReadU32();
+    m_numSlices = i.ReadU32();
+    m_slicePackets = i.ReadU32();
 }
 
 void VideoFrameTag::Print(std::ostream& os) const {
     os << "FrameId=" << m_frameId << " Type=" << m_frameType
        << " Packet=" << m_packetIndex << "/" << m_totalPackets
        << " FwdRef=" << m_forwardRefFrameId << " BwdRef=" << m_backwardRefFrameId
-       << " TxTime=" << m_transmissionStartTime;
+       << " TxTime=" << m_transmissionStartTime
+       << " Layer=" << m_layerId << "/" << m_numLayers
+       << " Slice=" << m_sliceId << "/" << m_numSlices;
 }
 
 uint32_t VideoFrameTag::GetFrameId() const { return m_frameId; }
@@ -66,17 +89,56 @@ int32_t VideoFrameTag::GetForwardRefFrameId() const { return m_forwardRefFrameId
 int32_t VideoFrameTag::GetBackwardRefFrameId() const { return m_backwardRefFrameId; }
 double VideoFrameTag::GetTransmissionStartTime() const { return m_transmissionStartTime; }
 
+void VideoFrameTag::SetLayerInfo(uint32_t layerId, uint32_t numLayers, uint32_t layerPackets) {
+    m_layerId = layerId;
+    m_numLayers = numLayers;
+    m_layerPackets = layerPackets;
+}
+
+uint32_t VideoFrameTag::GetLayerId() const { return m_layerId; }
+uint32_t VideoFrameTag::GetNumLayers() const { return m_numLayers; }
+uint32_t VideoFrameTag::GetLayerPackets() const { return m_layerPackets; }
+
+void VideoFrameTag::SetSendTime(double sendTime) {
+    m_sendTime = sendTime;
+}
+
+double VideoFrameTag::GetSendTime() const { return m_sendTime; }
+
+void VideoFrameTag::SetCaptureTime(double captureTime) {
+    m_captureTime = captureTime;
+}
+
+double VideoFrameTag::GetCaptureTime() const { return m_captureTime; }
+
+void VideoFrameTag::SetSliceInfo(uint32_t sliceId, uint32_t numSlices, uint32_t slicePackets) {
+    m_sliceId = sliceId;
+    m_numSlices = numSlices;
+    m_slicePackets = slicePackets;
+}
+
+uint32_t VideoFrameTag::GetSliceId() const { return m_sliceId; }
+uint32_t VideoFrameTag::GetNumSlices() const { return m_numSlices; }
+uint32_t VideoFrameTag::GetSlicePackets() const { return m_slicePackets; }
+
 // VideoFrameSenderApplication Implementation
 TypeId VideoFrameSenderApplication::GetTypeId() {
     static TypeId tid = TypeId("ns3::VideoFrameSenderApplication")
         .SetParent<Application>()
         .SetGroupName("VideoFrame")
-        .AddConstructor<VideoFrameSenderApplication>();
+        .AddConstructor<VideoFrameSenderApplication>()
+        .AddTraceSource("TargetRate",
+                        "The target bitrate was updated from receiver feedback",
+                        MakeTraceSourceAccessor(&VideoFrameSenderApplication::m_targetRateTrace),
+                        "ns3::VideoFrameSenderApplication::TargetRateCallback");
     return tid;
 }
 
 VideoFrameSenderApplication::VideoFrameSenderApplication()
-    : m_peerPort(0), m_packetSize(512), m_gopSize(12), m_frameNum(0), m_edcaEnabled(true), m_packetGap(MicroSeconds(10)) {
+    : m_peerPort(0), m_packetSize(512), m_gopSize(12), m_frameNum(0), m_edcaEnabled(true), m_packetGap(MicroSeconds(10)),
+      m_steeringPolicy(STEER_NONE), m_fastLinkId(0), m_spreadCounter(0), m_numLayers(1), m_baseShare(0.5),
+      m_ccEnabled(false), m_ccMinRate(0.0), m_ccMaxRate(0.0), m_targetRate(0.0), m_nominalRate(0.0),
+      m_numSlices(1), m_decodeOrderTx(false), m_decodeSlot(0), m_ecn(0) {
     m_frameInterval = Seconds(0.033);  // 30fps
 }
 
@@ -107,72 +169,189 @@ void VideoFrameSenderApplication::SetEdcaEnabled(bool enabled) {
     m_edcaEnabled = enabled;
 }
 
-uint32_t VideoFrameSenderApplication::GetFrameType(uint32_t frameNum) {
-    uint32_t pos = frameNum % m_gopSize;
+void VideoFrameSenderApplication::SetLinkSteering(LinkSteeringPolicy policy, std::vector<uint8_t> linkTids,
+                                                  uint32_t fastLinkId) {
+    NS_ABORT_MSG_IF(policy != STEER_NONE && fastLinkId >= linkTids.size(), "fastLinkId out of range");
+    m_steeringPolicy = policy;
+    m_linkTids = linkTids;
+    m_fastLinkId = fastLinkId;
+}
 
-    // GOP 60 with last frame as P-frame
-    // Pattern: I B B P B B P B B P ... P (59 frames, then repeat)
-    if (pos == 0) return 0;  // I frame at position 0
-    if (pos == m_gopSize - 1) return 1;  // P frame at last position (59)
-    if (pos % 3 == 0) return 1;  // P frame at positions 3, 6, 9, ..., 57
-    return 2;  // B frame
+void VideoFrameSenderApplication::SetBitstreamSource(Ptr<AnnexBSource> source) {
+    m_source = source;
 }
 
-uint32_t VideoFrameSenderApplication::GetFramePackets(uint32_t frameType) {
-    // I > P > B の関係を反映したパケット数
-    switch (frameType) {
-        case 0:  // I frame
-            return 50;
-        case 1:  // P frame
-            return 30;
-        case 2:  // B frame
-            return 5;
-        default:
-            return 5;
+void VideoFrameSenderApplication::SetGopStructure(Ptr<GopStructure> gop) {
+    m_gop = gop;
+}
+
+void VideoFrameSenderApplication::SetSvcLayers(uint32_t numLayers, double baseShare) {
+    NS_ABORT_MSG_IF(numLayers == 0, "numLayers must be at least 1");
+    NS_ABORT_MSG_IF(baseShare <= 0.0 || baseShare > 1.0, "baseShare must be in (0, 1]");
+    m_numLayers = numLayers;
+    m_baseShare = baseShare;
+}
+
+void VideoFrameSenderApplication::SetCongestionControl(double minBps, double maxBps, double startBps) {
+    NS_ABORT_MSG_IF(minBps <= 0.0 || minBps > maxBps, "Invalid congestion control rate range");
+    m_ccEnabled = true;
+    m_ccMinRate = minBps;
+    m_ccMaxRate = maxBps;
+    m_targetRate = std::max(minBps, std::min(startBps, maxBps));
+}
+
+void VideoFrameSenderApplication::SetEncoderTiming(Ptr<EncoderTimingModel> encoder) {
+    m_encoder = encoder;
+}
+
+void VideoFrameSenderApplication::SetSlices(uint32_t numSlices) {
+    NS_ABORT_MSG_IF(numSlices == 0, "numSlices must be at least 1");
+    m_numSlices = numSlices;
+}
+
+void VideoFrameSenderApplication::SetDecodeOrder(bool enabled) {
+    m_decodeOrderTx = enabled;
+}
+
+void VideoFrameSenderApplication::SetEcnCodepoint(uint8_t ecn) {
+    NS_ABORT_MSG_IF(ecn > 3, "Invalid ECN codepoint " << static_cast<int>(ecn));
+    m_ecn = ecn;
+}
+
+uint32_t VideoFrameSenderApplication::NextDecodeOrderFrame() {
+    const std::vector<int32_t>& order = m_gop->GetDecodeOrder();
+    while (true) {
+        uint32_t gop = m_decodeSlot / order.size();
+        int64_t frameId = static_cast<int64_t>(gop) * m_gop->GetGopSize() + order[m_decodeSlot % order.size()];
+        m_decodeSlot++;
+        if (frameId >= 0) {
+            return static_cast<uint32_t>(frameId);
+        }
     }
 }
 
-// 前方参照フレームIDを取得
-int32_t VideoFrameSenderApplication::GetForwardRefFrameId(uint32_t frameNum, uint32_t frameType) {
-    // I フレーム: 参照なし
-    if (frameType == 0) {
-        return -1;
+// 合成フレームの GOP 1 周期分の平均ビットレート（目標レートに対するフレームサイズの倍率の基準）
+double VideoFrameSenderApplication::GetNominalRate() {
+    uint32_t gopSize = m_gop->GetGopSize();
+    uint64_t packets = 0;
+    for (uint32_t i = 0; i < gopSize; i++) {
+        packets += GetSyntheticFramePackets(i);
     }
+    return static_cast<double>(packets) / gopSize * m_packetSize * 8.0 / m_frameInterval.GetSeconds();
+}
 
-    uint32_t gopPos = frameNum % m_gopSize;
+// 目標ビットレートに合わせてフレームのパケット数を増減（フレームタイプ間の比率は保つ）
+uint32_t VideoFrameSenderApplication::ScaleFramePackets(uint32_t framePackets) const {
+    double scale = m_targetRate / m_nominalRate;
+    return std::max(1u, static_cast<uint32_t>(framePackets * scale + 0.5));
+}
 
+void VideoFrameSenderApplication::HandleFeedback(Ptr<Socket> socket) {
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv())) {
+        CongestionFeedbackTag feedback;
+        if (!packet->PeekPacketTag(feedback)) {
+            continue;
+        }
+        m_targetRate = std::max(m_ccMinRate, std::min(feedback.GetTargetRate(), m_ccMaxRate));
+        m_targetRateTrace(m_targetRate);
+        NS_LOG_INFO("Target rate " << m_targetRate / 1e6 << " Mbps (received " << feedback.GetReceivedRate() / 1e6
+                    << " Mbps, trend " << feedback.GetTrend() << ", " << feedback.GetCePackets() << " CE)");
+    }
+}
 
-    // 直前のI/Pフレーム位置を計算
-    uint32_t prevKeyPos;
-    if (gopPos < 3) {
-        // 位置1,2（最初のP(3)より前）はI(0)を参照
-        prevKeyPos = 0;
-    } else {
-        prevKeyPos = ((gopPos - 1) / 3) * 3;
-        if (prevKeyPos == 0) {
-            prevKeyPos = 0;  // Iフレーム
+// フレームの送信に使う ToS を決定（上位3ビットが TID になる）
+uint8_t VideoFrameSenderApplication::GetFrameTos(uint32_t frameType) {
+    if (m_steeringPolicy != STEER_NONE) {
+        // I フレームは常に最速リンクの TID
+        if (frameType == 0) {
+            return m_linkTids[m_fastLinkId] << 5;
+        }
+        // P/B フレームはフレーム単位でリンク間をラウンドロビン
+        if (m_steeringPolicy == STEER_SPREAD) {
+            uint32_t linkId = m_spreadCounter++ % m_linkTids.size();
+            return m_linkTids[linkId] << 5;
         }
     }
 
-    return (int32_t)(frameNum - gopPos + prevKeyPos);
+    // EDCA優先度制御
+    if (m_edcaEnabled) {
+        if (frameType == 0) {
+            return 0xe0;  // AC_VO
+        } else {
+            return 0x70;  // AC_BE
+        }
+    }
+    return 0x00;
 }
 
-// 後方参照フレームIDを取得（Bフレームのみ）
-int32_t VideoFrameSenderApplication::GetBackwardRefFrameId(uint32_t frameNum, uint32_t frameType) {
-    // I/Pフレーム: 後方参照なし
-    if (frameType != 2) {
-        return -1;
+// フレームのパケットをレイヤに分割（ベースレイヤに baseShare、残りを拡張レイヤに均等配分）
+// パケット数がレイヤ数に満たない場合はレイヤ数を減らし、各レイヤが必ず 1 パケット以上になるようにする
+void VideoFrameSenderApplication::SplitLayers(uint32_t framePackets) {
+    uint32_t numLayers = std::max(1u, std::min(m_numLayers, framePackets));
+    m_layerPackets.assign(numLayers, 0);
+    if (numLayers == 1) {
+        m_layerPackets[0] = framePackets;
+        return;
+    }
+
+    uint32_t base = static_cast<uint32_t>(framePackets * m_baseShare + 0.5);
+    base = std::max(1u, std::min(base, framePackets - (numLayers - 1)));
+    m_layerPackets[0] = base;
+
+    uint32_t rest = framePackets - base;
+    uint32_t enhancementLayers = numLayers - 1;
+    for (uint32_t l = 1; l < numLayers; l++) {
+        m_layerPackets[l] = rest / enhancementLayers + ((l - 1) < rest % enhancementLayers ? 1 : 0);
     }
+}
 
-    uint32_t gopPos = frameNum % m_gopSize;
+// スライスはパケット数を均等に分け（パケット数がスライス数に満たなければスライス数を減らす）、
+// 符号化器が空いてからフレームの符号化時間をスライス数で等分した時刻ごとに 1 スライスずつ完成させる
+void VideoFrameSenderApplication::ScheduleSlices(uint32_t frameType, uint32_t framePackets) {
+    uint32_t numSlices = std::max(1u, std::min(m_numSlices, framePackets));
+    m_slicePackets.assign(numSlices, 0);
+    m_sliceReady.assign(numSlices, Seconds(0));
+    for (uint32_t s = 0; s < numSlices; s++) {
+        m_slicePackets[s] = framePackets / numSlices + (s < framePackets % numSlices ? 1 : 0);
+    }
+    if (!m_encoder) {
+        return;
+    }
 
-    uint32_t nextKeyPos = ((gopPos / 3) + 1) * 3;
-    if (nextKeyPos >= m_gopSize) {
-        // GOPの最後のBフレームは次のGOPのIフレームを参照
-        nextKeyPos = m_gopSize;
+    Time now = Simulator::Now();
+    Time encodeStart = std::max(now, m_encoderFree);
+    Time encodeTime = m_encoder->SampleEncodeTime(frameType);
+    for (uint32_t s = 0; s < numSlices; s++) {
+        m_sliceReady[s] = encodeStart - now + NanoSeconds(encodeTime.GetNanoSeconds() * (s + 1) / numSlices);
     }
+    m_encoderFree = encodeStart + encodeTime;
+}
 
-    return (int32_t)(frameNum - gopPos + nextKeyPos);
+uint32_t VideoFrameSenderApplication::GetFramePackets(uint32_t frameType) {
+    // I > P > B の関係を反映したパケット数
+    switch (frameType) {
+        case 0:  // I frame
+            return 50;
+        case 1:  // P frame
+            return 30;
+        case 2:  // B frame
+            return 5;
+        default:
+            return 5;
+    }
+}
+
+// 1 周期の合計は I + (周期-1)·P で GOP 構成と同じになる
+uint32_t VideoFrameSenderApplication::GetSyntheticFramePackets(uint32_t frameId) {
+    uint32_t frameType = m_gop->GetFrameType(frameId);
+    if (!m_gop->IsIntraRefresh()) {
+        return GetFramePackets(frameType);
+    }
+    uint32_t period = m_gop->GetGopSize();
+    uint32_t column = GetFramePackets(0) - GetFramePackets(1);
+    uint32_t pos = m_gop->GetRefreshPosition(frameId);
+    return GetFramePackets(1) + column / period + (pos < column % period ? 1 : 0);
 }
 
 void VideoFrameSenderApplication::StartApplication() {
@@ -184,12 +363,33 @@ void VideoFrameSenderApplication::StartApplication() {
         NS_LOG_INFO("Sender connecting to " << m_peerAddress << ":" << m_peerPort);
     }
 
+    if (!m_gop) {
+        m_gop = Create<GopStructure>(GOP_IBBP, m_gopSize, 2, false);
+    }
+
+    m_encoderFree = Simulator::Now();
+    if (m_ccEnabled) {
+        // ビットストリームはフレームサイズを変えられないため、ペーサーの滞留が際限なく伸びる
+        NS_ABORT_MSG_IF(m_source, "Congestion control cannot scale frames read from a bitstream");
+        m_socket->SetRecvCallback(MakeCallback(&VideoFrameSenderApplication::HandleFeedback, this));
+        m_nominalRate = GetNominalRate();
+        m_pacerNext = Simulator::Now();
+        m_targetRateTrace(m_targetRate);
+    }
+
     // Send warmup packets to initialize WiFi MAC layer
     SendWarmupPackets();
 
     m_frameNum = 0;
+    m_decodeSlot = 0;
+    m_captureBase = Simulator::Now() + MilliSeconds(10);
     // Delay first frame generation to allow warmup packets to be processed
-    m_sendEvent = Simulator::Schedule(MilliSeconds(10), &VideoFrameSenderApplication::GenerateFrame, this);
+    // デコード順送信では後方参照されるアンカーのキャプチャを待つため、並べ替え深さ分だけ遅らせる
+    Time firstFrame = MilliSeconds(10);
+    if (m_decodeOrderTx && !m_source) {
+        firstFrame += m_frameInterval * m_gop->GetReorderDepth();
+    }
+    m_sendEvent = Simulator::Schedule(firstFrame, &VideoFrameSenderApplication::GenerateFrame, this);
 }
 
 void VideoFrameSenderApplication::StopApplication() {
@@ -198,6 +398,7 @@ void VideoFrameSenderApplication::StopApplication() {
     }
     if (m_socket) {
         m_socket->Close();
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
 }
 
@@ -239,13 +440,27 @@ VideoFrameSenderApplication::SendOnePacket(
     uint32_t framePackets,
     int32_t fwdRefFrameId,
     int32_t bwdRefFrameId,
-    double txStartTime)
+    double txStartTime,
+    uint8_t tos,
+    uint32_t packetSize,
+    uint32_t layerId,
+    uint32_t numLayers,
+    uint32_t layerPackets,
+    double captureTime,
+    uint32_t sliceId,
+    uint32_t numSlices,
+    uint32_t slicePackets)
 {
-    Ptr<Packet> packet = Create<Packet>(m_packetSize);
+    Ptr<Packet> packet = Create<Packet>(packetSize);
+    m_socket->SetIpTos(tos | m_ecn);
 
     VideoFrameTag tag(frameNum, frameType, packetIndex,
                       framePackets, fwdRefFrameId,
                       bwdRefFrameId, txStartTime);
+    tag.SetLayerInfo(layerId, numLayers, layerPackets);
+    tag.SetSendTime(Simulator::Now().GetSeconds());
+    tag.SetCaptureTime(captureTime);
+    tag.SetSliceInfo(sliceId, numSlices, slicePackets);
     packet->AddPacketTag(tag);
 
     int ret = m_socket->Send(packet);
@@ -263,42 +478,141 @@ VideoFrameSenderApplication::SendOnePacket(
 void
 VideoFrameSenderApplication::GenerateFrame()
 {
-    uint32_t frameType = GetFrameType(m_frameNum);
-    uint32_t framePackets = GetFramePackets(frameType);
-    int32_t fwdRefFrameId = GetForwardRefFrameId(m_frameNum, frameType);
-    int32_t bwdRefFrameId = GetBackwardRefFrameId(m_frameNum, frameType);
+    uint32_t frameId = m_frameNum;
+    uint32_t frameType;
+    uint32_t framePackets;
+    int32_t fwdRefFrameId;
+    int32_t bwdRefFrameId;
+    if (m_source) {
+        // ビットストリーム再生: フレームタイプ・参照・パケットサイズはスライスヘッダと RTP パケット化から
+        if (!m_source->NextAccessUnit(m_au)) {
+            NS_LOG_INFO("Bitstream ended after " << m_frameNum << " frames");
+            return;
+        }
+        frameType = m_au.frameType;
+        framePackets = m_au.packetSizes.size();
+        fwdRefFrameId = m_au.fwdRef;
+        bwdRefFrameId = m_au.bwdRef;
+    } else {
+        if (m_decodeOrderTx) {
+            frameId = NextDecodeOrderFrame();
+        }
+        frameType = m_gop->GetFrameType(frameId);
+        framePackets = GetSyntheticFramePackets(frameId);
+        if (m_ccEnabled) {
+            framePackets = ScaleFramePackets(framePackets);
+        }
+        fwdRefFrameId = m_gop->GetForwardRef(frameId);
+        bwdRefFrameId = m_gop->GetBackwardRef(frameId);
+    }
     const char* frameTypeStr[] = {"I", "P", "B"};
-    double txStartTime = Simulator::Now().GetSeconds();
+    // フレームのキャプチャ時刻はフレームの刻み、送信開始は最初のスライスの符号化完了
+    // デコード順送信では表示順の刻みでキャプチャ済みのフレームを後から符号化する
+    double captureTime = Simulator::Now().GetSeconds();
+    if (m_decodeOrderTx && !m_source) {
+        captureTime = (m_captureBase + m_frameInterval * frameId).GetSeconds();
+    }
+    ScheduleSlices(frameType, framePackets);
+    uint32_t numSlices = m_slicePackets.size();
+    double txStartTime = (Simulator::Now() + m_sliceReady[0]).GetSeconds();
 
     NS_LOG_INFO("Generating " << frameTypeStr[frameType]
-                << " frame " << m_frameNum
+                << " frame " << frameId
                 << " (" << framePackets << " packets)");
 
-    // EDCA優先度制御
-    if (m_edcaEnabled) {
-        if (frameType == 0) {
-            m_socket->SetIpTos(0xe0);  // AC_VO
-        } else {
-            m_socket->SetIpTos(0x70);  // AC_BE
+    uint8_t tos = GetFrameTos(frameType);
+    // 拡張レイヤは EDCA 有効時に AC_BK へ下げ、混雑時にベースレイヤより先に遅延・破棄されるようにする
+    uint8_t enhancementTos = m_edcaEnabled ? 0x20 : tos;
+
+    // SVC: ベースレイヤから順にパケットを並べる（パケット番号はフレーム内の通し番号）
+    SplitLayers(framePackets);
+    uint32_t numLayers = m_layerPackets.size();
+
+    // 輻輳制御時は目標レートの PACING_FACTOR 倍でペーシング（前フレームの残りの後ろに続ける）
+    const double PACING_FACTOR = 2.5;
+
+    // パケットの属するスライスと、スライス内の順番から送信までの時間を求める
+    auto getSlice = [this](uint32_t packetIndex, uint32_t& indexInSlice) {
+        uint32_t sliceId = 0;
+        indexInSlice = packetIndex;
+        while (indexInSlice >= m_slicePackets[sliceId]) {
+            indexInSlice -= m_slicePackets[sliceId];
+            sliceId++;
         }
-    }
+        return sliceId;
+    };
 
-    // ★ 修正点：パケットを時間差でスケジューリング
+    // ★ 修正点：パケットを時間差でスケジューリング（スライスは符号化完了から送り出す）
+    uint32_t layerId = 0;
+    uint32_t layerEnd = m_layerPackets[0];
     for (uint32_t i = 0; i < framePackets; i++) {
+        while (i >= layerEnd) {
+            layerId++;
+            layerEnd += m_layerPackets[layerId];
+        }
+        uint32_t indexInSlice;
+        uint32_t sliceId = getSlice(i, indexInSlice);
+        uint32_t packetSize = m_source ? m_au.packetSizes[i] : m_packetSize;
+        Time sendDelay = m_sliceReady[sliceId] + m_packetGap * indexInSlice;
+        if (m_ccEnabled) {
+            m_pacerNext = std::max(m_pacerNext, Simulator::Now() + m_sliceReady[sliceId]);
+            sendDelay = m_pacerNext - Simulator::Now();
+            m_pacerNext += Seconds(packetSize * 8.0 / (PACING_FACTOR * m_targetRate));
+        }
         Simulator::Schedule(
-            m_packetGap * i,
+            sendDelay,
             &VideoFrameSenderApplication::SendOnePacket,
             this,
-            m_frameNum,
+            frameId,
             frameType,
             i,
             framePackets,
             fwdRefFrameId,
             bwdRefFrameId,
-            txStartTime
+            txStartTime,
+            layerId == 0 ? tos : enhancementTos,
+            packetSize,
+            layerId,
+            numLayers,
+            m_layerPackets[layerId],
+            captureTime,
+            sliceId,
+            numSlices,
+            m_slicePackets[sliceId]
         );
     }
 
+    // I フレームの複製送信: 最速リンク以外のリンクにも同じパケットを流す（ベースレイヤのみ）
+    if (m_steeringPolicy == STEER_DUPLICATE && frameType == 0 && m_linkTids.size() > 1) {
+        uint32_t dupLinkId = (m_fastLinkId + m_linkTids.size() - 1) % m_linkTids.size();
+        uint8_t dupTos = m_linkTids[dupLinkId] << 5;
+        for (uint32_t i = 0; i < m_layerPackets[0]; i++) {
+            uint32_t indexInSlice;
+            uint32_t sliceId = getSlice(i, indexInSlice);
+            Simulator::Schedule(
+                m_sliceReady[sliceId] + m_packetGap * indexInSlice,
+                &VideoFrameSenderApplication::SendOnePacket,
+                this,
+                frameId,
+                frameType,
+                i,
+                framePackets,
+                fwdRefFrameId,
+                bwdRefFrameId,
+                txStartTime,
+                dupTos,
+                m_source ? m_au.packetSizes[i] : m_packetSize,
+                0,
+                numLayers,
+                m_layerPackets[0],
+                captureTime,
+                sliceId,
+                numSlices,
+                m_slicePackets[sliceId]
+            );
+        }
+    }
+
     m_frameNum++;
     m_sendEvent = Simulator::Schedule(
         m_frameInterval,
@@ -311,12 +625,24 @@ TypeId VideoFrameReceiverApplication::GetTypeId() {
     static TypeId tid = TypeId("ns3::VideoFrameReceiverApplication")
         .SetParent<Application>()
         .SetGroupName("VideoFrame")
-        .AddConstructor<VideoFrameReceiverApplication>();
+        .AddConstructor<VideoFrameReceiverApplication>()
+        .AddTraceSource("Rx",
+                        "A video packet has been received (duplicates excluded)",
+                        MakeTraceSourceAccessor(&VideoFrameReceiverApplication::m_rxTrace),
+                        "ns3::Packet::AddressTracedCallback")
+        .AddTraceSource("DelayGradient",
+                        "A packet group was evaluated by the delay-based bandwidth estimator",
+                        MakeTraceSourceAccessor(&VideoFrameReceiverApplication::m_delayGradientTrace),
+                        "ns3::VideoFrameReceiverApplication::DelayGradientCallback");
     return tid;
 }
 
 VideoFrameReceiverApplication::VideoFrameReceiverApplication()
-    : m_port(0), m_packetLogFile("") {
+    : m_port(0), m_flowId(0),
+      m_liveMetrics(false), m_liveCursor(0), m_firstFrameTime(Seconds(0)), m_frameInterval(Seconds(0)), m_typicalPackets{0, 0, 0},
+      m_packetLogFile(""),
+      m_deadline(MicroSeconds(33300)), m_decodeTime(Seconds(0)), m_decoderFree(0.0), m_pendingIntra(0), m_decodeNext(0),
+      m_hasFeedbackPeer(false), m_bweGroups(0), m_statsValid(false) {
 }
 
 VideoFrameReceiverApplication::~VideoFrameReceiverApplication() {
@@ -326,32 +652,83 @@ void VideoFrameReceiverApplication::SetPort(uint16_t port) {
     m_port = port;
 }
 
+void VideoFrameReceiverApplication::SetGopStructure(Ptr<GopStructure> gop) {
+    m_gop = gop;
+    m_statsValid = false;
+}
+
+void VideoFrameReceiverApplication::SetDeadline(Time deadline) {
+    m_deadline = deadline;
+    m_statsValid = false;
+}
+
+void VideoFrameReceiverApplication::EnableLiveMetrics(Time firstFrame, Time frameInterval) {
+    m_liveMetrics = true;
+    m_firstFrameTime = firstFrame;
+    m_frameInterval = frameInterval;
+}
+
+void VideoFrameReceiverApplication::SetDecodeTime(Time decodeTime) {
+    m_decodeTime = decodeTime;
+}
+
+void VideoFrameReceiverApplication::EnableCongestionFeedback(Ptr<DelayBasedBwe> bwe, Time interval) {
+    NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(), "Congestion feedback interval must be positive");
+    m_bwe = bwe;
+    m_feedbackInterval = interval;
+}
+
+// 目標ビットレートを送信元へ返す（RTCP REMB 相当の小さなパケット）
+void VideoFrameReceiverApplication::SendFeedback() {
+    if (m_hasFeedbackPeer) {
+        Ptr<Packet> packet = Create<Packet>(32);
+        CongestionFeedbackTag feedback(m_bwe->GetTargetRate(), m_bwe->GetReceivedRate(), m_bwe->GetModifiedTrend(),
+                                       m_bwe->GetCePackets());
+        packet->AddPacketTag(feedback);
+        m_socket->SendTo(packet, 0, m_feedbackPeer);
+    }
+    if (m_feedbackEvent.IsPending()) {
+        Simulator::Cancel(m_feedbackEvent);
+    }
+    m_feedbackEvent = Simulator::Schedule(m_feedbackInterval, &VideoFrameReceiverApplication::SendFeedback, this);
+}
+
 void VideoFrameReceiverApplication::SetPacketLogFile(std::string filename) {
     m_packetLogFile = filename;
-    m_packetLogStream.open(filename);
-    if (m_packetLogStream.is_open()) {
-        // ヘッダ行を書き込み
-        m_packetLogStream << "TxTime(sec),RxTime(sec),Latency(ms),FrameID,FrameType,PacketIndex,TotalPackets,FwdRef,BwdRef" << std::endl;
-        m_packetLogStream.flush();
+    // 専用の置き場のログは 1 フローだけなので FlowID 列を付けない
+    GetStatsStore()->OpenPacketLog(filename, false);
+}
+
+Ptr<FlowStatsStore> VideoFrameReceiverApplication::GetStatsStore() {
+    if (!m_statsStore) {
+        m_statsStore = Create<FlowStatsStore>();
+        m_flowId = m_statsStore->AddFlow();
+        // 作成前に記録したフレームがあれば、そのまま通常のヒープに置いておく
+        if (m_frameStats.empty()) {
+            m_frameStats = FrameStatsMap(FrameStatsMap::key_compare(),
+                                         FrameStatsMap::allocator_type(m_statsStore->GetFramePool()));
+        }
     }
+    return m_statsStore;
+}
+
+void VideoFrameReceiverApplication::SetStatsStore(Ptr<FlowStatsStore> store) {
+    NS_ABORT_MSG_IF(!m_frameStats.empty(), "SetStatsStore must be called before any packet is received");
+    // 空の map を新しいプールの map で置き換えてから古い置き場を手放す
+    m_frameStats = FrameStatsMap(FrameStatsMap::key_compare(), FrameStatsMap::allocator_type(store->GetFramePool()));
+    m_statsStore = store;
+    m_flowId = store->AddFlow();
+}
+
+uint32_t VideoFrameReceiverApplication::GetFlowId() const {
+    return m_flowId;
 }
 
 void VideoFrameReceiverApplication::LogPacket(uint32_t frameId, uint32_t frameType, uint32_t packetIndex,
-                                              uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef) {
-    if (m_packetLogStream.is_open()) {
-        const char* frameTypeStr[] = {"I", "P", "B"};
-        double latency = (rxTime - txTime) * 1000.0;  // ミリ秒に変換
-        m_packetLogStream << std::fixed << std::setprecision(6) << txTime << ","
-                          << std::fixed << std::setprecision(6) << rxTime << ","
-                          << std::fixed << std::setprecision(3) << latency << ","
-                          << frameId << ","
-                          << frameTypeStr[frameType] << ","
-                          << packetIndex << ","
-                          << totalPackets << ","
-                          << fwdRef << ","
-                          << bwdRef << std::endl;
-        m_packetLogStream.flush();
-    }
+                                              uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef,
+                                              double sendTime) {
+    GetStatsStore()->LogPacket(m_flowId, frameId, frameType, packetIndex, totalPackets, txTime, rxTime, fwdRef, bwdRef,
+                               sendTime);
 }
 
 void VideoFrameReceiverApplication::StartApplication() {
@@ -367,9 +744,17 @@ void VideoFrameReceiverApplication::StartApplication() {
         // ソケット受信バッファサイズを増加（デフォルト131072→1048576）
         m_socket->SetAttribute("RcvBufSize", UintegerValue(1048576));
 
+        // 輻輳制御では ECN の CE マークを読むため、受信パケットに IP の TOS を付けてもらう
+        if (m_bwe) {
+            m_socket->SetIpRecvTos(true);
+        }
+
         NS_LOG_INFO("Receiver bound to port " << m_port);
         m_socket->SetRecvCallback(MakeCallback(&VideoFrameReceiverApplication::HandleRead, this));
     }
+    if (m_bwe) {
+        m_feedbackEvent = Simulator::Schedule(m_feedbackInterval, &VideoFrameReceiverApplication::SendFeedback, this);
+    }
 }
 
 void VideoFrameReceiverApplication::StopApplication() {
@@ -377,9 +762,20 @@ void VideoFrameReceiverApplication::StopApplication() {
         m_socket->Close();
         m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
-    if (m_packetLogStream.is_open()) {
-        m_packetLogStream.close();
+    if (m_feedbackEvent.IsPending()) {
+        Simulator::Cancel(m_feedbackEvent);
+    }
+    if (m_statsStore) {
+        m_statsStore->FlushPacketLog();
+    }
+}
+
+// 停止されずに破棄された場合（StopTime がシミュレーション終了より後など）もバッファを書き出す
+void VideoFrameReceiverApplication::DoDispose() {
+    if (m_statsStore) {
+        m_statsStore->FlushPacketLog();
     }
+    Application::DoDispose();
 }
 
 void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
@@ -388,6 +784,7 @@ void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
     double rxTime = Simulator::Now().GetSeconds();
     uint32_t totalPacketsReceived = 0;
     static uint32_t firstPacketSize = 0;  // Record the first packet size
+    Ptr<FlowStatsStore> store = GetStatsStore();
 
     while ((packet = socket->RecvFrom(from))) {
         totalPacketsReceived++;
@@ -415,6 +812,7 @@ void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
                            << " (ignored for statistics)");
                 continue;
             }
+            m_statsValid = false;
 
             // フレーム情報の初期化
             if (m_frameStats.find(frameId) == m_frameStats.end()) {
@@ -430,16 +828,97 @@ void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
                 stat.packetReceptionRatio = 0.0;
                 stat.effectiveReceptionRatio = 0.0;
                 stat.transmissionStartTime = txStartTime;
+                stat.receivedMask.assign(totalPackets, false);
+                stat.duplicatePackets = 0;
+                stat.layerReceived.assign(std::max(1u, tag.GetNumLayers()), 0);
+                stat.layerTotal.assign(std::max(1u, tag.GetNumLayers()), 0);
+                stat.decodableLayer = -1;
                 stat.firstPacketArrivalTime = rxTime;
                 stat.lastPacketArrivalTime = rxTime;
                 stat.latency = 0.0;
                 stat.withinDeadline = false;
+                stat.captureTime = tag.GetCaptureTime();
+                stat.sliceReceived.assign(std::max(1u, tag.GetNumSlices()), 0);
+                stat.sliceTotal.assign(std::max(1u, tag.GetNumSlices()), 0);
+                stat.decodedSlices = 0;
+                stat.decodeReadyTime = -1.0;
+                stat.glassToGlass = -1.0;
+                stat.displayTime = -1.0;
+                stat.displayLatency = -1.0;
+                stat.reorderOccupancy = 0;
+                stat.ownDamage = -1.0;
+                stat.damage = 0.0;
+                stat.psnr = 0.0;
+                stat.ssim = 0.0;
                 m_frameStats[frameId] = stat;
+                if (frameType < 3) {
+                    m_typicalPackets[frameType] = totalPackets;
+                }
+            }
+
+            // 重複パケット（MLO 複製送信）は最初の到着のみ採用
+            FrameStatistics& frameStat = m_frameStats[frameId];
+            if (packetIndex < frameStat.receivedMask.size()) {
+                if (frameStat.receivedMask[packetIndex]) {
+                    frameStat.duplicatePackets++;
+                    store->RecordDuplicate(m_flowId);
+                    NS_LOG_INFO("Duplicate packet " << packetIndex << " of frame " << frameId << " ignored");
+                    continue;
+                }
+                frameStat.receivedMask[packetIndex] = true;
+                frameStat.ownDamage = -1.0;
             }
 
             // 最後のパケット到着時刻を更新
-            m_frameStats[frameId].lastPacketArrivalTime = rxTime;
-            m_frameStats[frameId].receivedPackets++;
+            frameStat.lastPacketArrivalTime = rxTime;
+            frameStat.receivedPackets++;
+
+            m_rxTrace(packet, from);
+
+            // 遅延勾配による帯域推定（グループ評価ごとにトレース、過負荷になったら即座にフィードバック）
+            if (m_bwe) {
+                m_feedbackPeer = from;
+                m_hasFeedbackPeer = true;
+                BandwidthUsage before = m_bwe->GetUsage();
+                // IP ヘッダの ECN が CE (11) なら経路上の AQM が輻輳を通知している
+                SocketIpTosTag tosTag;
+                bool ceMarked = packet->PeekPacketTag(tosTag) && (tosTag.GetTos() & 0x03) == 0x03;
+                m_bwe->OnPacket(tag.GetSendTime(), rxTime, packet->GetSize(), ceMarked);
+                if (m_bwe->GetCompletedGroups() != m_bweGroups) {
+                    m_bweGroups = m_bwe->GetCompletedGroups();
+                    m_delayGradientTrace(m_bwe->GetModifiedTrend(), m_bwe->GetThreshold(), m_bwe->GetUsage(),
+                                         m_bwe->GetTargetRate(), m_bwe->GetCeAlpha());
+                    if (before != USAGE_OVERUSING && m_bwe->GetUsage() == USAGE_OVERUSING) {
+                        SendFeedback();
+                    }
+                }
+            }
+
+            store->RecordPacket(m_flowId, packet->GetSize(), rxTime);
+            if (m_liveMetrics) {
+                m_liveLatencies.push_back((rxTime - txStartTime) * 1000.0);
+            }
+
+            // レイヤ単位の受信状況
+            uint32_t layerId = tag.GetLayerId();
+            if (layerId < frameStat.layerReceived.size()) {
+                frameStat.layerReceived[layerId]++;
+                frameStat.layerTotal[layerId] = tag.GetLayerPackets();
+            }
+
+            // スライス単位の受信状況（スライスがそろったら復号を進める）
+            uint32_t sliceId = tag.GetSliceId();
+            if (sliceId < frameStat.sliceReceived.size()) {
+                frameStat.sliceReceived[sliceId]++;
+                frameStat.sliceTotal[sliceId] = tag.GetSlicePackets();
+                uint64_t decodeIndex = GetDecodeIndex(frameId);
+                if (frameStat.sliceReceived[sliceId] >= frameStat.sliceTotal[sliceId] && decodeIndex >= m_decodeNext) {
+                    if (m_pendingDecode.emplace(decodeIndex, frameId).second && frameType == 0) {
+                        m_pendingIntra++;
+                    }
+                    DecodePending(rxTime);
+                }
+            }
 
             const char* frameTypeStr[] = {"I", "P", "B"};
             NS_LOG_INFO("Received packet from " << frameTypeStr[frameType] << " frame " << frameId
@@ -448,7 +927,8 @@ void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
                        << ", fwdRef=" << fwdRefFrameId << ", bwdRef=" << bwdRefFrameId << ")");
 
             // パケットログに出力（送信時間と受信時間を記録）
-            LogPacket(frameId, frameType, packetIndex, totalPackets, txStartTime, rxTime, fwdRefFrameId, bwdRefFrameId);
+            LogPacket(frameId, frameType, packetIndex, totalPackets, txStartTime, rxTime, fwdRefFrameId, bwdRefFrameId,
+                      tag.GetSendTime());
 
             // ロスパケット検出
             if (frameId == 0 && packetIndex < 3) {
@@ -463,8 +943,133 @@ void VideoFrameReceiverApplication::HandleRead(Ptr<Socket> socket) {
     }
 }
 
+// 参照が受信開始より前のフレームなら制約なし、受信期間内でまだ復号されていなければ待つ
+bool VideoFrameReceiverApplication::GetReferenceReadyTime(const FrameStatistics& stat, double& readyTime) const {
+    readyTime = 0.0;
+    for (int32_t refId : {stat.forwardRefFrameId, stat.backwardRefFrameId}) {
+        if (refId < 0) {
+            continue;
+        }
+        auto it = m_frameStats.find(static_cast<uint32_t>(refId));
+        // イントラリフレッシュの復号器は欠けた参照を隠蔽して進むため、復号待ちの参照だけを待つ
+        if (m_gop && m_gop->IsIntraRefresh()) {
+            bool pending = m_pendingDecode.count(GetDecodeIndex(static_cast<uint32_t>(refId))) > 0;
+            if (it == m_frameStats.end() || (it->second.decodeReadyTime < 0.0 && !pending)) {
+                continue;
+            }
+        }
+        if (it == m_frameStats.end()) {
+            if (static_cast<uint32_t>(refId) < m_frameStats.begin()->first) {
+                continue;
+            }
+            return false;
+        }
+        if (it->second.decodeReadyTime < 0.0) {
+            return false;
+        }
+        readyTime = std::max(readyTime, it->second.decodeReadyTime);
+    }
+    return true;
+}
+
+// スライスは先頭から順にしか復号できず、前のスライスが欠けていれば以降も待つ
+bool VideoFrameReceiverApplication::DecodeSlices(FrameStatistics& stat, double now) {
+    uint32_t numSlices = stat.sliceTotal.size();
+    if (stat.decodedSlices == 0) {
+        double refReady;
+        if (!GetReferenceReadyTime(stat, refReady)) {
+            return false;
+        }
+        now = std::max(now, refReady);
+    }
+    while (stat.decodedSlices < numSlices) {
+        uint32_t s = stat.decodedSlices;
+        if (stat.sliceReceived[s] == 0 || stat.sliceReceived[s] < stat.sliceTotal[s]) {
+            return false;
+        }
+        double start = std::max(now, m_decoderFree);
+        m_decoderFree = start + m_decodeTime.GetSeconds() / numSlices;
+        stat.decodedSlices++;
+    }
+    stat.decodeReadyTime = m_decoderFree;
+    return true;
+}
+
+// 復号器はデコード順に 1 フレームずつ進むので、復号待ちの先頭だけを調べる
+// 表示順送信では B フレームが後方参照の P より先に届くが、デコード順では P の後ろに並ぶので P の復号を待つ
+// 先頭が進めないまま後ろに I フレームが届いていれば、先頭を捨てて I から再開する（参照の失われたフレームで止まらない）
+// それ以外で進めないフレームも、キャプチャから 1 秒で諦める。復号器が通り過ぎたフレームは後から届いても復号しない
+void VideoFrameReceiverApplication::DecodePending(double now) {
+    while (!m_pendingDecode.empty()) {
+        auto head = m_pendingDecode.begin();
+        FrameStatistics& stat = m_frameStats[head->second];
+        bool intra = stat.frameType == 0;
+        bool decoded = false;
+        if (now - stat.captureTime <= 1.0) {
+            decoded = DecodeSlices(stat, now);
+            if (!decoded && m_pendingIntra <= (intra ? 1u : 0u)) {
+                return;
+            }
+        }
+        if (intra) {
+            m_pendingIntra--;
+        }
+        m_decodeNext = head->first + 1;
+        m_pendingDecode.erase(head);
+    }
+}
+
+// 復号器が処理する順序のキー
+uint64_t VideoFrameReceiverApplication::GetDecodeIndex(uint32_t frameId) const {
+    return m_gop ? m_gop->GetDecodeIndex(frameId) : frameId;
+}
+
+// 表示は表示順（フレームID順）で、復号を終えていて直前の表示フレームより後になる時刻
+// 復号できなかったフレームは飛ばす（前のフレームを表示し続ける）
+// 並べ替えバッファには復号を終えて表示を待つフレームが入る
+void VideoFrameReceiverApplication::ResolveDisplay() {
+    double lastDisplay = 0.0;
+    std::vector<std::pair<double, int32_t>> events;  // (時刻, +1=復号完了 / -1=表示)
+    for (auto& stat : m_frameStats) {
+        if (stat.second.decodeReadyTime < 0.0) {
+            stat.second.displayTime = -1.0;
+            stat.second.displayLatency = -1.0;
+            continue;
+        }
+        stat.second.displayTime = std::max(stat.second.decodeReadyTime, lastDisplay);
+        stat.second.displayLatency = (stat.second.displayTime - stat.second.captureTime) * 1000.0;
+        lastDisplay = stat.second.displayTime;
+        events.emplace_back(stat.second.decodeReadyTime, 1);
+        events.emplace_back(stat.second.displayTime, -1);
+    }
+
+    // 同時刻では表示を先に処理し、復号完了と同時に表示されるフレームは占有 1 とする
+    std::sort(events.begin(), events.end());
+    std::vector<int32_t> occupancy(events.size() + 1, 0);
+    for (size_t k = 0; k < events.size(); k++) {
+        occupancy[k + 1] = occupancy[k] + events[k].second;
+    }
+    for (auto& stat : m_frameStats) {
+        if (stat.second.decodeReadyTime < 0.0) {
+            stat.second.reorderOccupancy = 0;
+            continue;
+        }
+        auto decoded = std::upper_bound(events.begin(), events.end(),
+                                        std::make_pair(stat.second.decodeReadyTime, 1));
+        stat.second.reorderOccupancy = std::max(1, occupancy[decoded - events.begin()]);
+    }
+}
+
+// 前回の集計以降に受信があった場合だけ集計し直す（複数の出力で同じ結果を使い回す）
+void VideoFrameReceiverApplication::UpdateStatistics() {
+    if (!m_statsValid) {
+        CalculateStatistics();
+        m_statsValid = true;
+    }
+}
+
 void VideoFrameReceiverApplication::CalculateStatistics() {
-    const double DEADLINE_MS = 33.3;  // 30fps = 33.3ms
+    double deadlineMs = m_deadline.GetSeconds() * 1000.0;
 
     // 第1パス: パケット受信率と遅延を計算
     for (auto& stat : m_frameStats) {
@@ -474,22 +1079,44 @@ void VideoFrameReceiverApplication::CalculateStatistics() {
         stat.second.latency = (stat.second.lastPacketArrivalTime - stat.second.transmissionStartTime) * 1000.0;
 
         // 許容遅延判定
-        stat.second.withinDeadline = (stat.second.latency <= DEADLINE_MS);
+        stat.second.withinDeadline = (stat.second.latency <= deadlineMs);
+
+        // キャプチャから全スライスの復号完了まで
+        stat.second.glassToGlass = stat.second.decodeReadyTime >= 0.0
+                                       ? (stat.second.decodeReadyTime - stat.second.captureTime) * 1000.0
+                                       : -1.0;
     }
+    ResolveDisplay();
 
     // 第2パス: 参照フレームの状態を確認してロス連鎖を判定
+    // GOP テーブルがある場合は、1 パケットも届かなかった参照フレーム（受信期間内）もロスとみなす
+    auto isRefMissing = [this](int32_t refId) {
+        return m_gop && refId > static_cast<int32_t>(m_frameStats.begin()->first) &&
+               refId < static_cast<int32_t>(m_frameStats.rbegin()->first);
+    };
+    // イントラリフレッシュでは、直近 1 周期内に不完全・欠落フレームがあれば未回復（前方参照ロス）とする
+    int64_t lastLossFrame = -1;
+    uint32_t prevFrameId = m_frameStats.empty() ? 0 : m_frameStats.begin()->first;
     for (auto& stat : m_frameStats) {
         stat.second.forwardRefLost = false;
         stat.second.backwardRefLost = false;
 
-        // 前方参照フレームのチェック
+        // 送信側と同じテーブルから参照関係を取得
+        if (m_gop) {
+            stat.second.forwardRefFrameId = m_gop->GetForwardRef(stat.first);
+            stat.second.backwardRefFrameId = m_gop->GetBackwardRef(stat.first);
+        }
+
+        // 前方参照フレームのチェック（SVC では拡張レイヤのロスは参照ロスとしない）
         if (stat.second.forwardRefFrameId != -1) {
             auto refIt = m_frameStats.find(stat.second.forwardRefFrameId);
             if (refIt != m_frameStats.end()) {
-                // 参照フレームが完全受信されていない場合
-                if (refIt->second.receivedPackets < refIt->second.totalPackets) {
+                // 参照フレーム（のベースレイヤ）が完全受信されていない場合
+                if (!IsLayerComplete(refIt->second, 0)) {
                     stat.second.forwardRefLost = true;
                 }
+            } else if (isRefMissing(stat.second.forwardRefFrameId)) {
+                stat.second.forwardRefLost = true;
             }
         }
 
@@ -497,13 +1124,27 @@ void VideoFrameReceiverApplication::CalculateStatistics() {
         if (stat.second.backwardRefFrameId != -1) {
             auto refIt = m_frameStats.find(stat.second.backwardRefFrameId);
             if (refIt != m_frameStats.end()) {
-                // 参照フレームが完全受信されていない場合
-                if (refIt->second.receivedPackets < refIt->second.totalPackets) {
+                // 参照フレーム（のベースレイヤ）が完全受信されていない場合
+                if (!IsLayerComplete(refIt->second, 0)) {
                     stat.second.backwardRefLost = true;
                 }
+            } else if (isRefMissing(stat.second.backwardRefFrameId)) {
+                stat.second.backwardRefLost = true;
             }
         }
 
+        if (m_gop && m_gop->IsIntraRefresh()) {
+            if (stat.first > prevFrameId + 1) {
+                lastLossFrame = stat.first - 1;
+            }
+            stat.second.forwardRefLost =
+                lastLossFrame >= 0 && stat.first - lastLossFrame < m_gop->GetGopSize();
+            if (!IsLayerComplete(stat.second, 0)) {
+                lastLossFrame = stat.first;
+            }
+            prevFrameId = stat.first;
+        }
+
         // 有効受信率を計算（どちらかの参照がロスしていたら0）
         if (stat.second.forwardRefLost || stat.second.backwardRefLost) {
             stat.second.effectiveReceptionRatio = 0.0;
@@ -511,10 +1152,160 @@ void VideoFrameReceiverApplication::CalculateStatistics() {
             stat.second.effectiveReceptionRatio = stat.second.packetReceptionRatio;
         }
     }
+
+    // 第3パス: 復号可能レイヤと画質推定（フレームID順に参照チェーンをたどって確定）
+    // イントラリフレッシュは直近 1 周期の劣化フレームだけを持ち回して 1 フレームずつ更新する
+    std::map<uint32_t, double> resolved;
+    std::map<uint32_t, int32_t> resolvedLayers;
+    std::deque<std::pair<uint32_t, double>> refreshDamaged;
+    bool intraRefresh = m_gop && m_gop->IsIntraRefresh();
+    int64_t lastFrameId = -1;
+    for (auto& stat : m_frameStats) {
+        stat.second.decodableLayer = ResolveDecodableLayer(stat.first, resolvedLayers, 0);
+        if (intraRefresh) {
+            // 受信期間内で 1 パケットも届かなかったフレームは全面劣化（1 周期より前の分は影響しない）
+            if (lastFrameId >= 0) {
+                int64_t from = std::max<int64_t>(lastFrameId + 1, static_cast<int64_t>(stat.first) - m_gop->GetGopSize());
+                for (int64_t missing = from; missing < stat.first; missing++) {
+                    AdvanceRefreshDamage(static_cast<uint32_t>(missing), 1.0, refreshDamaged);
+                }
+            }
+            stat.second.damage = AdvanceRefreshDamage(stat.first, GetOwnDamage(stat.first), refreshDamaged);
+            lastFrameId = stat.first;
+        } else {
+            stat.second.damage = ResolveFrameDamage(stat.first, resolved, 0);
+        }
+        FrameQuality quality = QualityEstimator::Estimate(stat.second.frameType, stat.second.damage);
+        // ベースレイヤが復号できれば、欠けた拡張レイヤの分だけ画質を下げる
+        uint32_t numLayers = stat.second.layerTotal.size();
+        if (numLayers > 1 && stat.second.decodableLayer >= 0) {
+            quality = QualityEstimator::ApplyLayerLoss(quality, numLayers - 1 - stat.second.decodableLayer);
+        }
+        stat.second.psnr = quality.psnr;
+        stat.second.ssim = quality.ssim;
+    }
+}
+
+// レイヤのパケットをすべて受信したか（1 パケットも届かなければレイヤサイズ不明のため未完了）
+bool VideoFrameReceiverApplication::IsLayerComplete(const FrameStatistics& stat, uint32_t layerId) const {
+    if (layerId >= stat.layerReceived.size()) {
+        return false;
+    }
+    return stat.layerReceived[layerId] > 0 && stat.layerReceived[layerId] >= stat.layerTotal[layerId];
+}
+
+// 復号可能な最上位レイヤ: 自フレームで連続して完全受信したレイヤと、参照フレームの復号可能レイヤの最小値
+int32_t VideoFrameReceiverApplication::ResolveDecodableLayer(uint32_t frameId, std::map<uint32_t, int32_t>& resolved,
+                                                             uint32_t depth) {
+    auto resolvedIt = resolved.find(frameId);
+    if (resolvedIt != resolved.end()) {
+        return resolvedIt->second;
+    }
+
+    auto it = m_frameStats.find(frameId);
+    if (it == m_frameStats.end()) {
+        // 受信期間内の欠落フレームは復号不可、期間外は制約なし
+        bool inRange = frameId > m_frameStats.begin()->first && frameId < m_frameStats.rbegin()->first;
+        return inRange ? -1 : INT32_MAX;
+    }
+
+    const FrameStatistics& stat = it->second;
+    int32_t layer = -1;
+    while (IsLayerComplete(stat, layer + 1)) {
+        layer++;
+    }
+    // イントラリフレッシュでは参照のロスで復号を止めず、劣化として扱う（ResolveFrameDamage）
+    if (depth < 1024 && !(m_gop && m_gop->IsIntraRefresh())) {
+        if (stat.forwardRefFrameId != -1) {
+            layer = std::min(layer, ResolveDecodableLayer(stat.forwardRefFrameId, resolved, depth + 1));
+        }
+        if (stat.backwardRefFrameId != -1) {
+            layer = std::min(layer, ResolveDecodableLayer(stat.backwardRefFrameId, resolved, depth + 1));
+        }
+    }
+
+    resolved[frameId] = layer;
+    return layer;
+}
+
+// 自フレームのロスによる劣化率
+// 受信期間内で 1 パケットも届かなかったフレームは全面劣化、期間外（受信開始前など）は劣化なし扱い
+double VideoFrameReceiverApplication::GetOwnDamage(uint32_t frameId) {
+    auto it = m_frameStats.find(frameId);
+    if (it == m_frameStats.end()) {
+        bool inRange = frameId > m_frameStats.begin()->first && frameId < m_frameStats.rbegin()->first;
+        return inRange ? 1.0 : 0.0;
+    }
+
+    FrameStatistics& stat = it->second;
+    if (stat.ownDamage >= 0.0) {
+        return stat.ownDamage;
+    }
+    if (stat.layerTotal.size() > 1) {
+        // SVC: 面積の劣化はベースレイヤのロスのみで決まる（拡張レイヤは ApplyLayerLoss で反映）
+        stat.ownDamage = stat.layerReceived[0] == 0
+                             ? 1.0
+                             : QualityEstimator::LossDamage(stat.receivedMask, stat.layerTotal[0]);
+    } else {
+        stat.ownDamage = QualityEstimator::LossDamage(stat.receivedMask);
+    }
+    return stat.ownDamage;
+}
+
+// フレームの劣化率を参照フレームまでたどって求める（結果は resolved にメモ化）
+double VideoFrameReceiverApplication::ResolveFrameDamage(uint32_t frameId, std::map<uint32_t, double>& resolved,
+                                                         uint32_t depth) {
+    auto resolvedIt = resolved.find(frameId);
+    if (resolvedIt != resolved.end()) {
+        return resolvedIt->second;
+    }
+
+    auto it = m_frameStats.find(frameId);
+    if (it == m_frameStats.end()) {
+        return GetOwnDamage(frameId);
+    }
+
+    const FrameStatistics& stat = it->second;
+    double ownDamage = GetOwnDamage(frameId);
+    double fwdDamage = -1.0;
+    double bwdDamage = -1.0;
+    // 参照は非巡回だが、壊れたタグに備えて深さを制限
+    if (depth < 1024) {
+        if (stat.forwardRefFrameId != -1) {
+            fwdDamage = ResolveFrameDamage(stat.forwardRefFrameId, resolved, depth + 1);
+        }
+        if (stat.backwardRefFrameId != -1) {
+            bwdDamage = ResolveFrameDamage(stat.backwardRefFrameId, resolved, depth + 1);
+        }
+    }
+
+    double damage = QualityEstimator::TotalDamage(stat.frameType, ownDamage, fwdDamage, bwdDamage);
+    resolved[frameId] = damage;
+    return damage;
+}
+
+// イントラリフレッシュ: 参照をたどらず、直近 1 周期の各フレームの劣化のうちイントラ列でまだ書き換えられていない面積を合成
+// 劣化のないフレームは合成に寄与しないので、damaged には劣化のあったフレームだけを残す
+// 復号開始（フレーム 0）から 1 周期の間は、まだ一度もリフレッシュされていない領域も劣化とみなす
+double VideoFrameReceiverApplication::AdvanceRefreshDamage(uint32_t frameId, double ownDamage,
+                                                           std::deque<std::pair<uint32_t, double>>& damaged) {
+    uint32_t period = m_gop->GetGopSize();
+    while (!damaged.empty() && frameId - damaged.front().first >= period) {
+        damaged.pop_front();
+    }
+    double clean = 1.0 - ownDamage;
+    for (const auto& entry : damaged) {
+        clean *= 1.0 - QualityEstimator::RefreshedDamage(entry.second, frameId - entry.first, period);
+    }
+    clean *= 1.0 - QualityEstimator::RefreshedDamage(1.0, frameId + 1, period);
+    if (ownDamage > 0.0) {
+        damaged.emplace_back(frameId, ownDamage);
+    }
+    return 1.0 - clean;
 }
 
 void VideoFrameReceiverApplication::SaveStatisticsToFile(std::string filename) {
-    CalculateStatistics();
+    UpdateStatistics();
 
     std::ofstream outfile(filename);
     if (!outfile.is_open()) {
@@ -524,7 +1315,10 @@ void VideoFrameReceiverApplication::SaveStatisticsToFile(std::string filename) {
 
     // CSV ヘッダー行
     outfile << "FrameID,Type,PacketRatio(%),FwdRef,BwdRef,RefStatus,EffectiveRatio(%),"
-            << "Latency(ms),WithinDeadline,FirstArrival(sec),LastArrival(sec)" << std::endl;
+            << "Latency(ms),WithinDeadline,FirstArrival(sec),LastArrival(sec),"
+            << "Damage(%),PSNR(dB),SSIM,Layers,DecodableLayer,LayerRatio(%),"
+            << "Capture(sec),DecodeReady(sec),GlassToGlass(ms),Display(sec),DisplayLatency(ms),ReorderBuffer"
+            << std::endl;
 
     // データ行
     for (auto& stat : m_frameStats) {
@@ -556,9 +1350,297 @@ void VideoFrameReceiverApplication::SaveStatisticsToFile(std::string filename) {
                 << std::fixed << std::setprecision(2) << stat.second.latency << ","
                 << deadlineStatus << ","
                 << std::fixed << std::setprecision(4) << stat.second.firstPacketArrivalTime << ","
-                << std::fixed << std::setprecision(4) << stat.second.lastPacketArrivalTime << std::endl;
+                << std::fixed << std::setprecision(4) << stat.second.lastPacketArrivalTime << ","
+                << std::fixed << std::setprecision(1) << stat.second.damage * 100.0 << ","
+                << std::fixed << std::setprecision(2) << stat.second.psnr << ","
+                << std::fixed << std::setprecision(4) << stat.second.ssim << ","
+                << stat.second.layerTotal.size() << ","
+                << stat.second.decodableLayer << ",";
+        // レイヤごとの受信率を "/" 区切りで出力（サイズ不明のレイヤは 0）
+        for (size_t l = 0; l < stat.second.layerTotal.size(); l++) {
+            double ratio = stat.second.layerTotal[l] > 0
+                               ? stat.second.layerReceived[l] * 100.0 / stat.second.layerTotal[l]
+                               : 0.0;
+            outfile << (l > 0 ? "/" : "") << std::fixed << std::setprecision(1) << ratio;
+        }
+        outfile << "," << std::fixed << std::setprecision(4) << stat.second.captureTime << ","
+                << stat.second.decodeReadyTime << ","
+                << std::fixed << std::setprecision(2) << stat.second.glassToGlass << ","
+                << std::fixed << std::setprecision(4) << stat.second.displayTime << ","
+                << std::fixed << std::setprecision(2) << stat.second.displayLatency << ","
+                << stat.second.reorderOccupancy;
+        outfile << std::endl;
     }
 
     outfile.close();
     NS_LOG_INFO("Statistics saved to: " << filename);
 }
+
+// GOP 単位の推定画質を出力（I フレームで GOP を区切る。欠落フレームはフリーズとして計上）
+void VideoFrameReceiverApplication::SaveGopQualityToFile(std::string filename) {
+    UpdateStatistics();
+
+    std::ofstream outfile(filename);
+    if (!outfile.is_open()) {
+        NS_LOG_ERROR("Failed to open file: " << filename);
+        return;
+    }
+
+    outfile << "GOP,StartFrame,Frames,MissingFrames,DamagedFrames,MeanPSNR(dB),MinPSNR(dB),"
+            << "MeanSSIM,MinSSIM" << std::endl;
+
+    uint32_t gopIndex = 0;
+    uint32_t startFrame = 0;
+    uint32_t frames = 0;
+    uint32_t missingFrames = 0;
+    uint32_t damagedFrames = 0;
+    double psnrSum = 0.0;
+    double ssimSum = 0.0;
+    double minPsnr = 0.0;
+    double minSsim = 0.0;
+    bool first = true;
+    uint32_t prevFrameId = 0;
+
+    auto addQuality = [&](double psnr, double ssim) {
+        if (frames + missingFrames == 0 || psnr < minPsnr) {
+            minPsnr = psnr;
+        }
+        if (frames + missingFrames == 0 || ssim < minSsim) {
+            minSsim = ssim;
+        }
+        psnrSum += psnr;
+        ssimSum += ssim;
+    };
+    auto writeGop = [&]() {
+        uint32_t count = frames + missingFrames;
+        if (count == 0) {
+            return;
+        }
+        outfile << gopIndex << ","
+                << startFrame << ","
+                << frames << ","
+                << missingFrames << ","
+                << damagedFrames << ","
+                << std::fixed << std::setprecision(2) << psnrSum / count << ","
+                << minPsnr << ","
+                << std::fixed << std::setprecision(4) << ssimSum / count << ","
+                << minSsim << std::endl;
+        gopIndex++;
+    };
+
+    FrameQuality frozen = QualityEstimator::FrozenQuality();
+    for (auto& stat : m_frameStats) {
+        // 直前の受信フレームとの間の欠落フレームは現在の GOP に属する
+        if (!first) {
+            for (uint32_t id = prevFrameId + 1; id < stat.first; id++) {
+                addQuality(frozen.psnr, frozen.ssim);
+                missingFrames++;
+            }
+        }
+        // イントラリフレッシュではリフレッシュ周期ごとに集計する
+        bool gopStart = (m_gop && m_gop->IsIntraRefresh()) ? m_gop->GetRefreshPosition(stat.first) == 0
+                                                           : stat.second.frameType == 0;
+        if (gopStart || first) {
+            writeGop();
+            startFrame = stat.first;
+            frames = 0;
+            missingFrames = 0;
+            damagedFrames = 0;
+            psnrSum = 0.0;
+            ssimSum = 0.0;
+        }
+        addQuality(stat.second.psnr, stat.second.ssim);
+        frames++;
+        if (stat.second.damage > 0.0) {
+            damagedFrames++;
+        }
+        prevFrameId = stat.first;
+        first = false;
+    }
+    writeGop();
+
+    outfile.close();
+    NS_LOG_INFO("GOP quality saved to: " << filename);
+}
+
+// フレームタイプ別の glass-to-glass 遅延と、その内訳（符号化待ち・ネットワーク）
+// 符号化待ちはキャプチャから最初のスライスの送信開始まで、ネットワークは送信開始から最後のパケット受信まで
+// 表示遅延は表示順の並べ替え待ちを含めたキャプチャから表示まで
+void VideoFrameReceiverApplication::SaveGlassToGlassToFile(std::string filename) {
+    UpdateStatistics();
+
+    std::ofstream outfile(filename);
+    if (!outfile.is_open()) {
+        NS_LOG_ERROR("Failed to open file: " << filename);
+        return;
+    }
+
+    outfile << "Type,Frames,DecodedFrames,MeanEncode(ms),MeanNetwork(ms),MeanG2G(ms),P50G2G(ms),"
+            << "P95G2G(ms),P99G2G(ms),MeanDisplay(ms),P99Display(ms),MaxReorderBuffer" << std::endl;
+
+    const char* typeStr[] = {"I", "P", "B", "All"};
+    for (uint32_t scope = 0; scope < 4; scope++) {
+        uint32_t frames = 0;
+        double encodeSum = 0.0;
+        double networkSum = 0.0;
+        std::vector<double> g2g;
+        std::vector<double> display;
+        uint32_t maxReorder = 0;
+        for (auto& stat : m_frameStats) {
+            if (scope < 3 && stat.second.frameType != scope) {
+                continue;
+            }
+            frames++;
+            encodeSum += (stat.second.transmissionStartTime - stat.second.captureTime) * 1000.0;
+            networkSum += stat.second.latency;
+            if (stat.second.glassToGlass >= 0.0) {
+                g2g.push_back(stat.second.glassToGlass);
+            }
+            if (stat.second.displayLatency >= 0.0) {
+                display.push_back(stat.second.displayLatency);
+            }
+            maxReorder = std::max(maxReorder, stat.second.reorderOccupancy);
+        }
+        if (frames == 0) {
+            continue;
+        }
+        double g2gSum = 0.0;
+        for (double latency : g2g) {
+            g2gSum += latency;
+        }
+        double displaySum = 0.0;
+        for (double latency : display) {
+            displaySum += latency;
+        }
+        std::sort(g2g.begin(), g2g.end());
+        std::sort(display.begin(), display.end());
+        auto percentileOf = [](const std::vector<double>& values, double q) {
+            return values.empty() ? 0.0 : values[static_cast<size_t>(q * (values.size() - 1))];
+        };
+        outfile << typeStr[scope] << ","
+                << frames << ","
+                << g2g.size() << ","
+                << std::fixed << std::setprecision(2) << encodeSum / frames << ","
+                << networkSum / frames << ","
+                << (g2g.empty() ? 0.0 : g2gSum / g2g.size()) << ","
+                << percentileOf(g2g, 0.50) << ","
+                << percentileOf(g2g, 0.95) << ","
+                << percentileOf(g2g, 0.99) << ","
+                << (display.empty() ? 0.0 : displaySum / display.size()) << ","
+                << percentileOf(display, 0.99) << ","
+                << maxReorder << std::endl;
+    }
+
+    outfile.close();
+    NS_LOG_INFO("Glass-to-glass latency saved to: " << filename);
+}
+
+VideoFlowSummary VideoFrameReceiverApplication::GetFlowSummary() {
+    UpdateStatistics();
+
+    VideoFlowSummary summary;
+    summary.frames = m_frameStats.size();
+    summary.completeFrames = 0;
+    summary.onTimeFrames = 0;
+    summary.meanLatency = 0.0;
+    summary.p95Latency = 0.0;
+    summary.p99Latency = 0.0;
+    summary.meanPsnr = 0.0;
+    summary.meanSsim = 0.0;
+
+    std::vector<double> latencies;
+    latencies.reserve(m_frameStats.size());
+    for (auto& stat : m_frameStats) {
+        if (stat.second.receivedPackets >= stat.second.totalPackets) {
+            summary.completeFrames++;
+        }
+        if (stat.second.withinDeadline) {
+            summary.onTimeFrames++;
+        }
+        latencies.push_back(stat.second.latency);
+        summary.meanLatency += stat.second.latency;
+        summary.meanPsnr += stat.second.psnr;
+        summary.meanSsim += stat.second.ssim;
+    }
+
+    if (!latencies.empty()) {
+        summary.meanLatency /= latencies.size();
+        summary.meanPsnr /= latencies.size();
+        summary.meanSsim /= latencies.size();
+        std::sort(latencies.begin(), latencies.end());
+        summary.p95Latency = latencies[static_cast<size_t>(0.95 * (latencies.size() - 1))];
+        summary.p99Latency = latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))];
+    }
+    return summary;
+}
+
+uint32_t VideoFrameReceiverApplication::EstimateFramePackets(uint32_t frameId) const {
+    if (m_gop) {
+        uint32_t packets = m_typicalPackets[m_gop->GetFrameType(frameId)];
+        if (packets > 0) {
+            return packets;
+        }
+    }
+    uint32_t packets = *std::max_element(m_typicalPackets, m_typicalPackets + 3);
+    return std::max(packets, 1u);
+}
+
+VideoLiveSample VideoFrameReceiverApplication::TakeLiveSample(Time finalizeAge) {
+    VideoLiveSample sample;
+    GetStatsStore()->TakeLiveCounters(m_flowId, sample.rxPackets, sample.rxBytes);
+    sample.finalizedFrames = 0;
+    sample.expectedPackets = 0;
+    sample.lostPackets = 0;
+    sample.p50Latency = 0.0;
+    sample.p95Latency = 0.0;
+    sample.p99Latency = 0.0;
+
+    // 区間内のパーセンタイル（nth_element で部分的に並べるだけにする）
+    if (!m_liveLatencies.empty()) {
+        auto percentile = [this](double q) {
+            size_t k = static_cast<size_t>(q * (m_liveLatencies.size() - 1));
+            std::nth_element(m_liveLatencies.begin(), m_liveLatencies.begin() + k, m_liveLatencies.end());
+            return m_liveLatencies[k];
+        };
+        sample.p50Latency = percentile(0.50);
+        sample.p95Latency = percentile(0.95);
+        sample.p99Latency = percentile(0.99);
+    }
+
+    // 送信開始から finalizeAge 経過したフレームはこれ以上パケットが届かないとみなしてロスを確定
+    // フレーム周期が分かっていれば、その時刻までに送られたはずのフレームID を順に確定し、
+    // 1 パケットも届かなかったフレームも全損として数える（全損のときほどロス率が低く見えないように）
+    double finalizeBefore = (Simulator::Now() - finalizeAge).GetSeconds();
+    uint32_t horizon = m_liveCursor;  // このID未満を確定する
+    if (m_frameInterval.IsStrictlyPositive()) {
+        double elapsed = finalizeBefore - m_firstFrameTime.GetSeconds();
+        if (elapsed >= 0.0) {
+            horizon = std::max(horizon, static_cast<uint32_t>(elapsed / m_frameInterval.GetSeconds()) + 1);
+        }
+    } else {
+        // 周期が不明なら、確定時刻を過ぎた受信済みフレームの最大IDまで
+        for (auto it = m_frameStats.lower_bound(m_liveCursor); it != m_frameStats.end(); it++) {
+            if (it->second.transmissionStartTime <= finalizeBefore) {
+                horizon = it->first + 1;
+            }
+        }
+    }
+    auto it = m_frameStats.lower_bound(m_liveCursor);
+    for (uint32_t frameId = m_liveCursor; frameId < horizon; frameId++) {
+        sample.finalizedFrames++;
+        if (it != m_frameStats.end() && it->first == frameId) {
+            sample.expectedPackets += it->second.totalPackets;
+            sample.lostPackets += it->second.totalPackets -
+                                  std::min(it->second.receivedPackets, it->second.totalPackets);
+            it++;
+        } else {
+            uint32_t packets = EstimateFramePackets(frameId);
+            sample.expectedPackets += packets;
+            sample.lostPackets += packets;
+        }
+    }
+    m_liveCursor = horizon;
+
+    m_liveLatencies.clear();
+    return sample;
+}
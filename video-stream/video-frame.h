@@ -11,13 +11,32 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "annexb-source.h"
+#include "quality-estimator.h"
+#include "gop-structure.h"
+#include "congestion-controller.h"
+#include "encoder-timing.h"
+#include "flow-stats-store.h"
+#include <deque>
 #include <map>
+#include <set>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <vector>
+#include <algorithm>
 
 using namespace ns3;
 
+// MLO 使用時のリンク振り分けポリシー
+// TID-to-Link マッピングと組み合わせ、送信パケットの TID でリンクを選択する
+enum LinkSteeringPolicy {
+    STEER_NONE = 0,   // 振り分けなし（EDCA 設定に従う）
+    STEER_PIN_I,      // I フレームを最速リンクに固定
+    STEER_SPREAD,     // I フレームは最速リンク、P/B フレームはリンク間でラウンドロビン
+    STEER_DUPLICATE   // I フレームを最速リンクと別リンクに複製送信
+};
+
 // VideoFrameTag: フレーム情報を保持
 class VideoFrameTag : public Tag {
 public:
@@ -41,6 +60,24 @@ public:
     int32_t GetBackwardRefFrameId() const;  // 後方参照フレームID（Bフレームのみ）
     double GetTransmissionStartTime() const;
 
+    // SVC レイヤ情報（非レイヤ構成ではレイヤ 0 のみ）
+    void SetLayerInfo(uint32_t layerId, uint32_t numLayers, uint32_t layerPackets);
+    uint32_t GetLayerId() const;
+    uint32_t GetNumLayers() const;
+    uint32_t GetLayerPackets() const;
+
+    // パケット単位の送信時刻（受信側の遅延勾配推定用）
+    void SetSendTime(double sendTime);
+    double GetSendTime() const;
+
+    // 符号化モデル使用時のキャプチャ時刻（未設定なら送信開始時刻）とスライス情報
+    void SetCaptureTime(double captureTime);
+    double GetCaptureTime() const;
+    void SetSliceInfo(uint32_t sliceId, uint32_t numSlices, uint32_t slicePackets);
+    uint32_t GetSliceId() const;
+    uint32_t GetNumSlices() const;
+    uint32_t GetSlicePackets() const;
+
 private:
     uint32_t m_frameId;
     uint32_t m_frameType;  // 0=I, 1=P, 2=B
@@ -49,6 +86,14 @@ private:
     int32_t m_forwardRefFrameId;   // 前方参照フレームID (-1=参照なし)
     int32_t m_backwardRefFrameId;  // 後方参照フレームID (-1=参照なし, Bフレームのみ使用)
     double m_transmissionStartTime;  // フレーム送信開始時刻 (秒)
+    uint32_t m_layerId;       // SVC レイヤID (0=ベースレイヤ)
+    uint32_t m_numLayers;     // フレームのレイヤ数
+    uint32_t m_layerPackets;  // このパケットが属するレイヤのパケット数
+    double m_sendTime;        // パケット送信時刻 (秒)
+    double m_captureTime;     // フレームのキャプチャ時刻 (秒)
+    uint32_t m_sliceId;       // フレーム内のスライス番号
+    uint32_t m_numSlices;     // フレームのスライス数
+    uint32_t m_slicePackets;  // このパケットが属するスライスのパケット数
 };
 
 // FrameStatistics: 各フレーム統計情報
@@ -64,10 +109,56 @@ struct FrameStatistics {
     double packetReceptionRatio;  // パケット受信率
     double effectiveReceptionRatio;  // ロス連鎖を考慮した有効受信率
     double transmissionStartTime;  // フレーム送信開始時刻 (秒)
+    std::vector<bool> receivedMask;  // パケット単位の受信状況（重複排除用）
+    uint32_t duplicatePackets;       // 重複受信したパケット数（MLO 複製送信時）
+    std::vector<uint32_t> layerReceived;  // レイヤごとの受信パケット数
+    std::vector<uint32_t> layerTotal;     // レイヤごとの総パケット数（そのレイヤのパケット受信時に判明）
+    int32_t decodableLayer;               // 参照も含めて復号可能な最上位レイヤ (-1=ベースレイヤも復号不可)
     double firstPacketArrivalTime;  // 最初のパケット到着時刻 (秒)
     double lastPacketArrivalTime;   // 最後のパケット到着時刻 (秒)
     double latency;  // 遅延時間 (ミリ秒): 送信開始から最後のパケット受信まで
-    bool withinDeadline;  // 許容遅延内かどうか (30fps = 33.3ms)
+    bool withinDeadline;  // 許容遅延内かどうか（既定は 1 フレーム間隔）
+    double captureTime;              // キャプチャ時刻 (秒)
+    std::vector<uint32_t> sliceReceived;  // スライスごとの受信パケット数
+    std::vector<uint32_t> sliceTotal;     // スライスごとの総パケット数（そのスライスのパケット受信時に判明）
+    uint32_t decodedSlices;          // 先頭から順に復号を終えたスライス数
+    double decodeReadyTime;          // 全スライスの復号完了時刻 (秒, -1=未完了)
+    double glassToGlass;             // キャプチャから復号完了まで (ミリ秒, -1=復号不可)
+    double displayTime;              // 表示時刻 (秒, -1=表示されない)
+    double displayLatency;           // キャプチャから表示まで (ミリ秒, -1=表示されない)
+    uint32_t reorderOccupancy;       // 復号完了直後の並べ替えバッファ内のフレーム数（自身を含む）
+    double ownDamage;     // 自フレームのロスによる劣化率のキャッシュ（-1=未計算, パケット受信で無効化）
+    double damage;        // 推定劣化率（自フレームのロスと参照劣化の合成, 0〜1）
+    double psnr;          // 推定 PSNR (dB)
+    double ssim;          // 推定 SSIM
+};
+
+// フレームID → フレーム統計（ノードは FlowStatsStore の共有プールから確保）
+typedef std::map<uint32_t, FrameStatistics, std::less<uint32_t>,
+                 FramePoolAllocator<std::pair<const uint32_t, FrameStatistics>>> FrameStatsMap;
+
+// VideoFlowSummary: フロー単位の集計値（BSS 単位の集計などに使用）
+struct VideoFlowSummary {
+    uint32_t frames;          // 受信したフレーム数（1パケット以上受信）
+    uint32_t completeFrames;  // 全パケットを受信したフレーム数
+    uint32_t onTimeFrames;    // 許容遅延内のフレーム数
+    double meanLatency;       // 平均遅延 (ミリ秒)
+    double p95Latency;        // 95パーセンタイル遅延 (ミリ秒)
+    double p99Latency;        // 99パーセンタイル遅延 (ミリ秒)
+    double meanPsnr;          // 平均推定 PSNR (dB)
+    double meanSsim;          // 平均推定 SSIM
+};
+
+// VideoLiveSample: 実行中のサンプリング区間ごとの集計値（ライブメトリクス出力用）
+struct VideoLiveSample {
+    uint64_t rxPackets;        // 区間内に受信したパケット数（重複除く）
+    uint64_t rxBytes;          // 区間内に受信したバイト数
+    uint32_t finalizedFrames;  // 区間内に確定したフレーム数（送信開始から一定時間経過）
+    uint64_t expectedPackets;  // 確定したフレームの総パケット数
+    uint64_t lostPackets;      // 確定したフレームの未着パケット数
+    double p50Latency;         // 区間内パケット遅延の中央値 (ミリ秒)
+    double p95Latency;
+    double p99Latency;
 };
 
 // VideoFrameSenderApplication: 送信アプリ
@@ -83,6 +174,25 @@ public:
     void SetGopSize(uint32_t gopSize);
     void SetFrameInterval(Time interval);
     void SetEdcaEnabled(bool enabled);
+    void SetLinkSteering(LinkSteeringPolicy policy, std::vector<uint8_t> linkTids, uint32_t fastLinkId);
+    // Annex-B ビットストリームをフレーム源にする（未設定なら合成フレーム）
+    void SetBitstreamSource(Ptr<AnnexBSource> source);
+    // GOP 構造テーブル（未設定なら gopSize の closed IBBP）
+    void SetGopStructure(Ptr<GopStructure> gop);
+    // SVC レイヤ数と、フレームのパケットのうちベースレイヤに割り当てる割合
+    void SetSvcLayers(uint32_t numLayers, double baseShare);
+    // 受信側からの目標ビットレートに従ってフレームサイズとペーシングを調整する
+    void SetCongestionControl(double minBps, double maxBps, double startBps);
+    // 符号化時間モデル（未設定なら符号化は瞬時）
+    void SetEncoderTiming(Ptr<EncoderTimingModel> encoder);
+    // フレームをスライスに分け、符号化を終えたスライスから順に送信する
+    void SetSlices(uint32_t numSlices);
+    // GOP 構造のデコード順（I P B B ...）で送信する（合成フレームのみ）
+    void SetDecodeOrder(bool enabled);
+    // 映像パケットの IP ヘッダに付ける ECN コードポイント（1 = ECT(1)、L4S の低遅延キューに分類される）
+    void SetEcnCodepoint(uint8_t ecn);
+
+    typedef void (*TargetRateCallback)(double targetBps);
 
 private:
     virtual void StartApplication();
@@ -96,13 +206,30 @@ private:
         uint32_t framePackets,
         int32_t fwdRefFrameId,
         int32_t bwdRefFrameId,
-        double txStartTime
+        double txStartTime,
+        uint8_t tos,
+        uint32_t packetSize,
+        uint32_t layerId,
+        uint32_t numLayers,
+        uint32_t layerPackets,
+        double captureTime,
+        uint32_t sliceId,
+        uint32_t numSlices,
+        uint32_t slicePackets
     );
     void GenerateFrame();
-    uint32_t GetFrameType(uint32_t frameNum);
+    uint8_t GetFrameTos(uint32_t frameType);
     uint32_t GetFramePackets(uint32_t frameType);
-    int32_t GetForwardRefFrameId(uint32_t frameNum, uint32_t frameType);
-    int32_t GetBackwardRefFrameId(uint32_t frameNum, uint32_t frameType);
+    // 合成フレームのパケット数（イントラリフレッシュでは I と P の差分をイントラ列として周期内に配る）
+    uint32_t GetSyntheticFramePackets(uint32_t frameId);
+    void SplitLayers(uint32_t framePackets);
+    // スライスごとのパケット数と、現在時刻から各スライスの符号化完了までの時間を決める
+    void ScheduleSlices(uint32_t frameType, uint32_t framePackets);
+    // デコード順で次に送るフレームID（open GOP の先頭 GOP では前 GOP の B を飛ばす）
+    uint32_t NextDecodeOrderFrame();
+    void HandleFeedback(Ptr<Socket> socket);
+    uint32_t ScaleFramePackets(uint32_t framePackets) const;
+    double GetNominalRate();
 
     Ptr<Socket> m_socket;
     Ipv4Address m_peerAddress;
@@ -114,6 +241,32 @@ private:
     uint32_t m_frameNum;
     bool m_edcaEnabled;
     Time m_packetGap;
+    LinkSteeringPolicy m_steeringPolicy;
+    std::vector<uint8_t> m_linkTids;  // 各リンクに対応付けた TID（インデックス = リンクID）
+    uint32_t m_fastLinkId;            // 最速リンクのID
+    uint32_t m_spreadCounter;         // P/B フレームのラウンドロビン用カウンタ
+    Ptr<AnnexBSource> m_source;       // ビットストリーム再生時のフレーム源
+    AnnexBAccessUnit m_au;            // 現在のアクセスユニット（再利用してアロケーションを避ける）
+    Ptr<GopStructure> m_gop;          // フレームタイプ・参照のテーブル
+    uint32_t m_numLayers;             // SVC レイヤ数（1 = 非レイヤ）
+    double m_baseShare;               // ベースレイヤに割り当てるパケットの割合
+    std::vector<uint32_t> m_layerPackets;  // 現在のフレームのレイヤごとのパケット数
+    bool m_ccEnabled;                 // 輻輳制御の有効/無効
+    double m_ccMinRate;               // 目標ビットレートの下限・上限 (bps)
+    double m_ccMaxRate;
+    double m_targetRate;              // 現在の目標ビットレート (bps)
+    double m_nominalRate;             // 合成フレームサイズでの平均ビットレート (bps)
+    Time m_pacerNext;                 // ペーサーが次のパケットを出せる時刻
+    Ptr<EncoderTimingModel> m_encoder;
+    uint32_t m_numSlices;             // フレームあたりのスライス数
+    Time m_encoderFree;               // 符号化器が次のフレームに取りかかれる時刻
+    std::vector<uint32_t> m_slicePackets;  // 現在のフレームのスライスごとのパケット数
+    std::vector<Time> m_sliceReady;        // 現在時刻から各スライスの符号化完了までの時間
+    bool m_decodeOrderTx;             // デコード順送信の有効/無効
+    uint32_t m_decodeSlot;            // デコード順テーブル上の通し位置
+    Time m_captureBase;               // フレーム 0 のキャプチャ時刻
+    uint8_t m_ecn;                    // ToS の下位 2 ビットに付ける ECN コードポイント
+    TracedCallback<double> m_targetRateTrace;
 };
 
 // VideoFrameReceiverApplication: 受信アプリ
@@ -125,22 +278,99 @@ public:
 
     void SetPort(uint16_t port);
     void SetPacketLogFile(std::string filename);
+    // 複数の受信アプリで統計の置き場とパケットログを共有する（受信開始前に呼ぶ。未設定なら専用の置き場を作る）
+    void SetStatsStore(Ptr<FlowStatsStore> store);
+    uint32_t GetFlowId() const;
+    // 送信側と同じ GOP 構造テーブルで依存関係を解析する（未設定ならタグの参照情報を使用）
+    void SetGopStructure(Ptr<GopStructure> gop);
     void SaveStatisticsToFile(std::string filename);
+    void SaveGopQualityToFile(std::string filename);
+    // フレームタイプ別のキャプチャから復号完了までの遅延（glass-to-glass）
+    void SaveGlassToGlassToFile(std::string filename);
+    // 許容遅延（既定 33.3ms）と 1 フレームあたりの復号時間（スライス分割時は等分）
+    void SetDeadline(Time deadline);
+    void SetDecodeTime(Time decodeTime);
+    VideoFlowSummary GetFlowSummary();
+    // ライブメトリクスの区間集計を有効にする（有効にしない限りパケットごとの遅延を溜めない）
+    // 送信側の最初のフレームの送信時刻とフレーム周期は 1 パケットも届かないフレームを数えるために使う
+    void EnableLiveMetrics(Time firstFrame, Time frameInterval);
+    // 前回呼び出し以降の区間集計を取得してリセット（finalizeAge 経過したフレームのロスを確定）
+    VideoLiveSample TakeLiveSample(Time finalizeAge);
+    // 遅延勾配で帯域を推定し、送信元へ目標ビットレートを定期的に返す
+    void EnableCongestionFeedback(Ptr<DelayBasedBwe> bwe, Time interval);
+
+    typedef void (*DelayGradientCallback)(double modifiedTrend, double threshold, uint32_t usage, double targetBps,
+                                          double ceAlpha);
 
 private:
+    // マイクロベンチマーク（video-stream-microbench）から受信処理を直接呼ぶため
+    friend class VideoFrameReceiverBenchAccess;
+
     virtual void StartApplication();
     virtual void StopApplication();
+    virtual void DoDispose();
 
+    // 統計の置き場（SetStatsStore で共有しなければ最初に必要になったときに専用の置き場を作る）
+    Ptr<FlowStatsStore> GetStatsStore();
     void HandleRead(Ptr<Socket> socket);
     void CalculateStatistics();
+    void UpdateStatistics();
+    double GetOwnDamage(uint32_t frameId);
+    // 1 パケットも届かなかったフレームのパケット数の推定（同じタイプの直近のフレーム、不明なら 1）
+    uint32_t EstimateFramePackets(uint32_t frameId) const;
+    double ResolveFrameDamage(uint32_t frameId, std::map<uint32_t, double>& resolved, uint32_t depth);
+    // イントラリフレッシュの劣化をフレームID順に 1 フレームずつ進めて求める
+    // damaged は直近 1 周期内で劣化のあったフレーム（ID, 自フレームの劣化率）だけを保持する
+    double AdvanceRefreshDamage(uint32_t frameId, double ownDamage,
+                                std::deque<std::pair<uint32_t, double>>& damaged);
+    int32_t ResolveDecodableLayer(uint32_t frameId, std::map<uint32_t, int32_t>& resolved, uint32_t depth);
+    bool IsLayerComplete(const FrameStatistics& stat, uint32_t layerId) const;
+    // 受信を終えたスライスを先頭から順に復号器へ渡す（復号器は 1 つでフレーム間でも直列）
+    // 参照フレームの復号が終わるまでは始められない。全スライスを復号したら true
+    bool DecodeSlices(FrameStatistics& stat, double now);
+    // 復号待ちのフレームをデコード順に先頭から復号する（先頭が進まなければ後続も待つ）
+    void DecodePending(double now);
+    // 復号器が処理する順序のキー（GOP 構造が不明ならフレームID順）
+    uint64_t GetDecodeIndex(uint32_t frameId) const;
+    // 参照フレームがすべて復号済みならその最遅の復号完了時刻を返す
+    bool GetReferenceReadyTime(const FrameStatistics& stat, double& readyTime) const;
+    // 表示時刻と並べ替えバッファの占有（表示順に、前のフレームの表示後に表示）
+    void ResolveDisplay();
+    void SendFeedback();
     void LogPacket(uint32_t frameId, uint32_t frameType, uint32_t packetIndex,
-                   uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef);
+                   uint32_t totalPackets, double txTime, double rxTime, int32_t fwdRef, int32_t bwdRef,
+                   double sendTime);
 
     Ptr<Socket> m_socket;
     uint16_t m_port;
-    std::map<uint32_t, FrameStatistics> m_frameStats;
+    Ptr<FlowStatsStore> m_statsStore;  // m_frameStats のアロケータが参照するので先に宣言する（null = 未作成）
+    uint32_t m_flowId;                 // m_statsStore 内のフローID
+    FrameStatsMap m_frameStats;
+    Ptr<GopStructure> m_gop;
+    // ライブメトリクス用の区間集計（パケット数・バイト数は m_statsStore 側）
+    bool m_liveMetrics;                   // 区間集計を行うか（EnableLiveMetrics で有効）
+    std::vector<double> m_liveLatencies;  // 区間内パケット遅延 (ミリ秒)
+    uint32_t m_liveCursor;                // 次に確定するフレームID
+    Time m_firstFrameTime;                // 最初のフレームの送信時刻
+    Time m_frameInterval;                 // フレーム周期（0 = 不明）
+    uint32_t m_typicalPackets[3];         // フレームタイプ別の直近のフレームのパケット数（欠落フレームの推定用）
     std::string m_packetLogFile;
-    std::ofstream m_packetLogStream;
+    Time m_deadline;
+    Time m_decodeTime;
+    double m_decoderFree;  // 復号器が空く時刻 (秒)
+    std::map<uint64_t, uint32_t> m_pendingDecode;  // スライス受信済みで復号を待つフレーム（デコード順 → フレームID）
+    uint32_t m_pendingIntra;                       // m_pendingDecode 内の I フレーム数
+    uint64_t m_decodeNext;                         // 復号器が次に扱えるデコード順（これより前のフレームは届いても捨てる）
+    TracedCallback<Ptr<const Packet>, const Address&> m_rxTrace;  // 映像パケットの受信（重複除く）
+    // 輻輳制御フィードバック
+    Ptr<DelayBasedBwe> m_bwe;
+    Time m_feedbackInterval;
+    EventId m_feedbackEvent;
+    Address m_feedbackPeer;
+    bool m_hasFeedbackPeer;
+    uint32_t m_bweGroups;  // 前回トレースを出した時点の評価済みグループ数
+    TracedCallback<double, double, uint32_t, double, double> m_delayGradientTrace;
+    bool m_statsValid;  // m_frameStats の集計結果（遅延・参照ロス・画質）が最新か
 };
 
 #endif // VIDEO_FRAME_H
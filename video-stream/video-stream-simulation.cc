@@ -3,16 +3,79 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/wifi-module.h"
+#include "ns3/spectrum-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/fd-net-device-module.h"
+#include "ns3/traffic-control-module.h"
 #include "ns3/mobility-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/flow-monitor-helper.h"
 #include "ns3/ipv4-flow-classifier.h"
 #include "video-frame.h"
 #include "log.h"
+#include "deadline-mu-scheduler.h"
+#include "emu-bridge.h"
+#include "layer-drop-queue-disc.h"
+#include "multicast-convert-queue-disc.h"
+#include "metrics-exporter.h"
+#include "latency-breakdown.h"
+#include "cross-traffic.h"
+#include "congestion-controller.h"
+#include "replay-link.h"
+#include "wan-link.h"
+#include "dual-queue-disc.h"
+#include "twt-scheduler.h"
+#include "flow-stats-store.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
 
 
 using namespace ns3;
 
+// BSS ごとのチャネル番号を決定
+// "same": 全 BSS が同一チャネル, "reuse3": 1/6/11 の 3 色塗り分け, "1,6,11,...": 明示指定
+static uint32_t GetBssChannel(const std::string& channelPlan, uint32_t bssIndex, uint32_t gridCols) {
+    if (channelPlan == "same") {
+        return 1;
+    }
+    if (channelPlan == "reuse3") {
+        const uint32_t reuseChannels[] = {1, 6, 11};
+        uint32_t col = bssIndex % gridCols;
+        uint32_t row = bssIndex / gridCols;
+        // 隣接 AP（上下左右）が異なるチャネルになるよう塗り分け
+        return reuseChannels[(col + 2 * row) % 3];
+    }
+
+    std::vector<uint32_t> channels;
+    std::stringstream ss(channelPlan);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        channels.push_back(std::stoul(item));
+    }
+    NS_ABORT_MSG_IF(channels.empty(), "Invalid channelPlan: " << channelPlan);
+    return channels[bssIndex % channels.size()];
+}
+
+// リンク振り分けポリシー名を変換
+static LinkSteeringPolicy ParseSteeringPolicy(const std::string& name) {
+    if (name == "none") {
+        return STEER_NONE;
+    }
+    if (name == "pin-i") {
+        return STEER_PIN_I;
+    }
+    if (name == "spread") {
+        return STEER_SPREAD;
+    }
+    if (name == "duplicate") {
+        return STEER_DUPLICATE;
+    }
+    NS_ABORT_MSG("Unknown steering policy: " << name);
+    return STEER_NONE;
+}
+
 int main(int argc, char *argv[]) {
     bool enableAmpdu = false;
     bool enableEdca = false;
@@ -20,7 +83,77 @@ int main(int argc, char *argv[]) {
     uint32_t gopSize = 60;
     double distance = 20.0;
     double simulationTime = 10.0;
+    double fps = 30.0;
+    double deadlineMs = 0.0;
+    bool encoderModel = false;
+    double encodeIMs = 12.0;
+    double encodePMs = 7.0;
+    double encodeBMs = 5.0;
+    double encodeCv = 0.2;
+    double decodeMs = 3.0;
+    uint32_t slices = 1;
+    bool decodeOrder = false;
     std::string outputDir = "/Users/akira/workspace/ns-3.46.1/scratch/video-sim-log";
+    uint32_t numBss = 1;
+    uint32_t stasPerBss = 1;
+    std::string channelPlan = "same";
+    double bssSpacing = 30.0;
+    double bgLoadMbps = 0.0;
+    double bgStart = 3.0;
+    bool enableCc = false;
+    double ccMinRateMbps = 0.3;
+    double ccMaxRateMbps = 20.0;
+    double ccStartRateMbps = 4.0;
+    double ccFeedbackMs = 100.0;
+    CrossTrafficConfig crossConfig;
+    uint32_t crossStasPerBss = 0;
+    bool enableMlo = false;
+    std::string steering = "none";
+    std::string muScheduler = "none";
+    uint32_t muStations = 4;
+    bool emulation = false;
+    uint16_t rtpInPort = 5004;
+    std::string rtpOutHost = "127.0.0.1";
+    uint16_t rtpOutPort = 5006;
+    double lagToleranceMs = 5.0;
+    std::string bitstream = "";
+    std::string codec = "auto";
+    std::string gopMode = "ibbp";
+    uint32_t bFrames = 2;
+    bool openGop = false;
+    uint32_t svcLayers = 1;
+    double svcBaseShare = 0.5;
+    bool layerDrop = false;
+    uint32_t shedThreshold = 100;
+    uint32_t layerStep = 25;
+    uint32_t layerMacQueue = 64;
+    double metricsIntervalMs = 0.0;
+    std::string metricsSink = "shm:/video-stream-metrics";
+    uint32_t metricsRingSize = 4096;
+    bool ampduStats = false;
+    bool ampduHistogram = false;
+    bool queuePeak = false;
+    bool latencyBreakdown = false;
+    bool gopQuality = false;
+    std::string replayLog = "";
+    std::string replayQosLog = "";
+    bool multicast = false;
+    std::string mcastMode = "legacy";
+    std::string mcastRate = "";
+    bool wan = false;
+    double wanRateMbps = 50.0;
+    double wanDelayMs = 20.0;
+    double wanJitterMs = 0.0;
+    double wanLoss = 0.0;
+    double wanBurst = 1.0;
+    std::string wanQdisc = "fifo";
+    std::string wanQueue = "1000p";
+    bool wanEcn = false;
+    bool twt = false;
+    uint32_t twtInterval = 1;
+    double twtDurationMs = 8.0;
+    double twtOffsetMs = 1.0;
+    double twtGuardMs = 1.0;
 
     CommandLine cmd;
     cmd.AddValue("ampdu", "Enable A-MPDU aggregation", enableAmpdu);
@@ -29,34 +162,242 @@ int main(int argc, char *argv[]) {
     cmd.AddValue("gopSize", "GOP size", gopSize);
     cmd.AddValue("distance", "Distance between AP and STA (m)", distance);
     cmd.AddValue("simTime", "Simulation time (s)", simulationTime);
+    cmd.AddValue("fps", "Video frame rate (frames/s)", fps);
+    cmd.AddValue("deadline", "Frame latency deadline (ms, 0 = one frame interval)", deadlineMs);
+    cmd.AddValue("encoderModel", "Model per-frame-type encode times and decoder time instead of instant coding", encoderModel);
+    cmd.AddValue("encodeI", "Mean I frame encode time (ms)", encodeIMs);
+    cmd.AddValue("encodeP", "Mean P frame encode time (ms)", encodePMs);
+    cmd.AddValue("encodeB", "Mean B frame encode time (ms)", encodeBMs);
+    cmd.AddValue("encodeCv", "Coefficient of variation of the encode time (log-normal)", encodeCv);
+    cmd.AddValue("decodeTime", "Decode time per frame at the receiver (ms)", decodeMs);
+    cmd.AddValue("slices", "Slices per frame, each sent as soon as it is encoded (1 = whole frame)", slices);
+    cmd.AddValue("decodeOrder", "Send frames in decode order (B frames after their backward reference) instead of display order", decodeOrder);
     cmd.AddValue("outputDir", "Output directory for CSV files", outputDir);
+    cmd.AddValue("numBss", "Number of BSSs (APs) placed on a grid", numBss);
+    cmd.AddValue("stasPerBss", "Number of video STAs per BSS", stasPerBss);
+    cmd.AddValue("channelPlan", "Channel assignment: same, reuse3 or a list such as 1,6,11", channelPlan);
+    cmd.AddValue("bssSpacing", "Distance between neighbouring APs on the grid (m)", bssSpacing);
+    cmd.AddValue("bgLoad", "Background UDP load per BSS (Mbps, 0 = off)", bgLoadMbps);
+    cmd.AddValue("bgStart", "Start time of the background UDP load (s)", bgStart);
+    cmd.AddValue("cc", "Enable delay-gradient congestion control of the video sender", enableCc);
+    cmd.AddValue("ccMinRate", "Minimum target bitrate (Mbps)", ccMinRateMbps);
+    cmd.AddValue("ccMaxRate", "Maximum target bitrate (Mbps)", ccMaxRateMbps);
+    cmd.AddValue("ccStartRate", "Initial target bitrate (Mbps)", ccStartRateMbps);
+    cmd.AddValue("ccFeedback", "Receiver feedback interval (ms)", ccFeedbackMs);
+    cmd.AddValue("crossStas", "Extra (non-video) STAs per BSS for cross traffic (0 = one if any cross traffic)", crossStasPerBss);
+    cmd.AddValue("tcpFlows", "Downlink bulk TCP flows per BSS (AC_BE)", crossConfig.tcpFlows);
+    cmd.AddValue("voipFlows", "Downlink VoIP-like CBR flows per BSS (AC_VO)", crossConfig.voipFlows);
+    cmd.AddValue("voipRate", "Rate of each VoIP flow (kbps)", crossConfig.voipKbps);
+    cmd.AddValue("webFlows", "Downlink bursty on/off web flows per BSS (TCP, AC_BE)", crossConfig.webFlows);
+    cmd.AddValue("webRate", "Peak rate of each web flow during a burst (Mbps)", crossConfig.webPeakMbps);
+    cmd.AddValue("webOnTime", "Mean web burst length (ms, exponential)", crossConfig.webOnMs);
+    cmd.AddValue("webOffTime", "Mean web idle time between bursts (ms, exponential)", crossConfig.webOffMs);
+    cmd.AddValue("uplinkFlows", "Uplink upload flows per BSS from the extra STAs", crossConfig.uplinkFlows);
+    cmd.AddValue("uplinkRate", "Rate of each uplink flow (Mbps, 0 = bulk TCP)", crossConfig.uplinkMbps);
+    cmd.AddValue("mlo", "Enable Wi-Fi 7 multi-link operation (2.4/5/6 GHz links)", enableMlo);
+    cmd.AddValue("steering", "MLO link steering policy: none, pin-i, spread, duplicate", steering);
+    cmd.AddValue("muScheduler", "DL OFDMA multi-user scheduler: none, rr, deadline", muScheduler);
+    cmd.AddValue("muStations", "Maximum number of STAs per DL MU PPDU", muStations);
+    cmd.AddValue("emulation", "Real-time emulation: forward a local RTP/UDP stream through the network", emulation);
+    cmd.AddValue("rtpInPort", "Local UDP port receiving the RTP stream to inject (emulation)", rtpInPort);
+    cmd.AddValue("rtpOutHost", "Host receiving the RTP stream after the Wi-Fi hop (emulation)", rtpOutHost);
+    cmd.AddValue("rtpOutPort", "UDP port receiving the RTP stream after the Wi-Fi hop (emulation)", rtpOutPort);
+    cmd.AddValue("lagTolerance", "Allowed real-time lag before a probe counts as a missed deadline (ms)", lagToleranceMs);
+    cmd.AddValue("bitstream", "Annex-B H.264/H.265 file to replay instead of synthetic frames", bitstream);
+    cmd.AddValue("codec", "Bitstream codec: auto (from extension), h264 or h265", codec);
+    cmd.AddValue("gopMode", "GOP structure: ippp, ibbp, hierarchical or intra (intra refresh over gopSize frames, no I frames)", gopMode);
+    cmd.AddValue("bFrames", "Number of consecutive B frames between anchors (ibbp/hierarchical)", bFrames);
+    cmd.AddValue("openGop", "Let trailing B frames reference the next GOP's I frame", openGop);
+    cmd.AddValue("svcLayers", "Number of SVC layers per frame (1 = single layer)", svcLayers);
+    cmd.AddValue("svcBaseShare", "Fraction of each frame's packets carried in the base layer", svcBaseShare);
+    cmd.AddValue("layerDrop", "Shed SVC enhancement layers at the AP queue when it builds up", layerDrop);
+    cmd.AddValue("shedThreshold", "AP queue length (packets) at which enhancement layer 1 is shed", shedThreshold);
+    cmd.AddValue("layerStep", "Threshold reduction (packets) per higher enhancement layer", layerStep);
+    cmd.AddValue("layerMacQueue", "Wi-Fi MAC queue size (packets) per AC when layerDrop is set", layerMacQueue);
+    cmd.AddValue("metricsInterval", "Live metrics sampling interval in simulated time (ms, 0 = off)", metricsIntervalMs);
+    cmd.AddValue("metricsSink", "Live metrics sink: shm:<name> (shared-memory ring) or unix:<path> (datagram socket)", metricsSink);
+    cmd.AddValue("metricsRingSize", "Number of records in the shared-memory ring", metricsRingSize);
+    cmd.AddValue("ampduStats", "Aggregate AP A-MPDU statistics (subframes, bytes, airtime, video frames) per AC and write ampdu_summary", ampduStats);
+    cmd.AddValue("ampduHistogram", "Also write the full A-MPDU histograms (implies ampduStats)", ampduHistogram);
+    cmd.AddValue("queuePeak", "Write queue_peak: per-BSS AP queue peaks and the worst STA's p99 frame latency", queuePeak);
+    cmd.AddValue("latencyBreakdown", "Decompose the first flow's latency into per-hop stages", latencyBreakdown);
+    cmd.AddValue("gopQuality", "Write gop_quality: estimated PSNR/SSIM per GOP", gopQuality);
+    cmd.AddValue("replay", "packet_log of a full-stack run: replace the Wi-Fi hop with a replay link built from it", replayLog);
+    cmd.AddValue("replayQos", "PhyRx/qos_log of the same run, to condition the replay link on the AC", replayQosLog);
+    cmd.AddValue("multicast", "Send one stream to a multicast group joined by every STA of the BSS", multicast);
+    cmd.AddValue("mcastMode", "AP multicast delivery: legacy (group frames at a basic rate) or convert (per-STA unicast)", mcastMode);
+    cmd.AddValue("mcastRate", "WifiMode for legacy group frames (empty = the lowest basic rate)", mcastRate);
+    cmd.AddValue("wan", "Replace the ideal server-AP link with a WAN segment (bottleneck, delay, jitter, loss, AQM)", wan);
+    cmd.AddValue("wanRate", "WAN bottleneck rate (Mbps)", wanRateMbps);
+    cmd.AddValue("wanDelay", "WAN one-way propagation delay (ms)", wanDelayMs);
+    cmd.AddValue("wanJitter", "Maximum extra WAN delay per packet (ms, uniform, order preserving)", wanJitterMs);
+    cmd.AddValue("wanLoss", "Downlink WAN packet loss rate", wanLoss);
+    cmd.AddValue("wanBurst", "Mean WAN loss burst length in packets (1 = independent losses, >1 = Gilbert-Elliott)", wanBurst);
+    cmd.AddValue("wanQdisc", "Queue discipline at the WAN bottleneck: fifo, codel, fqcodel or dualq", wanQdisc);
+    cmd.AddValue("wanQueue", "Queue limit at the WAN bottleneck (e.g. 1000p)", wanQueue);
+    cmd.AddValue("wanEcn", "Send video as ECT(1) (L4S) and let CoDel/FQ-CoDel mark instead of drop (needs cc)", wanEcn);
+    cmd.AddValue("twt", "Put the video STAs in individual TWT power save aligned to the frame interval", twt);
+    cmd.AddValue("twtInterval", "TWT wake interval in frame intervals", twtInterval);
+    cmd.AddValue("twtDuration", "TWT service period length (ms)", twtDurationMs);
+    cmd.AddValue("twtOffset", "Service period start after each frame is generated at the sender (ms)", twtOffsetMs);
+    cmd.AddValue("twtGuard", "Time the STA stays awake after the AP stops sending at the end of a service period (ms)", twtGuardMs);
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_IF(numBss == 0 || stasPerBss == 0, "numBss and stasPerBss must be at least 1");
+    ampduStats = ampduStats || ampduHistogram;
+    LinkSteeringPolicy steeringPolicy = ParseSteeringPolicy(steering);
+    NS_ABORT_MSG_IF(steeringPolicy != STEER_NONE && !enableMlo, "steering requires --mlo");
+    NS_ABORT_MSG_IF(muScheduler != "none" && muScheduler != "rr" && muScheduler != "deadline",
+                    "Unknown muScheduler: " << muScheduler);
+    NS_ABORT_MSG_IF(emulation && (numBss != 1 || stasPerBss != 1),
+                    "emulation supports a single BSS with one STA");
+    NS_ABORT_MSG_IF(svcLayers == 0, "svcLayers must be at least 1");
+    NS_ABORT_MSG_IF(svcLayers > 1 && !bitstream.empty(), "SVC layers are only available for synthetic frames");
+    NS_ABORT_MSG_IF(fps <= 0.0, "fps must be positive");
+    NS_ABORT_MSG_IF(slices == 0, "slices must be at least 1");
+    NS_ABORT_MSG_IF(slices > 1 && svcLayers > 1, "slices cannot be combined with SVC layers");
+    NS_ABORT_MSG_IF(decodeOrder && !bitstream.empty(), "Bitstreams are already sent in decode order");
+    NS_ABORT_MSG_IF(mcastMode != "legacy" && mcastMode != "convert", "Unknown mcastMode: " << mcastMode);
+    NS_ABORT_MSG_IF(multicast && (numBss != 1 || emulation || !replayLog.empty()),
+                    "multicast supports a single full-stack BSS");
+    NS_ABORT_MSG_IF(enableCc && ccFeedbackMs <= 0.0, "ccFeedback must be positive");
+    NS_ABORT_MSG_IF(enableCc && !bitstream.empty(),
+                    "cc cannot be combined with bitstream: bitstream frame sizes do not follow the target rate");
+    NS_ABORT_MSG_IF(multicast && (enableCc || layerDrop || enableMlo),
+                    "multicast cannot be combined with cc, layerDrop or mlo");
+    // 段階分解は 1 フロー・1 宛先の送信を前提にしており、グループ宛ての複製や全 STA 共通のフレームIDを区別できない
+    NS_ABORT_MSG_IF(multicast && latencyBreakdown, "latencyBreakdown cannot be combined with multicast");
+    NS_ABORT_MSG_IF(wanQdisc != "fifo" && wanQdisc != "codel" && wanQdisc != "fqcodel" && wanQdisc != "dualq",
+                    "Unknown wanQdisc: " << wanQdisc);
+    NS_ABORT_MSG_IF(wan && (wanRateMbps <= 0.0 || wanLoss < 0.0 || wanLoss >= 1.0 || wanBurst < 1.0),
+                    "Invalid WAN parameters");
+    NS_ABORT_MSG_IF(wan && !replayLog.empty(), "replay assumes the ideal server-AP link");
+    // ECN マークに反応するのは輻輳制御だけなので、cc なしでは映像が無反応なフローになり AQM の結果が意味を持たない
+    NS_ABORT_MSG_IF(wanEcn && !(wan && enableCc), "wanEcn needs wan and cc (the video reacts to CE marks through cc)");
+    NS_ABORT_MSG_IF(twt && (enableMlo || !replayLog.empty() || (multicast && mcastMode == "legacy")),
+                    "twt needs a single-link full-stack BSS with unicast delivery");
+    NS_ABORT_MSG_IF(twt && twtInterval == 0, "twtInterval must be at least 1");
+
+    // フレーム間隔と許容遅延（既定は 1 フレーム間隔）
+    Time frameInterval = Seconds(1.0 / fps);
+    if (deadlineMs <= 0.0) {
+        deadlineMs = 1000.0 / fps;
+    }
+    Time deadline = MicroSeconds(static_cast<int64_t>(deadlineMs * 1000));
+
+    // 符号化時間モデル（送信側の符号化待ちと受信側の復号時間）
+    Ptr<EncoderTimingModel> encoderTiming;
+    if (encoderModel) {
+        encoderTiming = Create<EncoderTimingModel>();
+        encoderTiming->SetEncodeTime(0, MicroSeconds(static_cast<int64_t>(encodeIMs * 1000)), encodeCv);
+        encoderTiming->SetEncodeTime(1, MicroSeconds(static_cast<int64_t>(encodePMs * 1000)), encodeCv);
+        encoderTiming->SetEncodeTime(2, MicroSeconds(static_cast<int64_t>(encodeBMs * 1000)), encodeCv);
+        encoderTiming->SetDecodeTime(MicroSeconds(static_cast<int64_t>(decodeMs * 1000)));
+    }
+
+    // 再生リンク: 全スタック実行のログから Wi-Fi 区間の遅延・損失モデルを作り、PHY/MAC を省いて実行する
+    Ptr<ReplayLinkModel> replayModel;
+    if (!replayLog.empty()) {
+        NS_ABORT_MSG_IF(enableMlo || muScheduler != "none" || layerDrop || emulation,
+                        "replay does not model MLO, DL OFDMA, layer shedding or emulation");
+        NS_ABORT_MSG_IF(metricsIntervalMs > 0.0 || latencyBreakdown,
+                        "live metrics and latency breakdown need the Wi-Fi stack");
+        // モデルの負荷条件は先頭フローだけのパケット数で学習しており、BSS 内の複数フローの合計には対応しない
+        NS_ABORT_MSG_IF(numBss * stasPerBss > 1, "replay supports a single video flow");
+        replayModel = Create<ReplayLinkModel>();
+        NS_ABORT_MSG_IF(!replayModel->Load(replayLog, replayQosLog), "Failed to load replay logs: " << replayLog);
+        replayModel->SetFixedDelay(MilliSeconds(1));  // ログの遅延に含まれる有線 p2p の伝搬遅延
+        ampduStats = false;
+    }
+
+    // エミュレーション時は壁時計に同期して実行し、実パケットを扱うためチェックサムを有効化
+    if (emulation) {
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+        GlobalValue::Bind("ChecksumEnabled", BooleanValue(true));
+    }
+
     //LogComponentEnable("VideoFrame", LOG_LEVEL_INFO);
     //LogComponentEnable("UdpServer", LOG_LEVEL_INFO);
     //LogComponentEnable("UdpClient", LOG_LEVEL_INFO);
     Time::SetResolution(Time::NS);
 
+    // 競合 TCP フローはセグメントを MTU 近くまで大きくしてパケット数（イベント数）を抑える
+    if (crossConfig.IsEnabled()) {
+        Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(1448));
+    }
+
+    uint32_t numFlows = numBss * stasPerBss;
+    uint32_t gridCols = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(numBss))));
+
     // ノード作成
     NodeContainer server;
     server.Create(1);
 
     NodeContainer ap;
-    ap.Create(1);
+    ap.Create(numBss);
 
     NodeContainer sta;
-    sta.Create(1);
+    sta.Create(numFlows);
 
-    // 有線リンク（サーバー - AP）
+    // 競合トラフィック用の追加 STA（映像 STA とは別）
+    if (crossConfig.IsEnabled() && crossStasPerBss == 0) {
+        crossStasPerBss = 1;
+    }
+    NodeContainer crossSta;
+    crossSta.Create(numBss * crossStasPerBss);
+
+    // 有線リンク（サーバー - 各AP）
+    // WAN 区間を有効にすると、各 AP へのリンクがボトルネックレート・伝搬遅延・揺らぎ・下りの損失を持つ
     PointToPointHelper p2p;
     p2p.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
     p2p.SetChannelAttribute("Delay", StringValue("1ms"));
-    NetDeviceContainer p2pDevices = p2p.Install(server.Get(0), ap.Get(0));
+    std::vector<NetDeviceContainer> p2pDevices;
+    for (uint32_t b = 0; b < numBss; b++) {
+        if (!wan) {
+            p2pDevices.push_back(p2p.Install(server.Get(0), ap.Get(b)));
+            continue;
+        }
+        Ptr<ErrorModel> wanLossModel;
+        if (wanLoss > 0.0 && wanBurst > 1.0) {
+            Ptr<GilbertElliottErrorModel> ge = CreateObject<GilbertElliottErrorModel>();
+            ge->SetGilbert(wanLoss, wanBurst);
+            ge->AssignStreams(200 + b);
+            wanLossModel = ge;
+        } else if (wanLoss > 0.0) {
+            Ptr<RateErrorModel> rate = CreateObject<RateErrorModel>();
+            rate->SetUnit(RateErrorModel::ERROR_UNIT_PACKET);
+            rate->SetRate(wanLoss);
+            rate->AssignStreams(200 + b);
+            wanLossModel = rate;
+        }
+        p2pDevices.push_back(InstallWanLink(server.Get(0), ap.Get(b),
+                                            DataRate(static_cast<uint64_t>(wanRateMbps * 1e6)),
+                                            MicroSeconds(static_cast<int64_t>(wanDelayMs * 1000)),
+                                            MicroSeconds(static_cast<int64_t>(wanJitterMs * 1000)),
+                                            wanLossModel, 100 + b));
+    }
+
+    // レイヤ破棄: mq の子キューは AC ごとの WifiMacQueue（既定 500p）が満杯になってから伸び始めるので、
+    // MAC キューを小さくして滞留をキューディスク側に寄せ、ShedThreshold が実際の滞留に効くようにする
+    if (layerDrop) {
+        NS_ABORT_MSG_IF(layerMacQueue == 0, "layerMacQueue must be at least 1");
+        Config::SetDefault("ns3::WifiMacQueue::MaxSize",
+                           QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, layerMacQueue)));
+    }
+
+    // TWT の STA は SP の外で眠るためビーコンを取りこぼす。個別 TWT ではビーコンの受信を要しないので関連付けを保つ
+    if (twt) {
+        Config::SetDefault("ns3::StaWifiMac::MaxMissedBeacons", UintegerValue(std::numeric_limits<uint32_t>::max()));
+    }
 
     // WiFi（AP - STA）ダウンリンク方向
     WifiHelper wifi;
     wifi.SetStandard(WIFI_STANDARD_80211be);
     wifi.SetRemoteStationManager ("ns3::IdealWifiManager");
+    if (multicast && !mcastRate.empty()) {
+        // グループ宛てフレーム（ACK なし・集約なし）の送信レート
+        wifi.SetRemoteStationManager("ns3::IdealWifiManager", "NonUnicastMode", StringValue(mcastRate));
+    }
 //    wifi.SetRemoteStationManager(
 //            "ns3::ConstantRateWifiManager",
 //            "DataMode", StringValue("EhtMcs8"),
@@ -64,132 +405,669 @@ int main(int argc, char *argv[]) {
 //            );
 
     // WiFiチャネル（2.4GHz, 20MHz帯域幅）
+    // 全 BSS で同一の物理チャネルを共有し、同一周波数の BSS 間で干渉させる
     YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
 
     YansWifiPhyHelper phy;
     phy.SetChannel(channel.Create());
-    phy.Set("ChannelSettings", StringValue("{0, 20, BAND_2_4GHZ, 0}"));  // 2.4GHz, 20MHz
     phy.SetErrorRateModel("ns3::YansErrorRateModel");
 
+    // MLO: 2.4GHz/20MHz, 5GHz/80MHz, 6GHz/160MHz の3リンク（リンク2が最速）
+    const uint8_t nLinks = 3;
+    const uint32_t fastLinkId = 2;
+    const WifiPhyBand linkBands[] = {WIFI_PHY_BAND_2_4GHZ, WIFI_PHY_BAND_5GHZ, WIFI_PHY_BAND_6GHZ};
+    const char* linkBandStr[] = {"2.4GHz", "5GHz", "6GHz"};
+    // 各リンクに固定する TID（インデックス = リンクID、それ以外の TID は全リンクに対応付け）
+    // 振り分けの効果を EDCA の優先度と切り分けるため、振り分け用 TID はどちらも AC_VI（TID 4, 5）にそろえる。
+    // 1 つの AC には TID が 2 つしかないので、最速リンクに TID 4、残りの 2 リンクの組に TID 5 を固定する
+    // （TID 5 のどちらのリンクで送るかは MAC に任せる）。
+    const std::vector<uint8_t> linkTids = {5, 5, 4};
+    SpectrumWifiPhyHelper mloPhy(nLinks);
+    if (enableMlo) {
+        const FrequencyRange linkRanges[] = {WIFI_SPECTRUM_2_4_GHZ, WIFI_SPECTRUM_5_GHZ, WIFI_SPECTRUM_6_GHZ};
+        for (uint8_t linkId = 0; linkId < nLinks; linkId++) {
+            Ptr<MultiModelSpectrumChannel> spectrumChannel = CreateObject<MultiModelSpectrumChannel>();
+            spectrumChannel->AddPropagationLossModel(CreateObject<LogDistancePropagationLossModel>());
+            spectrumChannel->SetPropagationDelayModel(CreateObject<ConstantSpeedPropagationDelayModel>());
+            mloPhy.AddChannel(spectrumChannel, linkRanges[linkId]);
+        }
+        mloPhy.Set(1, "ChannelSettings", StringValue("{0, 80, BAND_5GHZ, 0}"));
+        mloPhy.Set(2, "ChannelSettings", StringValue("{0, 160, BAND_6GHZ, 0}"));
+        mloPhy.SetErrorRateModel("ns3::YansErrorRateModel");
+
+        // TID-to-Link マッピング: 振り分けなしでは全 TID を全リンクに、振り分けありでは振り分け用 TID を linkTids のリンクに固定
+        // （全リンクが同じ AC_VI を運ぶので、リンク間の差は帯域と混雑だけになる）
+        std::string tidToLink = "0,1,2,3,4,5,6,7 0,1,2";
+        if (steeringPolicy != STEER_NONE) {
+            tidToLink = "0,1,2,3,6,7 0,1,2; 4 2; 5 0,1";
+        }
+        wifi.ConfigEhtOptions("TidToLinkMappingNegSupport",
+                              EnumValue(WifiTidToLinkMappingNegSupport::ANY_LINK_SET),
+                              "TidToLinkMappingDl", StringValue(tidToLink),
+                              "TidToLinkMappingUl", StringValue(tidToLink));
+    }
+
     WifiMacHelper mac;
-    Ssid ssid = Ssid("video-network");
+
+    // DL OFDMA: AP にマルチユーザスケジューラを設定（UL OFDMA は使用しない）
+    if (muScheduler == "rr") {
+        mac.SetMultiUserScheduler("ns3::RrMultiUserScheduler",
+                                  "NStations", UintegerValue(muStations),
+                                  "EnableUlOfdma", BooleanValue(false),
+                                  "EnableBsrp", BooleanValue(false));
+    } else if (muScheduler == "deadline") {
+        mac.SetMultiUserScheduler("ns3::DeadlineMultiUserScheduler",
+                                  "NStations", UintegerValue(muStations),
+                                  "Deadline", TimeValue(deadline));
+    }
 
     // A-MPDUサイズの設定
     uint32_t ampduSize = enableAmpdu ? 65535 : 0;
     uint32_t VO_MaxAmpduSize = enableAmpdu ? 15000000 : 0;
     uint32_t BE_MaxAmpduSize = enableAmpdu ? 15000000 : 0;
 
-    // AP設定
-    mac.SetType("ns3::ApWifiMac",
-                "Ssid", SsidValue(ssid),
-                "BE_MaxAmpduSize", UintegerValue(BE_MaxAmpduSize),
-                "BK_MaxAmpduSize", UintegerValue(ampduSize),
-                "VI_MaxAmpduSize", UintegerValue(ampduSize),
-                "VO_MaxAmpduSize", UintegerValue(VO_MaxAmpduSize));
-    NetDeviceContainer apDevice = wifi.Install(phy, mac, ap.Get(0));
-
-    // STA設定
-    mac.SetType("ns3::StaWifiMac",
-                "Ssid", SsidValue(ssid),
-                "ActiveProbing", BooleanValue(false),
-                "BE_MaxAmpduSize", UintegerValue(BE_MaxAmpduSize),
-                "BK_MaxAmpduSize", UintegerValue(ampduSize),
-                "VI_MaxAmpduSize", UintegerValue(ampduSize),
-                "VO_MaxAmpduSize", UintegerValue(VO_MaxAmpduSize));
-    NetDeviceContainer staDevice = wifi.Install(phy, mac, sta.Get(0));
+    std::vector<uint32_t> bssChannels;
+    std::vector<NetDeviceContainer> apDevices;
+    std::vector<NetDeviceContainer> staDevices;
+    std::vector<NetDeviceContainer> crossDevices;
+    for (uint32_t b = 0; b < numBss; b++) {
+        uint32_t channelNumber = GetBssChannel(channelPlan, b, gridCols);
+        NodeContainer bssStas;
+        for (uint32_t s = 0; s < stasPerBss; s++) {
+            bssStas.Add(sta.Get(b * stasPerBss + s));
+        }
+        NodeContainer bssCrossStas;
+        for (uint32_t s = 0; s < crossStasPerBss; s++) {
+            bssCrossStas.Add(crossSta.Get(b * crossStasPerBss + s));
+        }
+
+        // 再生リンク: BSS ごとに AP と STA を 1 本の再生チャネルでつなぐ
+        if (replayModel) {
+            bssChannels.push_back(channelNumber);
+            Ptr<ReplaySimpleChannel> replayChannel = CreateObject<ReplaySimpleChannel>();
+            replayChannel->SetModel(replayModel);
+            replayChannel->AssignStreams(b);
+            SimpleNetDeviceHelper simple;
+            apDevices.push_back(simple.Install(ap.Get(b), replayChannel));
+            replayChannel->SetAccessPoint(DynamicCast<SimpleNetDevice>(apDevices[b].Get(0)));
+            staDevices.push_back(simple.Install(bssStas, replayChannel));
+            crossDevices.push_back(simple.Install(bssCrossStas, replayChannel));
+            continue;
+        }
+
+        bssChannels.push_back(channelNumber);
+        std::string channelSettings = "{" + std::to_string(channelNumber) + ", 20, BAND_2_4GHZ, 0}";
+        if (numBss == 1 && channelPlan == "same") {
+            channelSettings = "{0, 20, BAND_2_4GHZ, 0}";  // 2.4GHz, 20MHz
+        }
+        phy.Set("ChannelSettings", StringValue(channelSettings));
+        mloPhy.Set(0, "ChannelSettings", StringValue(channelSettings));
+        const WifiPhyHelper& bssPhy = enableMlo ? static_cast<const WifiPhyHelper&>(mloPhy)
+                                                : static_cast<const WifiPhyHelper&>(phy);
+
+        Ssid ssid = (b == 0) ? Ssid("video-network") : Ssid("video-network-" + std::to_string(b));
+
+        // AP設定
+        mac.SetType("ns3::ApWifiMac",
+                    "Ssid", SsidValue(ssid),
+                    "BE_MaxAmpduSize", UintegerValue(BE_MaxAmpduSize),
+                    "BK_MaxAmpduSize", UintegerValue(ampduSize),
+                    "VI_MaxAmpduSize", UintegerValue(ampduSize),
+                    "VO_MaxAmpduSize", UintegerValue(VO_MaxAmpduSize));
+        apDevices.push_back(wifi.Install(bssPhy, mac, ap.Get(b)));
+
+        // STA設定
+        mac.SetType("ns3::StaWifiMac",
+                    "Ssid", SsidValue(ssid),
+                    "ActiveProbing", BooleanValue(false),
+                    "BE_MaxAmpduSize", UintegerValue(BE_MaxAmpduSize),
+                    "BK_MaxAmpduSize", UintegerValue(ampduSize),
+                    "VI_MaxAmpduSize", UintegerValue(ampduSize),
+                    "VO_MaxAmpduSize", UintegerValue(VO_MaxAmpduSize));
+        staDevices.push_back(wifi.Install(bssPhy, mac, bssStas));
+        crossDevices.push_back(wifi.Install(bssPhy, mac, bssCrossStas));
+    }
 
     // モビリティ（位置設定）
     MobilityHelper mobility;
     mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
 
-    // APの位置: 原点
+    // APの位置: 原点を起点とした格子状配置
     Ptr<ListPositionAllocator> apPos = CreateObject<ListPositionAllocator>();
-    apPos->Add(Vector(0.0, 0.0, 0.0));
+    std::vector<Vector> apPositions;
+    for (uint32_t b = 0; b < numBss; b++) {
+        Vector pos((b % gridCols) * bssSpacing, (b / gridCols) * bssSpacing, 0.0);
+        apPositions.push_back(pos);
+        apPos->Add(pos);
+    }
     mobility.SetPositionAllocator(apPos);
     mobility.Install(ap);
 
-    // STAの位置: APからdistanceメートル離れた位置
+    // STAの位置: 各APからdistanceメートル離れた円周上に等間隔で配置
     Ptr<ListPositionAllocator> staPos = CreateObject<ListPositionAllocator>();
-    staPos->Add(Vector(distance, 0.0, 0.0));
+    for (uint32_t b = 0; b < numBss; b++) {
+        for (uint32_t s = 0; s < stasPerBss; s++) {
+            double angle = 2.0 * M_PI * s / stasPerBss;
+            staPos->Add(Vector(apPositions[b].x + distance * std::cos(angle),
+                               apPositions[b].y + distance * std::sin(angle),
+                               0.0));
+        }
+    }
     mobility.SetPositionAllocator(staPos);
     mobility.Install(sta);
 
+    // 追加 STA の位置: 映像 STA の間に同じ距離で配置
+    Ptr<ListPositionAllocator> crossPos = CreateObject<ListPositionAllocator>();
+    for (uint32_t b = 0; b < numBss; b++) {
+        for (uint32_t s = 0; s < crossStasPerBss; s++) {
+            double angle = 2.0 * M_PI * (s + 0.5) / crossStasPerBss;
+            crossPos->Add(Vector(apPositions[b].x + distance * std::cos(angle),
+                                 apPositions[b].y + distance * std::sin(angle),
+                                 0.0));
+        }
+    }
+    mobility.SetPositionAllocator(crossPos);
+    mobility.Install(crossSta);
+
     // IPアドレス設定
     InternetStackHelper stack;
     stack.Install(server);
     stack.Install(ap);
     stack.Install(sta);
+    stack.Install(crossSta);
+
+    // AP の WiFi デバイスに拡張レイヤ破棄キューを設置（AC ごとの mq の子として、アドレス設定前に）
+    TrafficControlHelper layerTch;
+    std::vector<QueueDiscContainer> layerQdiscs;
+    if (layerDrop) {
+        uint16_t handle = layerTch.SetRootQueueDisc("ns3::MqQueueDisc");
+        TrafficControlHelper::ClassIdList cid = layerTch.AddQueueDiscClasses(handle, 4, "ns3::QueueDiscClass");
+        layerTch.AddChildQueueDiscs(handle, cid, "ns3::LayerDropQueueDisc",
+                                    "ShedThreshold", UintegerValue(shedThreshold),
+                                    "LayerStep", UintegerValue(layerStep));
+    }
+    // マルチキャストのユニキャスト変換も同じく AC ごとの mq の子として AP に設置
+    TrafficControlHelper mcastTch;
+    QueueDiscContainer mcastQdiscs;
+    bool mcastConvert = multicast && mcastMode == "convert";
+    if (mcastConvert) {
+        uint16_t handle = mcastTch.SetRootQueueDisc("ns3::MqQueueDisc");
+        TrafficControlHelper::ClassIdList cid = mcastTch.AddQueueDiscClasses(handle, 4, "ns3::QueueDiscClass");
+        mcastTch.AddChildQueueDiscs(handle, cid, "ns3::MulticastConvertQueueDisc");
+    }
+
+    // WAN のボトルネック（サーバー側の送信）にキューディスクを設置（アドレス設定前に）
+    TrafficControlHelper wanTch;
+    std::vector<Ptr<QueueDisc>> wanQdiscs;
+    if (wan) {
+        if (wanQdisc == "fifo") {
+            wanTch.SetRootQueueDisc("ns3::FifoQueueDisc", "MaxSize", StringValue(wanQueue));
+        } else if (wanQdisc == "codel") {
+            wanTch.SetRootQueueDisc("ns3::CoDelQueueDisc", "MaxSize", StringValue(wanQueue),
+                                    "UseEcn", BooleanValue(wanEcn));
+        } else if (wanQdisc == "fqcodel") {
+            wanTch.SetRootQueueDisc("ns3::FqCoDelQueueDisc", "MaxSize", StringValue(wanQueue),
+                                    "UseEcn", BooleanValue(wanEcn), "UseL4s", BooleanValue(wanEcn));
+        } else {
+            wanTch.SetRootQueueDisc("ns3::DualQueueDisc", "MaxSize", StringValue(wanQueue));
+        }
+        for (uint32_t b = 0; b < numBss; b++) {
+            Ptr<QueueDisc> qdisc = wanTch.Install(p2pDevices[b].Get(0)).Get(0);
+            if (Ptr<DualQueueDisc> dualq = DynamicCast<DualQueueDisc>(qdisc)) {
+                dualq->AssignStreams(300 + b);
+            }
+            wanQdiscs.push_back(qdisc);
+        }
+    }
 
     Ipv4AddressHelper address;
+    std::vector<Ipv4InterfaceContainer> staIf;
+    std::vector<Ipv4InterfaceContainer> serverIf;
+    std::vector<Ipv4InterfaceContainer> crossIf;
+    for (uint32_t b = 0; b < numBss; b++) {
+        std::string prefix = "10." + std::to_string(b + 1) + ".";
+
+        // 有線リンク
+        address.SetBase((prefix + "1.0").c_str(), "255.255.255.0");
+        serverIf.push_back(address.Assign(p2pDevices[b]));
+
+        // 無線リンク
+        address.SetBase((prefix + "2.0").c_str(), "255.255.255.0");
+        if (layerDrop) {
+            layerQdiscs.push_back(layerTch.Install(apDevices[b]));
+        }
+        if (mcastConvert) {
+            mcastQdiscs = mcastTch.Install(apDevices[b]);
+        }
+        address.Assign(apDevices[b]);
+        staIf.push_back(address.Assign(staDevices[b]));
+        crossIf.push_back(address.Assign(crossDevices[b]));
+    }
+
+    // エミュレーション用の入口（サーバーに FdNetDevice を追加し、ローカルの RTP を注入）
+    Ptr<RtpIngressBridge> ingress;
+    if (emulation) {
+        ingress = Create<RtpIngressBridge>();
+        ingress->SetIngressPort(rtpInPort);
 
-    // 有線リンク
-    address.SetBase("10.1.1.0", "255.255.255.0");
-    Ipv4InterfaceContainer p2pIf = address.Assign(p2pDevices);
+        FdNetDeviceHelper fdHelper;
+        fdHelper.SetAttribute("RxQueueSize", UintegerValue(10000));
+        NetDeviceContainer fdDevices = fdHelper.Install(server.Get(0));
+        Ptr<FdNetDevice> fdDevice = DynamicCast<FdNetDevice>(fdDevices.Get(0));
+        fdDevice->SetFileDescriptor(ingress->CreateDeviceFd());
 
-    // 無線リンク
-    address.SetBase("10.1.2.0", "255.255.255.0");
-    Ipv4InterfaceContainer apIf = address.Assign(apDevice);
-    Ipv4InterfaceContainer staIf = address.Assign(staDevice);
+        Ptr<Ipv4> serverIpv4 = server.Get(0)->GetObject<Ipv4>();
+        uint32_t ifIndex = serverIpv4->AddInterface(fdDevice);
+        serverIpv4->AddAddress(ifIndex, Ipv4InterfaceAddress("10.254.1.1", "255.255.255.0"));
+        serverIpv4->SetUp(ifIndex);
+
+        // 注入フレームは 10.254.1.2 から STA 宛て（EDCA 有効時は I フレーム相当の AC_VI）
+        ingress->SetFrameAddresses(Mac48Address::ConvertFrom(fdDevice->GetAddress()),
+                                   Ipv4Address("10.254.1.2"), staIf[0].GetAddress(0), 9,
+                                   enableEdca ? 0xa0 : 0x00);
+    }
 
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
+    // マルチキャスト: サーバーはグループ宛てを p2p へ、AP は p2p から WiFi へ転送する静的経路
+    // IP 層では受信ソケットがあるノードが自動的にグループ宛てを受け取るため、STA 側の参加処理は不要
+    const Ipv4Address mcastGroup("225.1.2.3");
+    if (multicast) {
+        Ipv4StaticRoutingHelper multicastRouting;
+        multicastRouting.SetDefaultMulticastRoute(server.Get(0), p2pDevices[0].Get(0));
+        multicastRouting.AddMulticastRoute(ap.Get(0), serverIf[0].GetAddress(0), mcastGroup,
+                                           p2pDevices[0].Get(1), NetDeviceContainer(apDevices[0].Get(0)));
+    }
+    // 変換先は BSS の映像 STA（各 mq の子 = AC ごとの MulticastConvertQueueDisc）
+    if (mcastConvert) {
+        std::vector<Mac48Address> members;
+        for (uint32_t s = 0; s < stasPerBss; s++) {
+            members.push_back(Mac48Address::ConvertFrom(staDevices[0].Get(s)->GetAddress()));
+        }
+        Ptr<QueueDisc> root = mcastQdiscs.Get(0);
+        for (uint32_t c = 0; c < root->GetNQueueDiscClasses(); c++) {
+            DynamicCast<MulticastConvertQueueDisc>(root->GetQueueDiscClass(c)->GetQueueDisc())->SetMembers(members);
+        }
+    }
+
+
+    // ログファイル名の共通部分
+    std::string ampduStr = enableAmpdu ? "on" : "off";
+    std::string edcaStr = enableEdca ? "on" : "off";
+    std::ostringstream runSuffix;
+    runSuffix << "_ampdu_" << ampduStr
+              << "_edca_" << edcaStr
+              << "_d" << static_cast<int>(distance) << "m";
+    if (enableMlo) {
+        runSuffix << "_mlo_" << steering;
+    }
+    if (muScheduler != "none") {
+        runSuffix << "_mu_" << muScheduler;
+    }
+    if (emulation) {
+        runSuffix << "_emu";
+    }
+    if (!bitstream.empty()) {
+        runSuffix << "_bitstream";
+    }
+    // GOP 構造（送信・受信で同じテーブルを共有）。既定の closed IBBP 以外はファイル名に付与
+    Ptr<GopStructure> gopStructure =
+        Create<GopStructure>(GopStructure::ParseMode(gopMode), gopSize, bFrames, openGop);
+    if (bitstream.empty() && (gopMode != "ibbp" || bFrames != 2 || openGop)) {
+        runSuffix << "_gop_" << gopMode << "_b" << bFrames << (openGop ? "_open" : "");
+    }
+    if (svcLayers > 1) {
+        runSuffix << "_svc" << svcLayers;
+    }
+    if (layerDrop) {
+        runSuffix << "_shed";
+    }
+    if (enableCc) {
+        runSuffix << "_cc";
+    }
+    if (replayModel) {
+        runSuffix << "_replay";
+    }
+    if (fps != 30.0) {
+        runSuffix << "_fps" << fps;
+    }
+    if (encoderTiming) {
+        runSuffix << "_enc";
+    }
+    if (slices > 1) {
+        runSuffix << "_slice" << slices;
+    }
+    if (decodeOrder) {
+        runSuffix << "_dec";
+    }
+    if (multicast) {
+        runSuffix << "_mcast_" << mcastMode;
+    }
+    if (twt) {
+        runSuffix << "_twt" << twtInterval << "_" << twtDurationMs << "ms";
+    }
+    if (wan) {
+        runSuffix << "_wan" << wanRateMbps << "M_" << wanDelayMs << "ms_" << wanQdisc << (wanEcn ? "_ecn" : "");
+    }
+    Ptr<CrossTraffic> crossTraffic;
+    if (crossConfig.IsEnabled()) {
+        crossTraffic = Create<CrossTraffic>(crossConfig);
+        runSuffix << crossTraffic->GetSuffix();
+    }
+
+    // アプリケーション設定（STA ごとに 1 本の映像フロー）
+    std::vector<Ptr<VideoFrameReceiverApplication>> receivers;
+    std::vector<std::string> flowSuffixes;
+    // 全フローの統計とパケットログの置き場（複数フローのパケットログは末尾の FlowID 列でフローを区別する 1 ファイル）
+    Ptr<FlowStatsStore> statsStore = Create<FlowStatsStore>();
+    std::string packetLogPath = outputDir + "/packet_log" + runSuffix.str() +
+                                (numFlows > 1 ? "_bss" + std::to_string(numBss) : "") + ".csv";
+    if (!emulation) {
+        statsStore->OpenPacketLog(packetLogPath, numFlows > 1);
+    }
+    Ptr<RtpEgressApplication> egress;
+    if (emulation) {
+        // 映像の生成は外部プロセスが担うため、STA 側で受けたパケットをホストへ返すだけ
+        egress = CreateObject<RtpEgressApplication>();
+        egress->SetPort(9);
+        egress->SetEgressAddress(rtpOutHost, rtpOutPort);
+        sta.Get(0)->AddApplication(egress);
+        egress->SetStartTime(Seconds(0.5));
+        egress->SetStopTime(Seconds(simulationTime));
+    }
+    for (uint32_t b = 0; b < numBss && !emulation; b++) {
+        for (uint32_t s = 0; s < stasPerBss; s++) {
+            uint32_t flow = b * stasPerBss + s;
+            std::string flowSuffix = runSuffix.str();
+            if (numFlows > 1) {
+                flowSuffix += "_bss" + std::to_string(b) + "_sta" + std::to_string(s);
+            }
+            flowSuffixes.push_back(flowSuffix);
+
+            // 受信アプリ（WiFi STA側）
+            Ptr<VideoFrameReceiverApplication> receiver = CreateObject<VideoFrameReceiverApplication>();
+            receiver->SetPort(9);
+            // 統計とパケットログは共有の置き場へ（フローID = flow）
+            receiver->SetStatsStore(statsStore);
+            receiver->SetDeadline(deadline);
+            if (bitstream.empty()) {
+                receiver->SetGopStructure(gopStructure);
+            }
+
+            sta.Get(flow)->AddApplication(receiver);
+            receiver->SetStartTime(Seconds(0.5));
+            receiver->SetStopTime(Seconds(simulationTime));
+            receivers.push_back(receiver);
+            if (encoderTiming) {
+                receiver->SetDecodeTime(encoderTiming->GetDecodeTime());
+            }
+
+            // 送信アプリ（サーバー側）。マルチキャストではグループ宛ての 1 本だけ
+            if (multicast && flow > 0) {
+                continue;
+            }
+            Ptr<VideoFrameSenderApplication> sender = CreateObject<VideoFrameSenderApplication>();
+            sender->SetRemoteAddress(multicast ? mcastGroup : staIf[b].GetAddress(s));  // STAのIPアドレス
+            sender->SetRemotePort(9);
+            sender->SetPacketSize(packetSize);
+            sender->SetGopSize(gopSize);
+            sender->SetFrameInterval(frameInterval);
+            sender->SetSlices(slices);
+            sender->SetDecodeOrder(decodeOrder);
+            if (wan && wanEcn) {
+                sender->SetEcnCodepoint(1);  // ECT(1)
+            }
+            if (encoderTiming) {
+                sender->SetEncoderTiming(encoderTiming);
+            }
+            sender->SetEdcaEnabled(enableEdca);  // EDCA有効/無効
+            sender->SetGopStructure(gopStructure);
+            sender->SetSvcLayers(svcLayers, svcBaseShare);
+            if (enableMlo) {
+                sender->SetLinkSteering(steeringPolicy, linkTids, fastLinkId);
+            }
+            if (!bitstream.empty()) {
+                // packetSize は UDP ペイロード（RTP ヘッダ込み）の上限として扱う
+                Ptr<AnnexBSource> source = Create<AnnexBSource>();
+                NS_ABORT_MSG_IF(!source->Open(bitstream, codec), "Failed to open bitstream: " << bitstream);
+                source->SetMaxPayloadSize(packetSize - AnnexBSource::RTP_HEADER_SIZE);
+                sender->SetBitstreamSource(source);
+            }
+            // 輻輳制御: 受信側で遅延勾配から目標レートを推定し、送信側はそれに合わせてフレームサイズとペーシングを決める
+            if (enableCc) {
+                receiver->EnableCongestionFeedback(
+                    Create<DelayBasedBwe>(ccMinRateMbps * 1e6, ccMaxRateMbps * 1e6, ccStartRateMbps * 1e6),
+                    Seconds(ccFeedbackMs / 1000.0));
+                sender->SetCongestionControl(ccMinRateMbps * 1e6, ccMaxRateMbps * 1e6, ccStartRateMbps * 1e6);
+
+                AsciiTraceHelper ccTraceHelper;
+                Ptr<OutputStreamWrapper> rateStream =
+                    ccTraceHelper.CreateFileStream(outputDir + "/cc_rate" + flowSuffix + ".csv");
+                *rateStream->GetStream() << "Time(s),TargetRate(Mbps)" << std::endl;
+                sender->TraceConnectWithoutContext("TargetRate", MakeBoundCallback(&CcTargetRateTrace, rateStream));
+                Ptr<OutputStreamWrapper> gradientStream =
+                    ccTraceHelper.CreateFileStream(outputDir + "/cc_gradient" + flowSuffix + ".csv");
+                *gradientStream->GetStream() << "Time(s),ModifiedTrend,Threshold,Usage,EstimatedRate(Mbps),CeAlpha" << std::endl;
+                receiver->TraceConnectWithoutContext("DelayGradient",
+                                                     MakeBoundCallback(&CcDelayGradientTrace, gradientStream));
+            }
+            server.Get(0)->AddApplication(sender);
+            sender->SetStartTime(Seconds(3.0));
+            sender->SetStopTime(Seconds(simulationTime));
+        }
+    }
+
+    // 背景負荷（BSS ごとに先頭 STA 宛の UDP 定レート、AC_BE）
+    if (bgLoadMbps > 0.0) {
+        const uint16_t bgPort = 5000;
+        for (uint32_t b = 0; b < numBss; b++) {
+            PacketSinkHelper sink("ns3::UdpSocketFactory",
+                                  InetSocketAddress(Ipv4Address::GetAny(), bgPort));
+            ApplicationContainer sinkApp = sink.Install(sta.Get(b * stasPerBss));
+            sinkApp.Start(Seconds(0.5));
+            sinkApp.Stop(Seconds(simulationTime));
+
+            OnOffHelper onoff("ns3::UdpSocketFactory",
+                              InetSocketAddress(staIf[b].GetAddress(0), bgPort));
+            onoff.SetConstantRate(DataRate(static_cast<uint64_t>(bgLoadMbps * 1e6)), packetSize);
+            ApplicationContainer bgApp = onoff.Install(server.Get(0));
+            bgApp.Start(Seconds(bgStart));
+            bgApp.Stop(Seconds(simulationTime));
+        }
+    }
+
+    // 競合トラフィック（追加 STA との上下 TCP/VoIP/Web）
+    if (crossTraffic) {
+        for (uint32_t b = 0; b < numBss; b++) {
+            NodeContainer bssCrossStas;
+            for (uint32_t s = 0; s < crossStasPerBss; s++) {
+                bssCrossStas.Add(crossSta.Get(b * crossStasPerBss + s));
+            }
+            crossTraffic->InstallBss(b, server.Get(0), serverIf[b].GetAddress(0), bssCrossStas, crossIf[b],
+                                     Seconds(3.0), Seconds(simulationTime));
+        }
+    }
+
+    // QoS ログファイルを開き、PHY 層の受信トレースを接続（先頭 STA 側のみ）
+    // 再生リンクでは Wi-Fi デバイスがなく、モデルの元になった PhyRx.csv を上書きしないよう対象外
+    if (!replayModel) {
+        AsciiTraceHelper asciiTraceHelper;
+        Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream (outputDir + "/PhyRx.csv");
+        *stream->GetStream () << "PhyRxTime,FrameID,FrameType,PacketIndex,TID,AccessCategory,IsAMPDU,AMPDURefNum" << std::endl; //header
+
+        Config::Connect("/NodeList/" + std::to_string(sta.Get(0)->GetId()) +
+                        "/DeviceList/*/$ns3::WifiNetDevice/Phy/$ns3::WifiPhy/MonitorSnifferRx",
+                        MakeBoundCallback(&PhyRxTrace, stream));
+    }
+
+    // BSS ごとの衝突・再送カウンタを接続
+    std::vector<ContentionCounters> bssCounters(numBss);
+    for (uint32_t b = 0; b < numBss && !replayModel; b++) {
+        NodeContainer bssNodes;
+        bssNodes.Add(ap.Get(b));
+        for (uint32_t s = 0; s < stasPerBss; s++) {
+            bssNodes.Add(sta.Get(b * stasPerBss + s));
+        }
+        for (uint32_t n = 0; n < bssNodes.GetN(); n++) {
+            std::string devPath = "/NodeList/" + std::to_string(bssNodes.Get(n)->GetId()) +
+                                  "/DeviceList/*/$ns3::WifiNetDevice";
+            Config::Connect(devPath + "/Phy/PhyRxDrop",
+                            MakeBoundCallback(&PhyRxDropTrace, &bssCounters[b]));
+            Config::Connect(devPath + "/RemoteStationManager/MacTxDataFailed",
+                            MakeBoundCallback(&MacTxDataFailedTrace, &bssCounters[b]));
+            Config::Connect(devPath + "/RemoteStationManager/MacTxFinalDataFailed",
+                            MakeBoundCallback(&MacTxFinalDataFailedTrace, &bssCounters[b]));
+        }
+    }
+
+    // AP の AC キュー長の最大値（I フレームのバーストとイントラリフレッシュの比較用）
+    std::vector<std::vector<uint32_t>> bssPeakQueue(numBss, std::vector<uint32_t>(4, 0));
+    for (uint32_t b = 0; b < numBss && !replayModel; b++) {
+        Ptr<WifiMac> apMac = DynamicCast<WifiNetDevice>(apDevices[b].Get(0))->GetMac();
+        for (AcIndex ac : {AC_BE, AC_BK, AC_VI, AC_VO}) {
+            apMac->GetTxopQueue(ac)->GetWifiMacQueue()->TraceConnectWithoutContext(
+                "PacketsInQueue", MakeBoundCallback(&QueueDepthTrace, &bssPeakQueue[b][ac]));
+        }
+    }
+
+    // MLO: リンク単位のエアタイム（全ノードの送信）と先頭 STA の受信遅延
+    std::vector<LinkStats> linkStats(enableMlo ? nLinks : 0);
+    if (enableMlo) {
+        NodeContainer wifiNodes(ap, sta);
+        for (uint8_t linkId = 0; linkId < nLinks; linkId++) {
+            for (uint32_t n = 0; n < wifiNodes.GetN(); n++) {
+                Config::Connect("/NodeList/" + std::to_string(wifiNodes.Get(n)->GetId()) +
+                                "/DeviceList/*/$ns3::WifiNetDevice/Phys/" + std::to_string(linkId) +
+                                "/PhyTxPsduBegin",
+                                MakeBoundCallback(&LinkTxAirtimeTrace, &linkStats[linkId], linkBands[linkId]));
+            }
+            Config::Connect("/NodeList/" + std::to_string(sta.Get(0)->GetId()) +
+                            "/DeviceList/*/$ns3::WifiNetDevice/Phys/" + std::to_string(linkId) +
+                            "/MonitorSnifferRx",
+                            MakeBoundCallback(&LinkRxTrace, &linkStats[linkId]));
+        }
+    }
+
+    // 送信側の最初のフレームの送信時刻（開始 10 ms 後、デコード順では並べ替え深さ分遅れる）
+    Time firstFrame = Seconds(3.0) + MilliSeconds(10);
+    if (decodeOrder && bitstream.empty()) {
+        firstFrame += frameInterval * gopStructure->GetReorderDepth();
+    }
+
+    // TWT: 送信側のフレーム生成から twtOffset 後に SP を開始
+    Ptr<TwtScheduler> twtScheduler;
+    if (twt) {
+        twtScheduler = Create<TwtScheduler>(frameInterval * twtInterval,
+                                            MicroSeconds(static_cast<int64_t>(twtDurationMs * 1000)),
+                                            MicroSeconds(static_cast<int64_t>(twtGuardMs * 1000)));
+        for (uint32_t b = 0; b < numBss; b++) {
+            for (uint32_t s = 0; s < stasPerBss; s++) {
+                twtScheduler->AddStation(DynamicCast<WifiNetDevice>(apDevices[b].Get(0)),
+                                         DynamicCast<WifiNetDevice>(staDevices[b].Get(s)));
+            }
+        }
+        twtScheduler->Start(firstFrame + MicroSeconds(static_cast<int64_t>(twtOffsetMs * 1000)),
+                            Seconds(simulationTime));
+    }
+
+    // 映像 STA の PHY 状態ごとの滞在時間（起床時間と消費エネルギー、TWT 有効時のみ）
+    // 集計は simulationTime まで。評価区間は最初の SP から simulationTime まで
+    std::vector<RadioStateStats> staRadio(twtScheduler ? numFlows : 0);
+    for (uint32_t flow = 0; flow < staRadio.size(); flow++) {
+        Ptr<WifiNetDevice> staDevice = DynamicCast<WifiNetDevice>(staDevices[flow / stasPerBss].Get(flow % stasPerBss));
+        staRadio[flow].windowStart = (firstFrame + MicroSeconds(static_cast<int64_t>(twtOffsetMs * 1000))).GetSeconds();
+        staRadio[flow].stop = simulationTime;
+        staDevice->GetPhy()->GetState()->TraceConnect("State", "",
+                                                      MakeBoundCallback(&PhyStateTrace, &staRadio[flow]));
+        Simulator::Schedule(Seconds(simulationTime), &FlushRadioState, &staRadio[flow], staDevice->GetPhy());
+    }
+
+    // WAN 区間: ボトルネックのキュー長の最大値と下りの損失
+    std::vector<uint32_t> wanPeakQueue(wanQdiscs.size(), 0);
+    std::vector<uint64_t> wanLinkLosses(wanQdiscs.size(), 0);
+    for (uint32_t b = 0; b < wanQdiscs.size(); b++) {
+        wanQdiscs[b]->TraceConnectWithoutContext("PacketsInQueue",
+                                                 MakeBoundCallback(&QueueDepthTrace, &wanPeakQueue[b]));
+        p2pDevices[b].Get(1)->TraceConnectWithoutContext("PhyRxDrop",
+                                                         MakeBoundCallback(&PacketCountTrace, &wanLinkLosses[b]));
+    }
+
+    // マルチキャスト: BSS 全体のエアタイム（AP と映像 STA の送信。ACK・BlockAck を含む）
+    LinkStats mcastAirtime;
+    if (multicast) {
+        NodeContainer wifiNodes(ap, sta);
+        for (uint32_t n = 0; n < wifiNodes.GetN(); n++) {
+            Config::Connect("/NodeList/" + std::to_string(wifiNodes.Get(n)->GetId()) +
+                            "/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxPsduBegin",
+                            MakeBoundCallback(&LinkTxAirtimeTrace, &mcastAirtime, WIFI_PHY_BAND_2_4GHZ));
+        }
+    }
 
-    // アプリケーション設定
-    // 受信アプリ（WiFi STA側）
-    Ptr<VideoFrameReceiverApplication> receiver = CreateObject<VideoFrameReceiverApplication>();
-    receiver->SetPort(9);
-
-    // パケットログファイル設定
-    std::string ampduStrLog = enableAmpdu ? "on" : "off";
-    std::string edcaStrLog = enableEdca ? "on" : "off";
-    std::ostringstream packetLogPath;
-    packetLogPath << outputDir << "/packet_log_ampdu_" << ampduStrLog
-                  << "_edca_" << edcaStrLog
-                  << "_d" << static_cast<int>(distance) << "m.csv";
-    receiver->SetPacketLogFile(packetLogPath.str());
-
-    sta.Get(0)->AddApplication(receiver);
-    receiver->SetStartTime(Seconds(0.5));
-    receiver->SetStopTime(Seconds(simulationTime));
-
-    // 送信アプリ（サーバー側）
-    Ptr<VideoFrameSenderApplication> sender = CreateObject<VideoFrameSenderApplication>();
-    sender->SetRemoteAddress(staIf.GetAddress(0));  // STAのIPアドレス
-    sender->SetRemotePort(9);
-    sender->SetPacketSize(packetSize);
-    sender->SetGopSize(gopSize);
-    sender->SetFrameInterval(Seconds(0.033));  // 30fps
-    sender->SetEdcaEnabled(enableEdca);  // EDCA有効/無効
-    server.Get(0)->AddApplication(sender);
-    sender->SetStartTime(Seconds(3.0));
-    sender->SetStopTime(Seconds(simulationTime));
-
-    // QoS ログファイルを開く
-    std::string ampduStrQos = enableAmpdu ? "on" : "off";
-    std::string edcaStrQos = enableEdca ? "on" : "off";
-    std::ostringstream qosLogPath;
-    qosLogPath << outputDir << "/qos_log_ampdu_" << ampduStrQos
-              << "_edca_" << edcaStrQos
-              << "_d" << static_cast<int>(distance) << "m.csv";
-
-
-    AsciiTraceHelper asciiTraceHelper;
-    Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream (outputDir + "/PhyRx.csv");
-    *stream->GetStream () << "PhyRxTime,FrameID,FrameType,PacketIndex,TID,AccessCategory,IsAMPDU,AMPDURefNum" << std::endl; //header
-
-
-    // PHY 層の受信トレースを接続（STA 側のみ）
-    Config::Connect("/NodeList/" + std::to_string(sta.Get(0)->GetId()) +
-                    "/DeviceList/*/$ns3::WifiNetDevice/Phy/$ns3::WifiPhy/MonitorSnifferRx",
-                    MakeBoundCallback(&PhyRxTrace, stream));
+    // A-MPDU 集約統計（AP の送信を BSS ごとに集約、全リンクの PHY が対象）
+    std::vector<AmpduAggregator> ampduAggregators(ampduStats ? numBss : 0);
+    for (uint32_t b = 0; b < ampduAggregators.size(); b++) {
+        Config::Connect("/NodeList/" + std::to_string(ap.Get(b)->GetId()) +
+                        "/DeviceList/*/$ns3::WifiNetDevice/Phys/*/MonitorSnifferTx",
+                        MakeBoundCallback(&AmpduTxTrace, &ampduAggregators[b]));
+    }
+
+    // 先頭フローの区間別遅延（サーバー p2p → AP キュー → PHY 送信 → STA 受信 → アプリ）
+    Ptr<LatencyBreakdown> latencyTracker;
+    if (latencyBreakdown && !receivers.empty()) {
+        latencyTracker = Create<LatencyBreakdown>();
+        latencyTracker->Install(p2pDevices[0].Get(0), p2pDevices[0].Get(1),
+                                DynamicCast<WifiNetDevice>(apDevices[0].Get(0)),
+                                DynamicCast<WifiNetDevice>(staDevices[0].Get(0)),
+                                receivers[0], staIf[0].GetAddress(0));
+    }
+
+    // ライブメトリクス（フロー単位の区間集計と AP キュー長を一定間隔で公開）
+    Ptr<LiveMetricsSampler> metricsSampler;
+    if (metricsIntervalMs > 0.0 && !receivers.empty()) {
+        metricsSampler = Create<LiveMetricsSampler>();
+        NS_ABORT_MSG_IF(!metricsSampler->Open(metricsSink, metricsRingSize),
+                        "Failed to open metrics sink: " << metricsSink);
+        for (uint32_t flow = 0; flow < receivers.size(); flow++) {
+            receivers[flow]->EnableLiveMetrics(firstFrame, frameInterval);
+            metricsSampler->AddFlow(flow / stasPerBss, flow % stasPerBss, receivers[flow]);
+        }
+        for (uint32_t b = 0; b < numBss; b++) {
+            Ptr<WifiMac> apMac = DynamicCast<WifiNetDevice>(apDevices[b].Get(0))->GetMac();
+            std::vector<Ptr<WifiMacQueue>> queues;
+            for (AcIndex ac : {AC_BE, AC_BK, AC_VI, AC_VO}) {
+                queues.push_back(apMac->GetTxopQueue(ac)->GetWifiMacQueue());
+            }
+            metricsSampler->SetBssQueues(b, queues);
+        }
+        // 送信開始から 1 秒経過したフレームのロスを確定
+        metricsSampler->Start(MicroSeconds(static_cast<int64_t>(metricsIntervalMs * 1000)), Seconds(1.0));
+    }
 
     // Flow Monitor設定
     FlowMonitorHelper flowmon;
     Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
-    // シミュレーション実行
+    // シミュレーション実行（実時間も計測）
     Simulator::Stop(Seconds(simulationTime + 1.0));
+    Ptr<RealtimeLagMonitor> lagMonitor;
+    if (emulation) {
+        ingress->Start();
+        lagMonitor = Create<RealtimeLagMonitor>();
+        lagMonitor->Start(MilliSeconds(1), MicroSeconds(static_cast<int64_t>(lagToleranceMs * 1000)));
+    }
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    if (emulation) {
+        ingress->Stop();
+    }
+    statsStore->ClosePacketLog();
+    double wallClock = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    uint64_t eventCount = Simulator::GetEventCount();
+    if (metricsSampler) {
+        std::cout << "Live metrics: " << metricsSampler->GetPublished() << " records published, "
+                  << metricsSampler->GetDropped() << " dropped (" << metricsSink << ")" << std::endl;
+        metricsSampler->Close();
+    }
 
     // Flow Monitor統計出力
     monitor->CheckForLostPackets();
@@ -209,15 +1087,380 @@ int main(int argc, char *argv[]) {
     std::cout << "Total Tx: " << totalPackets << ", Total Rx: " << totalRxPackets << std::endl;
     std::cout << "============================\n" << std::endl;
 
-    // 結果出力
-    std::string ampduStr = enableAmpdu ? "on" : "off";
-    std::string edcaStr = enableEdca ? "on" : "off";
-    std::ostringstream csvPath;
-    csvPath << outputDir << "/stats_ampdu_" << ampduStr
-            << "_edca_" << edcaStr
-            << "_d" << static_cast<int>(distance) << "m.csv";
+    // 結果出力（エミュレーション時は映像受信アプリがないので対象外）
+    for (uint32_t flow = 0; flow < receivers.size(); flow++) {
+        receivers[flow]->SaveStatisticsToFile(outputDir + "/stats" + flowSuffixes[flow] + ".csv");
+        if (gopQuality) {
+            receivers[flow]->SaveGopQualityToFile(outputDir + "/gop_quality" + flowSuffixes[flow] + ".csv");
+        }
+        if (encoderTiming || slices > 1 || decodeOrder) {
+            receivers[flow]->SaveGlassToGlassToFile(outputDir + "/glass_to_glass" + flowSuffixes[flow] + ".csv");
+        }
+    }
+
+    // BSS 単位の集計（複数 BSS または複数 STA の場合）
+    if (numFlows > 1) {
+        std::string bssSummaryPath = outputDir + "/bss_summary" + runSuffix.str() +
+                                     "_bss" + std::to_string(numBss) + ".csv";
+        std::ofstream bssOut(bssSummaryPath);
+        bssOut << "BSS,Channel,STAs,Frames,CompleteFrames,OnTimeRatio(%),MeanLatency(ms),"
+               << "P95Latency(ms),P99Latency(ms),PhyRxDrops,TxRetries,TxFinalFailures" << std::endl;
+        for (uint32_t b = 0; b < numBss; b++) {
+            uint32_t frames = 0;
+            uint32_t completeFrames = 0;
+            uint32_t onTimeFrames = 0;
+            double latencySum = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+            for (uint32_t s = 0; s < stasPerBss; s++) {
+                VideoFlowSummary summary = receivers[b * stasPerBss + s]->GetFlowSummary();
+                frames += summary.frames;
+                completeFrames += summary.completeFrames;
+                onTimeFrames += summary.onTimeFrames;
+                latencySum += summary.meanLatency * summary.frames;
+                // BSS 内で最も悪い STA のパーセンタイルを採用
+                p95 = std::max(p95, summary.p95Latency);
+                p99 = std::max(p99, summary.p99Latency);
+            }
+            bssOut << b << ","
+                   << bssChannels[b] << ","
+                   << stasPerBss << ","
+                   << frames << ","
+                   << completeFrames << ","
+                   << std::fixed << std::setprecision(1)
+                   << (frames > 0 ? onTimeFrames * 100.0 / frames : 0.0) << ","
+                   << std::fixed << std::setprecision(2)
+                   << (frames > 0 ? latencySum / frames : 0.0) << ","
+                   << p95 << ","
+                   << p99 << ","
+                   << bssCounters[b].phyRxDrops << ","
+                   << bssCounters[b].txRetries << ","
+                   << bssCounters[b].txFinalFailures << std::endl;
+        }
+        bssOut.close();
+        std::cout << "BSS summary saved to: " << bssSummaryPath << std::endl;
+
+        // STA 単位の集計（スケジューラ比較用）
+        std::string staSummaryPath = outputDir + "/sta_summary" + runSuffix.str() +
+                                     "_bss" + std::to_string(numBss) + ".csv";
+        std::ofstream staOut(staSummaryPath);
+        staOut << "BSS,STA,Frames,CompleteFrames,OnTimeRatio(%),MeanLatency(ms),P95Latency(ms),P99Latency(ms),"
+               << "MeanPSNR(dB),MeanSSIM" << std::endl;
+        for (uint32_t flow = 0; flow < numFlows; flow++) {
+            VideoFlowSummary summary = receivers[flow]->GetFlowSummary();
+            staOut << flow / stasPerBss << ","
+                   << flow % stasPerBss << ","
+                   << summary.frames << ","
+                   << summary.completeFrames << ","
+                   << std::fixed << std::setprecision(1)
+                   << (summary.frames > 0 ? summary.onTimeFrames * 100.0 / summary.frames : 0.0) << ","
+                   << std::fixed << std::setprecision(2) << summary.meanLatency << ","
+                   << summary.p95Latency << ","
+                   << summary.p99Latency << ","
+                   << summary.meanPsnr << ","
+                   << std::fixed << std::setprecision(4) << summary.meanSsim << std::endl;
+        }
+        staOut.close();
+        std::cout << "STA summary saved to: " << staSummaryPath << std::endl;
+
+        // フロー単位の受信カウンタ（FlowID はパケットログの FlowID 列と同じ）
+        std::string flowTablePath = outputDir + "/flow_table" + runSuffix.str() +
+                                    "_bss" + std::to_string(numBss) + ".csv";
+        statsStore->WriteFlowTable(flowTablePath);
+        std::cout << "Flow table saved to: " << flowTablePath << std::endl;
+    }
 
-    receiver->SaveStatisticsToFile(csvPath.str());
+    // BSS 単位の AP キュー長の最大値と、BSS 内で最も悪い STA の p99 フレーム遅延
+    if (queuePeak && !replayModel && !receivers.empty()) {
+        std::string queuePath = outputDir + "/queue_peak" + runSuffix.str() + ".csv";
+        std::ofstream queueOut(queuePath);
+        queueOut << "BSS,PeakBE,PeakBK,PeakVI,PeakVO,PeakMax,P99Latency(ms)" << std::endl;
+        for (uint32_t b = 0; b < numBss; b++) {
+            double p99 = 0.0;
+            for (uint32_t s = 0; s < stasPerBss; s++) {
+                p99 = std::max(p99, receivers[b * stasPerBss + s]->GetFlowSummary().p99Latency);
+            }
+            uint32_t peakMax = 0;
+            queueOut << b << ",";
+            for (uint32_t ac = 0; ac < 4; ac++) {
+                queueOut << bssPeakQueue[b][ac] << ",";
+                peakMax = std::max(peakMax, bssPeakQueue[b][ac]);
+            }
+            queueOut << peakMax << ","
+                     << std::fixed << std::setprecision(2) << p99 << std::endl;
+        }
+        queueOut.close();
+        std::cout << "AP queue peaks saved to: " << queuePath << std::endl;
+    }
+
+    // STA ごとの起床時間・消費エネルギーとフレーム遅延（TWT の省電力と遅延のトレードオフ）
+    if (!staRadio.empty() && !receivers.empty()) {
+        std::string powerPath = outputDir + "/sta_power" + runSuffix.str() + ".csv";
+        std::ofstream powerOut(powerPath);
+        powerOut << "BSS,STA,Awake(s),Sleep(s),AwakeRatio(%),Energy(J),MeanPower(mW),"
+                 << "SpAwake(s),SpSleep(s),SpAwakeRatio(%),SpEnergy(J),SpMeanPower(mW),"
+                 << "OnTimeRatio(%),MeanLatency(ms),P99Latency(ms)" << std::endl;
+        for (uint32_t flow = 0; flow < numFlows; flow++) {
+            const RadioStateStats& radio = staRadio[flow];
+            VideoFlowSummary summary = receivers[flow]->GetFlowSummary();
+            powerOut << flow / stasPerBss << ","
+                     << flow % stasPerBss;
+            // 全体 [0, simulationTime] と最初の SP 以降 [first SP, simulationTime]
+            for (bool window : {false, true}) {
+                double total = radio.GetAwakeTime(window) + radio.GetSleepTime(window);
+                powerOut << "," << std::fixed << std::setprecision(4) << radio.GetAwakeTime(window) << ","
+                         << radio.GetSleepTime(window) << ","
+                         << std::fixed << std::setprecision(1)
+                         << (total > 0.0 ? radio.GetAwakeTime(window) * 100.0 / total : 0.0) << ","
+                         << std::fixed << std::setprecision(4) << radio.GetEnergy(window) << ","
+                         << std::fixed << std::setprecision(2)
+                         << (total > 0.0 ? radio.GetEnergy(window) * 1000.0 / total : 0.0);
+            }
+            powerOut << "," << std::fixed << std::setprecision(1)
+                     << (summary.frames > 0 ? summary.onTimeFrames * 100.0 / summary.frames : 0.0) << ","
+                     << std::fixed << std::setprecision(2) << summary.meanLatency << ","
+                     << summary.p99Latency << std::endl;
+        }
+        powerOut.close();
+        std::cout << "STA power statistics saved to: " << powerPath << std::endl;
+    }
+
+    // WAN 区間: BSS ごとのボトルネックのキュー統計と、BSS 内で最も悪い STA の p99 フレーム遅延
+    if (wan) {
+        std::string wanPath = outputDir + "/wan_summary" + runSuffix.str() + ".csv";
+        std::ofstream wanOut(wanPath);
+        wanOut << "BSS,Qdisc,Received,Dropped,Marked,PeakBacklog(p),LinkLosses,P99Latency(ms)" << std::endl;
+        for (uint32_t b = 0; b < numBss; b++) {
+            const QueueDisc::Stats& stats = wanQdiscs[b]->GetStats();
+            double p99 = 0.0;
+            for (uint32_t s = 0; s < stasPerBss && !receivers.empty(); s++) {
+                p99 = std::max(p99, receivers[b * stasPerBss + s]->GetFlowSummary().p99Latency);
+            }
+            wanOut << b << ","
+                   << wanQdisc << ","
+                   << stats.nTotalReceivedPackets << ","
+                   << stats.nTotalDroppedPackets << ","
+                   << stats.nTotalMarkedPackets << ","
+                   << wanPeakQueue[b] << ","
+                   << wanLinkLosses[b] << ","
+                   << std::fixed << std::setprecision(2) << p99 << std::endl;
+        }
+        wanOut.close();
+        std::cout << "WAN statistics saved to: " << wanPath << std::endl;
+    }
+
+    // マルチキャスト: 配信方式ごとのエアタイムと、STA 全体の定時到着率・最悪 STA の p99 遅延
+    // STA ごとの内訳は sta_summary（複数 STA の場合）
+    if (multicast) {
+        uint64_t convertedPackets = 0;
+        uint64_t unicastCopies = 0;
+        if (mcastConvert) {
+            Ptr<QueueDisc> root = mcastQdiscs.Get(0);
+            for (uint32_t c = 0; c < root->GetNQueueDiscClasses(); c++) {
+                Ptr<MulticastConvertQueueDisc> qd =
+                    DynamicCast<MulticastConvertQueueDisc>(root->GetQueueDiscClass(c)->GetQueueDisc());
+                convertedPackets += qd->GetConvertedPackets();
+                unicastCopies += qd->GetUnicastCopies();
+            }
+        }
+        double onTimeSum = 0.0;
+        double worstP99 = 0.0;
+        for (auto& receiver : receivers) {
+            VideoFlowSummary summary = receiver->GetFlowSummary();
+            onTimeSum += summary.frames > 0 ? summary.onTimeFrames * 100.0 / summary.frames : 0.0;
+            worstP99 = std::max(worstP99, summary.p99Latency);
+        }
+        double activeTime = simulationTime - 3.0;  // 送信開始 (3 s) 以降
+        std::string mcastPath = outputDir + "/multicast_summary" + runSuffix.str() + ".csv";
+        std::ofstream mcastOut(mcastPath);
+        mcastOut << "Mode,STAs,Airtime(s),AirtimeShare(%),PSDUs,ConvertedPackets,UnicastCopies,"
+                 << "MeanOnTimeRatio(%),WorstP99Latency(ms)" << std::endl;
+        mcastOut << mcastMode << ","
+                 << stasPerBss << ","
+                 << std::fixed << std::setprecision(4) << mcastAirtime.airtime << ","
+                 << std::fixed << std::setprecision(1)
+                 << (activeTime > 0.0 ? mcastAirtime.airtime * 100.0 / activeTime : 0.0) << ","
+                 << mcastAirtime.psdus << ","
+                 << convertedPackets << ","
+                 << unicastCopies << ","
+                 << (receivers.empty() ? 0.0 : onTimeSum / receivers.size()) << ","
+                 << std::fixed << std::setprecision(2) << worstP99 << std::endl;
+        mcastOut.close();
+        std::cout << "Multicast summary saved to: " << mcastPath << std::endl;
+    }
+
+    // MLO リンク単位の集計
+    if (enableMlo) {
+        std::string linkPath = outputDir + "/mlo_links" + runSuffix.str() + ".csv";
+        std::ofstream linkOut(linkPath);
+        // 振り分け用 TID はすべて AC_VI（リンクの設定を確認できるよう、リンクごとの TID と AC も出力する）
+        const char* tidAc[] = {"AC_BE", "AC_BK", "AC_BK", "AC_BE", "AC_VI", "AC_VI", "AC_VO", "AC_VO"};
+        linkOut << "LinkID,Band,SteeringTID,SteeringAC,Airtime(s),AirtimeShare(%),PSDUs,RxMpdus,VideoPackets,"
+                << "MeanLatency(ms),P50Latency(ms),P99Latency(ms)" << std::endl;
+        double totalAirtime = 0.0;
+        for (auto& link : linkStats) {
+            totalAirtime += link.airtime;
+        }
+        for (uint8_t linkId = 0; linkId < nLinks; linkId++) {
+            LinkStats& link = linkStats[linkId];
+            double mean = 0.0;
+            double p50 = 0.0;
+            double p99 = 0.0;
+            if (!link.latencies.empty()) {
+                for (double latency : link.latencies) {
+                    mean += latency;
+                }
+                mean /= link.latencies.size();
+                std::sort(link.latencies.begin(), link.latencies.end());
+                p50 = link.latencies[static_cast<size_t>(0.50 * (link.latencies.size() - 1))];
+                p99 = link.latencies[static_cast<size_t>(0.99 * (link.latencies.size() - 1))];
+            }
+            linkOut << static_cast<int>(linkId) << ","
+                    << linkBandStr[linkId] << ","
+                    << (steeringPolicy != STEER_NONE ? std::to_string(linkTids[linkId]) : "-") << ","
+                    << (steeringPolicy != STEER_NONE ? tidAc[linkTids[linkId]] : "-") << ","
+                    << std::fixed << std::setprecision(4) << link.airtime << ","
+                    << std::fixed << std::setprecision(1)
+                    << (totalAirtime > 0.0 ? link.airtime * 100.0 / totalAirtime : 0.0) << ","
+                    << link.psdus << ","
+                    << link.rxMpdus << ","
+                    << link.videoPackets << ","
+                    << std::fixed << std::setprecision(2) << mean << ","
+                    << p50 << ","
+                    << p99 << std::endl;
+        }
+        linkOut.close();
+        std::cout << "MLO link statistics saved to: " << linkPath << std::endl;
+    }
+
+    // A-MPDU 集約統計（全 BSS の合計）
+    if (ampduStats) {
+        AmpduAggregator& total = ampduAggregators[0];
+        total.Flush();
+        for (uint32_t b = 1; b < numBss; b++) {
+            ampduAggregators[b].Flush();
+            total.Merge(ampduAggregators[b]);
+        }
+        std::string ampduPath = outputDir + "/ampdu_summary" + runSuffix.str() + ".csv";
+        total.WriteSummary(ampduPath);
+        std::cout << "A-MPDU statistics saved to: " << ampduPath << std::endl;
+        if (ampduHistogram) {
+            std::string histPath = outputDir + "/ampdu_hist" + runSuffix.str() + ".csv";
+            total.WriteHistograms(histPath);
+            std::cout << "A-MPDU histograms saved to: " << histPath << std::endl;
+        }
+    }
+
+    // 区間別遅延（フレームタイプ別の集計とパケット単位）
+    if (latencyTracker) {
+        std::string stagePath = outputDir + "/latency_stages" + flowSuffixes[0] + ".csv";
+        std::string hopPath = outputDir + "/latency_packets" + flowSuffixes[0] + ".csv";
+        latencyTracker->WriteSummary(stagePath);
+        latencyTracker->WritePackets(hopPath);
+        latencyTracker->PrintSummary(std::cout);
+        std::cout << "Latency breakdown saved to: " << stagePath << ", " << hopPath << std::endl;
+    }
+
+    // 競合トラフィックの種別ごとの受信量
+    if (crossTraffic) {
+        std::string crossPath = outputDir + "/cross_traffic" + runSuffix.str() + ".csv";
+        crossTraffic->WriteReport(crossPath, simulationTime - 3.0);
+        std::cout << "Cross traffic statistics saved to: " << crossPath << std::endl;
+    }
+
+    // 再生リンク: 条件別のモデルと、元の全スタック実行に対する先頭フローの再現度
+    if (replayModel) {
+        std::string modelPath = outputDir + "/replay_model" + runSuffix.str() + ".csv";
+        replayModel->WriteModel(modelPath);
+        if (!receivers.empty()) {
+            std::string validationPath = outputDir + "/replay_validation" + runSuffix.str() + ".csv";
+            ReplayLinkModel::WriteValidation(replayLog, packetLogPath,
+                                             validationPath, deadlineMs);
+            std::cout << "Replay validation saved to: " << validationPath << std::endl;
+        }
+        std::cout << "Replay model (" << replayModel->GetTrainingPackets() << " packets) saved to: "
+                  << modelPath << std::endl;
+    }
+
+    // AP キューでの拡張レイヤ破棄数（BSS・レイヤ単位、AC キューの合計）
+    if (layerDrop) {
+        std::string shedPath = outputDir + "/layer_shed" + runSuffix.str() + ".csv";
+        std::ofstream shedOut(shedPath);
+        shedOut << "BSS,Layer,ShedPackets" << std::endl;
+        for (uint32_t b = 0; b < numBss; b++) {
+            std::vector<uint64_t> shed;
+            Ptr<QueueDisc> root = layerQdiscs[b].Get(0);
+            for (std::size_t i = 0; i < root->GetNQueueDiscClasses(); i++) {
+                Ptr<LayerDropQueueDisc> child =
+                    DynamicCast<LayerDropQueueDisc>(root->GetQueueDiscClass(i)->GetQueueDisc());
+                if (!child) {
+                    continue;
+                }
+                const std::vector<uint64_t>& childShed = child->GetShedPackets();
+                if (shed.size() < childShed.size()) {
+                    shed.resize(childShed.size(), 0);
+                }
+                for (size_t l = 0; l < childShed.size(); l++) {
+                    shed[l] += childShed[l];
+                }
+            }
+            for (size_t l = 1; l < std::max<size_t>(shed.size(), svcLayers); l++) {
+                shedOut << b << "," << l << "," << (l < shed.size() ? shed[l] : 0) << std::endl;
+            }
+        }
+        shedOut.close();
+        std::cout << "Layer shed statistics saved to: " << shedPath << std::endl;
+    }
+
+    // エミュレーション結果（ブリッジの入出力とリアルタイム追従性）
+    if (emulation) {
+        std::string emuPath = outputDir + "/emu_report" + runSuffix.str() + ".csv";
+        std::ofstream emuOut(emuPath);
+        emuOut << "IngressDatagrams,IngressBytes,IngressDrops,EgressPackets,EgressBytes,EgressDrops,"
+               << "RtpLost,RtpReordered,LagProbes,MissedDeadlines,MaxLag(ms),MeanLag(ms)" << std::endl;
+        emuOut << ingress->GetRxDatagrams() << ","
+               << ingress->GetRxBytes() << ","
+               << ingress->GetDroppedDatagrams() << ","
+               << egress->GetRxPackets() << ","
+               << egress->GetRxBytes() << ","
+               << egress->GetEgressDrops() << ","
+               << egress->GetRtpLost() << ","
+               << egress->GetRtpReordered() << ","
+               << lagMonitor->GetProbes() << ","
+               << lagMonitor->GetMissedDeadlines() << ","
+               << std::fixed << std::setprecision(3) << lagMonitor->GetMaxLag().GetSeconds() * 1000.0 << ","
+               << lagMonitor->GetMeanLag().GetSeconds() * 1000.0 << std::endl;
+        emuOut.close();
+
+        std::cout << "\n=== Emulation Report ===" << std::endl;
+        std::cout << "Ingress: " << ingress->GetRxDatagrams() << " datagrams ("
+                  << ingress->GetDroppedDatagrams() << " dropped)" << std::endl;
+        std::cout << "Egress: " << egress->GetRxPackets() << " packets ("
+                  << egress->GetEgressDrops() << " dropped), RTP lost "
+                  << egress->GetRtpLost() << ", reordered " << egress->GetRtpReordered() << std::endl;
+        std::cout << "Missed Deadlines: " << lagMonitor->GetMissedDeadlines() << " / "
+                  << lagMonitor->GetProbes() << " probes, Max Lag: "
+                  << lagMonitor->GetMaxLag().GetSeconds() * 1000.0 << " ms" << std::endl;
+        std::cout << "Emulation report saved to: " << emuPath << std::endl;
+    }
+
+    // BSS 数に対する実行時間のスケーリングを追記（複数 BSS の場合のみ）
+    if (numBss > 1) {
+        std::string scalingPath = outputDir + "/bss_scaling.csv";
+        bool writeHeader = !std::ifstream(scalingPath).good();
+        std::ofstream scalingOut(scalingPath, std::ios::app);
+        if (writeHeader) {
+            scalingOut << "NumBss,StasPerBss,ChannelPlan,SimTime(s),WallClock(s),Events,EventsPerSec" << std::endl;
+        }
+        scalingOut << numBss << ","
+                   << stasPerBss << ","
+                   << channelPlan << ","
+                   << simulationTime << ","
+                   << std::fixed << std::setprecision(3) << wallClock << ","
+                   << eventCount << ","
+                   << std::fixed << std::setprecision(0) << (wallClock > 0.0 ? eventCount / wallClock : 0.0)
+                   << std::endl;
+    }
 
     // 設定を表示
     std::cout << "\n=== Simulation Configuration ===" << std::endl;
@@ -225,8 +1468,56 @@ int main(int argc, char *argv[]) {
     std::cout << "EDCA: " << (enableEdca ? "ON" : "OFF") << std::endl;
     std::cout << "Packet Size: " << packetSize << " bytes" << std::endl;
     std::cout << "GOP Size: " << gopSize << std::endl;
+    std::cout << "GOP Structure: " << gopStructure->GetDescription()
+              << ", reorder depth " << gopStructure->GetReorderDepth() << std::endl;
     std::cout << "Distance: " << distance << " m" << std::endl;
     std::cout << "Simulation Time: " << simulationTime << " s" << std::endl;
+    std::cout << "Frame Rate: " << fps << " fps, deadline " << deadlineMs << " ms" << std::endl;
+    std::cout << "Encoder Model: " << (encoderTiming ? "ON" : "OFF");
+    if (encoderTiming) {
+        std::cout << " (I/P/B " << encodeIMs << "/" << encodePMs << "/" << encodeBMs << " ms, decode " << decodeMs
+                  << " ms)";
+    }
+    std::cout << ", " << slices << " slice(s)/frame" << std::endl;
+    std::cout << "Transmission Order: " << (decodeOrder ? "decode" : "display") << std::endl;
+    std::cout << "BSS: " << numBss << " x " << stasPerBss << " STA (" << channelPlan << ")" << std::endl;
+    std::cout << "Background Load: " << bgLoadMbps << " Mbps/BSS from " << bgStart << " s" << std::endl;
+    std::cout << "Congestion Control: " << (enableCc ? "ON" : "OFF");
+    if (enableCc) {
+        std::cout << " (" << ccMinRateMbps << "-" << ccMaxRateMbps << " Mbps, feedback " << ccFeedbackMs << " ms)";
+    }
+    std::cout << std::endl;
+    std::cout << "Cross Traffic: " << crossConfig.tcpFlows << " TCP, " << crossConfig.voipFlows << " VoIP, "
+              << crossConfig.webFlows << " web, " << crossConfig.uplinkFlows << " uplink per BSS ("
+              << crossStasPerBss << " extra STAs)" << std::endl;
+    std::cout << "MLO: " << (enableMlo ? "ON (" + steering + ")" : "OFF") << std::endl;
+    std::cout << "DL OFDMA Scheduler: " << muScheduler << std::endl;
+    std::cout << "Multicast: " << (multicast ? mcastMode + " to " + std::to_string(stasPerBss) + " STA(s)" : "OFF");
+    if (multicast && mcastMode == "legacy") {
+        std::cout << " at " << (mcastRate.empty() ? "basic rate" : mcastRate);
+    }
+    std::cout << std::endl;
+    std::cout << "TWT: ";
+    if (twtScheduler) {
+        std::cout << "SP " << twtDurationMs << " ms every " << twtInterval << " frame(s) ("
+                  << twtScheduler->GetInterval().GetSeconds() * 1000.0 << " ms), offset " << twtOffsetMs
+                  << " ms, " << twtScheduler->GetServicePeriods() << " SPs shared by all STAs" << std::endl;
+    } else {
+        std::cout << "OFF (always awake)" << std::endl;
+    }
+    std::cout << "WAN: ";
+    if (wan) {
+        std::cout << wanRateMbps << " Mbps, " << wanDelayMs << " ms (+" << wanJitterMs << " ms jitter), loss "
+                  << wanLoss * 100.0 << "% (burst " << wanBurst << "), " << wanQdisc << " " << wanQueue
+                  << (wanEcn ? ", ECN" : "") << std::endl;
+    } else {
+        std::cout << "OFF (1 Gbps, 1 ms)" << std::endl;
+    }
+    std::cout << "Wi-Fi Link: " << (replayModel ? "replay of " + replayLog : "full stack") << std::endl;
+    std::cout << "Frame Source: " << (bitstream.empty() ? "synthetic" : bitstream) << std::endl;
+    std::cout << "SVC Layers: " << svcLayers
+              << (layerDrop ? " (AP layer shedding, MAC queue " + std::to_string(layerMacQueue) + "p)" : "") << std::endl;
+    std::cout << "Wall Clock: " << wallClock << " s, Events: " << eventCount << std::endl;
     std::cout << "================================\n" << std::endl;
 
 
@@ -0,0 +1,142 @@
+#include "wan-link.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/net-device-queue-interface.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("WanLink");
+
+NS_OBJECT_ENSURE_REGISTERED(WanChannel);
+NS_OBJECT_ENSURE_REGISTERED(GilbertElliottErrorModel);
+
+TypeId WanChannel::GetTypeId() {
+    static TypeId tid = TypeId("ns3::WanChannel")
+        .SetParent<PointToPointChannel>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<WanChannel>()
+        .AddAttribute("Jitter",
+                      "Maximum extra propagation delay per packet (uniform, order preserving)",
+                      TimeValue(Seconds(0)),
+                      MakeTimeAccessor(&WanChannel::m_jitter),
+                      MakeTimeChecker());
+    return tid;
+}
+
+WanChannel::WanChannel() {
+    m_uniform = CreateObject<UniformRandomVariable>();
+}
+
+int64_t WanChannel::AssignStreams(int64_t stream) {
+    m_uniform->SetStream(stream);
+    return 1;
+}
+
+bool WanChannel::TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime) {
+    NS_ASSERT_MSG(IsInitialized(), "WanChannel::TransmitStart(): Channel not initialized");
+    uint32_t wire = (src == GetSource(0)) ? 0 : 1;
+    Ptr<PointToPointNetDevice> dst = GetDestination(wire);
+
+    Time arrival = Simulator::Now() + txTime + GetDelay();
+    if (m_jitter.IsStrictlyPositive()) {
+        arrival += NanoSeconds(static_cast<int64_t>(m_uniform->GetValue(0.0, m_jitter.GetNanoSeconds())));
+    }
+    arrival = std::max(arrival, m_lastArrival[wire]);
+    m_lastArrival[wire] = arrival;
+
+    Simulator::ScheduleWithContext(dst->GetNode()->GetId(), arrival - Simulator::Now(),
+                                   &PointToPointNetDevice::Receive, dst, p->Copy());
+    return true;
+}
+
+TypeId GilbertElliottErrorModel::GetTypeId() {
+    static TypeId tid = TypeId("ns3::GilbertElliottErrorModel")
+        .SetParent<ErrorModel>()
+        .SetGroupName("VideoFrame")
+        .AddConstructor<GilbertElliottErrorModel>()
+        .AddAttribute("PGoodToBad",
+                      "Per-packet transition probability from the good to the bad state",
+                      DoubleValue(0.0),
+                      MakeDoubleAccessor(&GilbertElliottErrorModel::m_pGoodToBad),
+                      MakeDoubleChecker<double>(0.0, 1.0))
+        .AddAttribute("PBadToGood",
+                      "Per-packet transition probability from the bad to the good state",
+                      DoubleValue(1.0),
+                      MakeDoubleAccessor(&GilbertElliottErrorModel::m_pBadToGood),
+                      MakeDoubleChecker<double>(0.0, 1.0))
+        .AddAttribute("LossGood",
+                      "Loss probability in the good state",
+                      DoubleValue(0.0),
+                      MakeDoubleAccessor(&GilbertElliottErrorModel::m_lossGood),
+                      MakeDoubleChecker<double>(0.0, 1.0))
+        .AddAttribute("LossBad",
+                      "Loss probability in the bad state",
+                      DoubleValue(1.0),
+                      MakeDoubleAccessor(&GilbertElliottErrorModel::m_lossBad),
+                      MakeDoubleChecker<double>(0.0, 1.0));
+    return tid;
+}
+
+GilbertElliottErrorModel::GilbertElliottErrorModel()
+    : m_pGoodToBad(0.0), m_pBadToGood(1.0), m_lossGood(0.0), m_lossBad(1.0), m_bad(false) {
+    m_uniform = CreateObject<UniformRandomVariable>();
+}
+
+int64_t GilbertElliottErrorModel::AssignStreams(int64_t stream) {
+    m_uniform->SetStream(stream);
+    return 1;
+}
+
+// r = 1/平均バースト長, p = 損失率·r/(1 − 損失率)
+void GilbertElliottErrorModel::SetGilbert(double lossRate, double meanBurst) {
+    NS_ABORT_MSG_IF(lossRate < 0.0 || lossRate >= 1.0, "lossRate must be in [0, 1)");
+    NS_ABORT_MSG_IF(meanBurst < 1.0, "meanBurst must be at least 1 packet");
+    m_pBadToGood = 1.0 / meanBurst;
+    m_pGoodToBad = std::min(lossRate * m_pBadToGood / (1.0 - lossRate), 1.0);
+    m_lossGood = 0.0;
+    m_lossBad = 1.0;
+}
+
+bool GilbertElliottErrorModel::DoCorrupt(Ptr<Packet> p) {
+    if (m_bad) {
+        m_bad = m_uniform->GetValue() >= m_pBadToGood;
+    } else {
+        m_bad = m_uniform->GetValue() < m_pGoodToBad;
+    }
+    return m_uniform->GetValue() < (m_bad ? m_lossBad : m_lossGood);
+}
+
+void GilbertElliottErrorModel::DoReset() {
+    m_bad = false;
+}
+
+NetDeviceContainer InstallWanLink(Ptr<Node> server, Ptr<Node> ap, DataRate rate, Time delay, Time jitter,
+                                  Ptr<ErrorModel> downlinkLoss, int64_t stream) {
+    Ptr<WanChannel> channel = CreateObjectWithAttributes<WanChannel>("Delay", TimeValue(delay),
+                                                                     "Jitter", TimeValue(jitter));
+    channel->AssignStreams(stream);
+
+    NetDeviceContainer devices;
+    for (Ptr<Node> node : {server, ap}) {
+        Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice>();
+        device->SetAddress(Mac48Address::Allocate());
+        device->SetDataRate(rate);
+        node->AddDevice(device);
+        Ptr<Queue<Packet>> queue =
+            CreateObjectWithAttributes<DropTailQueue<Packet>>("MaxSize", QueueSizeValue(QueueSize("1p")));
+        device->SetQueue(queue);
+        // キューディスクがデバイスキューの空きを待てるようにフロー制御を有効化
+        Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface>();
+        ndqi->GetTxQueue(0)->ConnectQueueTraces(queue);
+        device->AggregateObject(ndqi);
+        device->Attach(channel);
+        devices.Add(device);
+    }
+    if (downlinkLoss) {
+        DynamicCast<PointToPointNetDevice>(devices.Get(1))->SetReceiveErrorModel(downlinkLoss);
+    }
+    return devices;
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef WAN_LINK_H
+#define WAN_LINK_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-net-device.h"
+
+namespace ns3 {
+
+// WanChannel: 伝搬遅延に一様分布 [0, Jitter] の揺らぎを加える p2p チャネル
+// 方向ごとに到着順を保つ（揺らぎで追い越さない）ので、アクセス網の遅延変動を並べ替えなしで再現する。
+class WanChannel : public PointToPointChannel {
+public:
+    static TypeId GetTypeId();
+    WanChannel();
+
+    int64_t AssignStreams(int64_t stream);
+
+    bool TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime) override;
+
+private:
+    Time m_jitter;
+    Time m_lastArrival[2];  // 方向ごとの直前の到着時刻
+    Ptr<UniformRandomVariable> m_uniform;
+};
+
+// GilbertElliottErrorModel: 良好・不良の 2 状態マルコフ連鎖によるバースト損失モデル
+// パケットごとに状態を遷移させ、その状態の損失確率で損失させる。
+// LossGood = 0, LossBad = 1 なら Gilbert モデル（平均損失率 p/(p+r)、平均バースト長 1/r）。
+class GilbertElliottErrorModel : public ErrorModel {
+public:
+    static TypeId GetTypeId();
+    GilbertElliottErrorModel();
+
+    int64_t AssignStreams(int64_t stream);
+
+    // 平均損失率と平均バースト長（パケット）から Gilbert モデルの遷移確率を決める
+    void SetGilbert(double lossRate, double meanBurst);
+
+private:
+    bool DoCorrupt(Ptr<Packet> p) override;
+    void DoReset() override;
+
+    double m_pGoodToBad;
+    double m_pBadToGood;
+    double m_lossGood;
+    double m_lossBad;
+    bool m_bad;
+    Ptr<UniformRandomVariable> m_uniform;
+};
+
+// サーバーと AP を WAN 区間（ボトルネックレート・伝搬遅延・揺らぎ）でつなぎ、AP 側の受信に損失モデルを付ける
+// デバイスキューは 1 パケットにして、待ち行列はデバイスに設置するキューディスク側に溜まるようにする。
+NetDeviceContainer InstallWanLink(Ptr<Node> server, Ptr<Node> ap, DataRate rate, Time delay, Time jitter,
+                                  Ptr<ErrorModel> downlinkLoss, int64_t stream);
+
+}
+
+#endif // WAN_LINK_H